@@ -62,16 +62,16 @@ inline int32_t to_big_endian(int32_t i32) {
 #endif
 }
 
-void aiger_encode(std::ostream &f, int x)
+void aiger_encode(std::string &buf, int x)
 {
 	log_assert(x >= 0);
 
 	while (x & ~0x7f) {
-		f.put((x & 0x7f) | 0x80);
+		buf += char((x & 0x7f) | 0x80);
 		x = x >> 7;
 	}
 
-	f.put(x);
+	buf += char(x);
 }
 
 struct XAigerWriter
@@ -116,11 +116,13 @@ struct XAigerWriter
 		//     since this function is called recursively
 
 		int a = -1;
-		if (not_map.count(bit)) {
-			a = bit2aig(not_map.at(bit)) ^ 1;
+		auto not_it = not_map.find(bit);
+		auto and_it = and_map.find(bit);
+		if (not_it != not_map.end()) {
+			a = bit2aig(not_it->second) ^ 1;
 		} else
-		if (and_map.count(bit)) {
-			auto args = and_map.at(bit);
+		if (and_it != and_map.end()) {
+			auto args = and_it->second;
 			int a0 = bit2aig(args.first);
 			int a1 = bit2aig(args.second);
 			a = mkgate(a0, a1);
@@ -520,15 +522,19 @@ struct XAigerWriter
 			for (int i = aig_obcj; i < aig_obcjf; i++)
 				f << stringf("%d\n", aig_outputs.at(i));
 
+			// Encode all AND gates into one buffer and write it in one go
+			std::string buf;
+			buf.reserve(4 * aig_a);
 			for (int i = 0; i < aig_a; i++) {
 				int lhs = 2*(aig_i+aig_l+i)+2;
 				int rhs0 = aig_gates.at(i).first;
 				int rhs1 = aig_gates.at(i).second;
 				int delta0 = lhs - rhs0;
 				int delta1 = rhs0 - rhs1;
-				aiger_encode(f, delta0);
-				aiger_encode(f, delta1);
+				aiger_encode(buf, delta0);
+				aiger_encode(buf, delta1);
 			}
+			f.write(buf.data(), buf.size());
 		}
 
 		f << "c";
@@ -28,6 +28,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cassert>
 #include <limits>
 #include <type_traits>
@@ -36,6 +37,7 @@
 #include <map>
 #include <algorithm>
 #include <memory>
+#include <new>
 #include <functional>
 #include <sstream>
 
@@ -758,10 +760,27 @@ std::ostream &operator<<(std::ostream &os, const wire<Bits> &val) {
 
 template<size_t Width>
 struct memory {
+	// The storage is allocated with calloc() instead of being value-initialized with new[], so that
+	// the zero pages of a large memory are provided lazily by the operating system, and only the parts
+	// that are actually written to take up physical memory. An all-zero value is the same as
+	// a default-constructed one.
+	struct storage_deleter {
+		void operator()(value<Width> *ptr) const {
+			std::free(ptr);
+		}
+	};
+
+	static value<Width> *allocate(size_t depth) {
+		void *ptr = std::calloc(depth, sizeof(value<Width>));
+		if (ptr == nullptr && depth != 0)
+			throw std::bad_alloc();
+		return static_cast<value<Width>*>(ptr);
+	}
+
 	const size_t depth;
-	std::unique_ptr<value<Width>[]> data;
+	std::unique_ptr<value<Width>[], storage_deleter> data;
 
-	explicit memory(size_t depth) : depth(depth), data(new value<Width>[depth]) {}
+	explicit memory(size_t depth) : depth(depth), data(allocate(depth)) {}
 
 	memory(const memory<Width> &) = delete;
 	memory<Width> &operator=(const memory<Width> &) = delete;
@@ -787,6 +806,18 @@ struct memory {
 		return data[index];
 	}
 
+	// Bulk transfers of `count` elements starting at `index`. Like direct memory writes, `load` may only
+	// be used before the simulation is started.
+	void load(size_t index, const value<Width> *values, size_t count) {
+		assert(index <= depth && count <= depth - index);
+		std::copy(values, values + count, &data[index]);
+	}
+
+	void dump(size_t index, value<Width> *values, size_t count) const {
+		assert(index <= depth && count <= depth - index);
+		std::copy(&data[index], &data[index] + count, values);
+	}
+
 	// A simple way to make a writable memory would be to use an array of wires instead of an array of values.
 	// However, there are two significant downsides to this approach: first, it has large overhead (2× space
 	// overhead, and O(depth) time overhead during commit); second, it does not simplify handling write port
@@ -819,10 +850,10 @@ struct memory {
 	bool commit() {
 		bool changed = false;
 		for (const write &entry : write_queue) {
-			value<Width> elem = data[entry.index];
-			elem = elem.update(entry.val, entry.mask);
-			changed |= (data[entry.index] != elem);
-			data[entry.index] = elem;
+			value<Width> &elem = data[entry.index];
+			value<Width> next = elem.update(entry.val, entry.mask);
+			changed |= (elem != next);
+			elem = next;
 		}
 		write_queue.clear();
 		return changed;
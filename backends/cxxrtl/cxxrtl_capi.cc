@@ -87,6 +87,20 @@ void cxxrtl_enum(cxxrtl_handle handle, void *data,
 		callback(data, it.first.c_str(), static_cast<cxxrtl_object*>(&it.second[0]), it.second.size());
 }
 
+void cxxrtl_memory_load(cxxrtl_object *object, size_t index, const uint32_t *chunks, size_t count) {
+	assert(object->type == CXXRTL_MEMORY);
+	assert(index <= object->depth && count <= object->depth - index);
+	size_t stride = (object->width + 31) / 32;
+	std::copy(chunks, chunks + stride * count, object->curr + stride * index);
+}
+
+void cxxrtl_memory_dump(const cxxrtl_object *object, size_t index, uint32_t *chunks, size_t count) {
+	assert(object->type == CXXRTL_MEMORY);
+	assert(index <= object->depth && count <= object->depth - index);
+	size_t stride = (object->width + 31) / 32;
+	std::copy(object->curr + stride * index, object->curr + stride * (index + count), chunks);
+}
+
 void cxxrtl_outline_eval(cxxrtl_outline outline) {
 	outline->eval();
 }
@@ -290,6 +290,23 @@ void cxxrtl_enum(cxxrtl_handle handle, void *data,
                  void (*callback)(void *data, const char *name,
                                   struct cxxrtl_object *object, size_t parts));
 
+// Copy elements into a memory.
+//
+// Copies `count` elements, starting at the element with index `index` (counted from the first
+// element, regardless of `zero_at`), from `chunks`, which must contain `((width + 31) / 32) * count`
+// chunks laid out the same way as `curr`. This is equivalent to, but much faster than, writing
+// the elements one by one through `curr`, and is subject to the same restrictions. In particular,
+// loading a large image from a file mapped with `mmap()` only touches the pages that are copied.
+//
+// The object must be of type `CXXRTL_MEMORY`, and the range must be within its depth.
+void cxxrtl_memory_load(struct cxxrtl_object *object, size_t index, const uint32_t *chunks, size_t count);
+
+// Copy elements out of a memory.
+//
+// The counterpart of `cxxrtl_memory_load`; copies `count` elements starting at `index` into
+// `chunks`.
+void cxxrtl_memory_dump(const struct cxxrtl_object *object, size_t index, uint32_t *chunks, size_t count);
+
 // Opaque reference to an outline.
 //
 // An outline is a group of outline objects that are evaluated simultaneously. The identity of
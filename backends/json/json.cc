@@ -40,64 +40,114 @@ struct JsonWriter
 
 	SigMap sigmap;
 	int sigidcounter;
-	dict<SigBit, string> sigids;
+	dict<SigBit, int> sigids;
 	pool<Aig> aig_models;
 
+	// The output is assembled in this buffer and handed to the stream in
+	// large chunks, which avoids the overhead of many small stream writes
+	// and of formatting every token with stringf().
+	string buf;
+	static const size_t buf_flush_size = 1 << 20;
+
 	JsonWriter(std::ostream &f, bool use_selection, bool aig_mode, bool compat_int_mode) :
 			f(f), use_selection(use_selection), aig_mode(aig_mode),
-			compat_int_mode(compat_int_mode) { }
+			compat_int_mode(compat_int_mode)
+	{
+		buf.reserve(buf_flush_size + 4096);
+	}
+
+	~JsonWriter()
+	{
+		flush();
+	}
 
-	string get_string(string str)
+	void flush()
 	{
-		string newstr = "\"";
-		for (char c : str) {
+		f.write(buf.data(), buf.size());
+		buf.clear();
+	}
+
+	void maybe_flush()
+	{
+		if (buf.size() >= buf_flush_size)
+			flush();
+	}
+
+	void write_int(int value)
+	{
+		char str[16];
+		char *p = str + sizeof(str);
+		unsigned int v = value < 0 ? -(unsigned int)value : value;
+		do {
+			*--p = '0' + v % 10;
+			v /= 10;
+		} while (v);
+		if (value < 0)
+			*--p = '-';
+		buf.append(p, str + sizeof(str) - p);
+	}
+
+	void write_string(const char *str, size_t len)
+	{
+		buf += '"';
+		for (const char *end = str + len; str != end; str++) {
+			char c = *str;
 			if (c == '\\')
-				newstr += "\\\\";
+				buf += "\\\\";
 			else if (c == '"')
-				newstr += "\\\"";
+				buf += "\\\"";
 			else if (c == '\b')
-				newstr += "\\b";
+				buf += "\\b";
 			else if (c == '\f')
-				newstr += "\\f";
+				buf += "\\f";
 			else if (c == '\n')
-				newstr += "\\n";
+				buf += "\\n";
 			else if (c == '\r')
-				newstr += "\\r";
+				buf += "\\r";
 			else if (c == '\t')
-				newstr += "\\t";
+				buf += "\\t";
 			else if (c < 0x20)
-				newstr += stringf("\\u%04X", c);
+				buf += stringf("\\u%04X", c);
 			else
-				newstr += c;
+				buf += c;
 		}
-		return newstr + "\"";
+		buf += '"';
+	}
+
+	void write_string(const string &str)
+	{
+		write_string(str.data(), str.size());
 	}
 
-	string get_name(IdString name)
+	// Same as write_string(RTLIL::unescape_id(name)), without the temporary string
+	void write_name(const IdString &name)
 	{
-		return get_string(RTLIL::unescape_id(name));
+		const char *str = name.c_str();
+		if (str[0] == '\\' && str[1] != 0 && str[1] != '$' && str[1] != '\\' && !(str[1] >= '0' && str[1] <= '9'))
+			str++;
+		write_string(str, strlen(str));
 	}
 
-	string get_bits(SigSpec sig)
+	void write_bits(const SigSpec &sig)
 	{
 		bool first = true;
-		string str = "[";
+		buf += '[';
 		for (auto bit : sigmap(sig)) {
-			str += first ? " " : ", ";
+			buf += first ? " " : ", ";
 			first = false;
-			if (sigids.count(bit) == 0) {
-				string &s = sigids[bit];
-				if (bit.wire == nullptr) {
-					if (bit == State::S0) s = "\"0\"";
-					else if (bit == State::S1) s = "\"1\"";
-					else if (bit == State::Sz) s = "\"z\"";
-					else s = "\"x\"";
-				} else
-					s = stringf("%d", sigidcounter++);
+			if (bit.wire == nullptr) {
+				if (bit == State::S0) buf += "\"0\"";
+				else if (bit == State::S1) buf += "\"1\"";
+				else if (bit == State::Sz) buf += "\"z\"";
+				else buf += "\"x\"";
+				continue;
 			}
-			str += sigids[bit];
+			auto it = sigids.find(bit);
+			if (it == sigids.end())
+				it = sigids.emplace(bit, sigidcounter++).first;
+			write_int(it->second);
 		}
-		return str + " ]";
+		buf += " ]";
 	}
 
 	void write_parameter_value(const Const &value)
@@ -118,14 +168,14 @@ struct JsonWriter
 			}
 			if (state < 2)
 				str += " ";
-			f << get_string(str);
+			write_string(str);
 		} else if (compat_int_mode && GetSize(value) <= 32 && value.is_fully_def()) {
 			if ((value.flags & RTLIL::ConstFlags::CONST_FLAG_SIGNED) != 0)
-				f << stringf("%d", value.as_int());
+				write_int(value.as_int());
 			else
-				f << stringf("%u", value.as_int());
+				buf += stringf("%u", value.as_int());
 		} else {
-			f << get_string(value.as_string());
+			write_string(value.as_string());
 		}
 	}
 
@@ -133,8 +183,10 @@ struct JsonWriter
 	{
 		bool first = true;
 		for (auto &param : parameters) {
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s%s: ", for_module ? "" : "    ", get_name(param.first).c_str());
+			buf += first ? "\n" : ",\n";
+			buf += for_module ? "        " : "            ";
+			write_name(param.first);
+			buf += ": ";
 			write_parameter_value(param.second);
 			first = false;
 		}
@@ -154,132 +206,179 @@ struct JsonWriter
 			log_error("Module %s contains processes, which are not supported by JSON backend (run `proc` first).\n", log_id(module));
 		}
 
-		f << stringf("    %s: {\n", get_name(module->name).c_str());
+		buf += "    ";
+		write_name(module->name);
+		buf += ": {\n";
 
-		f << stringf("      \"attributes\": {");
+		buf += "      \"attributes\": {";
 		write_parameters(module->attributes, /*for_module=*/true);
-		f << stringf("\n      },\n");
+		buf += "\n      },\n";
 
 		if (module->parameter_default_values.size()) {
-			f << stringf("      \"parameter_default_values\": {");
+			buf += "      \"parameter_default_values\": {";
 			write_parameters(module->parameter_default_values, /*for_module=*/true);
-			f << stringf("\n      },\n");
+			buf += "\n      },\n";
 		}
 
-		f << stringf("      \"ports\": {");
+		buf += "      \"ports\": {";
 		bool first = true;
-		for (auto n : module->ports) {
+		for (auto &n : module->ports) {
 			Wire *w = module->wire(n);
 			if (use_selection && !module->selected(w))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(n).c_str());
-			f << stringf("          \"direction\": \"%s\",\n", w->port_input ? w->port_output ? "inout" : "input" : "output");
-			if (w->start_offset)
-				f << stringf("          \"offset\": %d,\n", w->start_offset);
+			buf += first ? "\n" : ",\n";
+			buf += "        ";
+			write_name(n);
+			buf += ": {\n";
+			buf += "          \"direction\": \"";
+			buf += w->port_input ? w->port_output ? "inout" : "input" : "output";
+			buf += "\",\n";
+			if (w->start_offset) {
+				buf += "          \"offset\": ";
+				write_int(w->start_offset);
+				buf += ",\n";
+			}
 			if (w->upto)
-				f << stringf("          \"upto\": 1,\n");
+				buf += "          \"upto\": 1,\n";
 			if (w->is_signed)
-				f << stringf("          \"signed\": %d,\n", w->is_signed);
-			f << stringf("          \"bits\": %s\n", get_bits(w).c_str());
-			f << stringf("        }");
+				buf += "          \"signed\": 1,\n";
+			buf += "          \"bits\": ";
+			write_bits(w);
+			buf += "\n        }";
 			first = false;
 		}
-		f << stringf("\n      },\n");
+		buf += "\n      },\n";
 
-		f << stringf("      \"cells\": {");
+		buf += "      \"cells\": {";
 		first = true;
 		for (auto c : module->cells()) {
 			if (use_selection && !module->selected(c))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(c->name).c_str());
-			f << stringf("          \"hide_name\": %s,\n", c->name[0] == '$' ? "1" : "0");
-			f << stringf("          \"type\": %s,\n", get_name(c->type).c_str());
+			buf += first ? "\n" : ",\n";
+			buf += "        ";
+			write_name(c->name);
+			buf += ": {\n";
+			buf += "          \"hide_name\": ";
+			buf += c->name[0] == '$' ? "1" : "0";
+			buf += ",\n";
+			buf += "          \"type\": ";
+			write_name(c->type);
+			buf += ",\n";
 			if (aig_mode) {
 				Aig aig(c);
 				if (!aig.name.empty()) {
-					f << stringf("          \"model\": \"%s\",\n", aig.name.c_str());
+					buf += "          \"model\": \"";
+					buf += aig.name;
+					buf += "\",\n";
 					aig_models.insert(aig);
 				}
 			}
-			f << stringf("          \"parameters\": {");
+			buf += "          \"parameters\": {";
 			write_parameters(c->parameters);
-			f << stringf("\n          },\n");
-			f << stringf("          \"attributes\": {");
+			buf += "\n          },\n";
+			buf += "          \"attributes\": {";
 			write_parameters(c->attributes);
-			f << stringf("\n          },\n");
+			buf += "\n          },\n";
 			if (c->known()) {
-				f << stringf("          \"port_directions\": {");
+				buf += "          \"port_directions\": {";
 				bool first2 = true;
 				for (auto &conn : c->connections()) {
-					string direction = "output";
+					const char *direction = "output";
 					if (c->input(conn.first))
 						direction = c->output(conn.first) ? "inout" : "input";
-					f << stringf("%s\n", first2 ? "" : ",");
-					f << stringf("            %s: \"%s\"", get_name(conn.first).c_str(), direction.c_str());
+					buf += first2 ? "\n" : ",\n";
+					buf += "            ";
+					write_name(conn.first);
+					buf += ": \"";
+					buf += direction;
+					buf += "\"";
 					first2 = false;
 				}
-				f << stringf("\n          },\n");
+				buf += "\n          },\n";
 			}
-			f << stringf("          \"connections\": {");
+			buf += "          \"connections\": {";
 			bool first2 = true;
 			for (auto &conn : c->connections()) {
-				f << stringf("%s\n", first2 ? "" : ",");
-				f << stringf("            %s: %s", get_name(conn.first).c_str(), get_bits(conn.second).c_str());
+				buf += first2 ? "\n" : ",\n";
+				buf += "            ";
+				write_name(conn.first);
+				buf += ": ";
+				write_bits(conn.second);
 				first2 = false;
 			}
-			f << stringf("\n          }\n");
-			f << stringf("        }");
+			buf += "\n          }\n";
+			buf += "        }";
 			first = false;
+			maybe_flush();
 		}
-		f << stringf("\n      },\n");
+		buf += "\n      },\n";
 
 		if (!module->memories.empty()) {
-			f << stringf("      \"memories\": {");
+			buf += "      \"memories\": {";
 			first = true;
 			for (auto &it : module->memories) {
 				if (use_selection && !module->selected(it.second))
 					continue;
-				f << stringf("%s\n", first ? "" : ",");
-				f << stringf("        %s: {\n", get_name(it.second->name).c_str());
-				f << stringf("          \"hide_name\": %s,\n", it.second->name[0] == '$' ? "1" : "0");
-				f << stringf("          \"attributes\": {");
+				buf += first ? "\n" : ",\n";
+				buf += "        ";
+				write_name(it.second->name);
+				buf += ": {\n";
+				buf += "          \"hide_name\": ";
+				buf += it.second->name[0] == '$' ? "1" : "0";
+				buf += ",\n";
+				buf += "          \"attributes\": {";
 				write_parameters(it.second->attributes);
-				f << stringf("\n          },\n");
-				f << stringf("          \"width\": %d,\n", it.second->width);
-				f << stringf("          \"start_offset\": %d,\n", it.second->start_offset);
-				f << stringf("          \"size\": %d\n", it.second->size);
-				f << stringf("        }");
+				buf += "\n          },\n";
+				buf += "          \"width\": ";
+				write_int(it.second->width);
+				buf += ",\n";
+				buf += "          \"start_offset\": ";
+				write_int(it.second->start_offset);
+				buf += ",\n";
+				buf += "          \"size\": ";
+				write_int(it.second->size);
+				buf += "\n";
+				buf += "        }";
 				first = false;
+				maybe_flush();
 			}
-			f << stringf("\n      },\n");
+			buf += "\n      },\n";
 		}
 
-		f << stringf("      \"netnames\": {");
+		buf += "      \"netnames\": {";
 		first = true;
 		for (auto w : module->wires()) {
 			if (use_selection && !module->selected(w))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(w->name).c_str());
-			f << stringf("          \"hide_name\": %s,\n", w->name[0] == '$' ? "1" : "0");
-			f << stringf("          \"bits\": %s,\n", get_bits(w).c_str());
-			if (w->start_offset)
-				f << stringf("          \"offset\": %d,\n", w->start_offset);
+			buf += first ? "\n" : ",\n";
+			buf += "        ";
+			write_name(w->name);
+			buf += ": {\n";
+			buf += "          \"hide_name\": ";
+			buf += w->name[0] == '$' ? "1" : "0";
+			buf += ",\n";
+			buf += "          \"bits\": ";
+			write_bits(w);
+			buf += ",\n";
+			if (w->start_offset) {
+				buf += "          \"offset\": ";
+				write_int(w->start_offset);
+				buf += ",\n";
+			}
 			if (w->upto)
-				f << stringf("          \"upto\": 1,\n");
+				buf += "          \"upto\": 1,\n";
 			if (w->is_signed)
-				f << stringf("          \"signed\": %d,\n", w->is_signed);
-			f << stringf("          \"attributes\": {");
+				buf += "          \"signed\": 1,\n";
+			buf += "          \"attributes\": {";
 			write_parameters(w->attributes);
-			f << stringf("\n          }\n");
-			f << stringf("        }");
+			buf += "\n          }\n";
+			buf += "        }";
 			first = false;
+			maybe_flush();
 		}
-		f << stringf("\n      }\n");
+		buf += "\n      }\n";
 
-		f << stringf("    }");
+		buf += "    }";
 	}
 
 	void write_design(Design *design_)
@@ -287,48 +386,51 @@ struct JsonWriter
 		design = design_;
 		design->sort();
 
-		f << stringf("{\n");
-		f << stringf("  \"creator\": %s,\n", get_string(yosys_version_str).c_str());
-		f << stringf("  \"modules\": {\n");
+		buf += "{\n";
+		buf += "  \"creator\": ";
+		write_string(yosys_version_str);
+		buf += ",\n";
+		buf += "  \"modules\": {\n";
 		vector<Module*> modules = use_selection ? design->selected_modules() : design->modules();
 		bool first_module = true;
 		for (auto mod : modules) {
 			if (!first_module)
-				f << stringf(",\n");
+				buf += ",\n";
 			write_module(mod);
 			first_module = false;
 		}
-		f << stringf("\n  }");
+		buf += "\n  }";
 		if (!aig_models.empty()) {
-			f << stringf(",\n  \"models\": {\n");
+			buf += ",\n  \"models\": {\n";
 			bool first_model = true;
 			for (auto &aig : aig_models) {
 				if (!first_model)
-					f << stringf(",\n");
-				f << stringf("    \"%s\": [\n", aig.name.c_str());
+					buf += ",\n";
+				buf += stringf("    \"%s\": [\n", aig.name.c_str());
 				int node_idx = 0;
 				for (auto &node : aig.nodes) {
 					if (node_idx != 0)
-						f << stringf(",\n");
-					f << stringf("      /* %3d */ [ ", node_idx);
+						buf += ",\n";
+					buf += stringf("      /* %3d */ [ ", node_idx);
 					if (node.portbit >= 0)
-						f << stringf("\"%sport\", \"%s\", %d", node.inverter ? "n" : "",
+						buf += stringf("\"%sport\", \"%s\", %d", node.inverter ? "n" : "",
 								log_id(node.portname), node.portbit);
 					else if (node.left_parent < 0 && node.right_parent < 0)
-						f << stringf("\"%s\"", node.inverter ? "true" : "false");
+						buf += stringf("\"%s\"", node.inverter ? "true" : "false");
 					else
-						f << stringf("\"%s\", %d, %d", node.inverter ? "nand" : "and", node.left_parent, node.right_parent);
+						buf += stringf("\"%s\", %d, %d", node.inverter ? "nand" : "and", node.left_parent, node.right_parent);
 					for (auto &op : node.outports)
-						f << stringf(", \"%s\", %d", log_id(op.first), op.second);
-					f << stringf(" ]");
+						buf += stringf(", \"%s\", %d", log_id(op.first), op.second);
+					buf += " ]";
 					node_idx++;
 				}
-				f << stringf("\n    ]");
+				buf += "\n    ]";
 				first_model = false;
 			}
-			f << stringf("\n  }");
+			buf += "\n  }";
 		}
-		f << stringf("\n}\n");
+		buf += "\n}\n";
+		flush();
 	}
 };
 
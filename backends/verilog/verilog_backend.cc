@@ -101,13 +101,16 @@ std::string next_auto_id()
 	return stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + auto_name_counter++);
 }
 
-std::string id(RTLIL::IdString internal_id, bool may_rename = true)
+std::string id(const RTLIL::IdString &internal_id, bool may_rename = true)
 {
 	const char *str = internal_id.c_str();
 	bool do_escape = false;
 
-	if (may_rename && auto_name_map.count(internal_id) != 0)
-		return stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + auto_name_map[internal_id]);
+	if (may_rename) {
+		auto it = auto_name_map.find(internal_id);
+		if (it != auto_name_map.end())
+			return stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + it->second);
+	}
 
 	if (*str == '\\')
 		str++;
@@ -129,7 +132,7 @@ std::string id(RTLIL::IdString internal_id, bool may_rename = true)
 		break;
 	}
 
-	const pool<string> keywords = {
+	static const pool<string> keywords = {
 		// IEEE 1800-2017 Annex B
 		"accept_on", "alias", "always", "always_comb", "always_ff", "always_latch", "and", "assert", "assign", "assume", "automatic", "before",
 		"begin", "bind", "bins", "binsof", "bit", "break", "buf", "bufif0", "bufif1", "byte", "case", "casex", "casez", "cell", "chandle",
@@ -272,41 +275,41 @@ void dump_const(std::ostream &f, const RTLIL::Const &data, int width = -1, int o
 	dump_bin:
 			f << stringf("%d'%sb", width, set_signed ? "s" : "");
 			if (width == 0)
-				f << stringf("0");
+				f << "0";
 			for (int i = offset+width-1; i >= offset; i--) {
 				log_assert(i < (int)data.bits.size());
 				switch (data.bits[i]) {
-				case State::S0: f << stringf("0"); break;
-				case State::S1: f << stringf("1"); break;
-				case RTLIL::Sx: f << stringf("x"); break;
-				case RTLIL::Sz: f << stringf("z"); break;
-				case RTLIL::Sa: f << stringf("?"); break;
+				case State::S0: f << "0"; break;
+				case State::S1: f << "1"; break;
+				case RTLIL::Sx: f << "x"; break;
+				case RTLIL::Sz: f << "z"; break;
+				case RTLIL::Sa: f << "?"; break;
 				case RTLIL::Sm: log_error("Found marker state in final netlist.");
 				}
 			}
 		}
 	} else {
 		if ((data.flags & RTLIL::CONST_FLAG_REAL) == 0)
-			f << stringf("\"");
+			f << "\"";
 		std::string str = data.decode_string();
 		for (size_t i = 0; i < str.size(); i++) {
 			if (str[i] == '\n')
-				f << stringf("\\n");
+				f << "\\n";
 			else if (str[i] == '\t')
-				f << stringf("\\t");
+				f << "\\t";
 			else if (str[i] < 32)
 				f << stringf("\\%03o", str[i]);
 			else if (str[i] == '"')
-				f << stringf("\\\"");
+				f << "\\\"";
 			else if (str[i] == '\\')
-				f << stringf("\\\\");
+				f << "\\\\";
 			else if (str[i] == '/' && escape_comment && i > 0 && str[i-1] == '*')
-				f << stringf("\\/");
+				f << "\\/";
 			else
 				f << str[i];
 		}
 		if ((data.flags & RTLIL::CONST_FLAG_REAL) == 0)
-			f << stringf("\"");
+			f << "\"";
 	}
 }
 
@@ -335,22 +338,21 @@ void dump_sigchunk(std::ostream &f, const RTLIL::SigChunk &chunk, bool no_decima
 	if (chunk.wire == NULL) {
 		dump_const(f, chunk.data, chunk.width, chunk.offset, no_decimal);
 	} else {
-		if (chunk.width == chunk.wire->width && chunk.offset == 0) {
-			f << stringf("%s", id(chunk.wire->name).c_str());
-		} else if (chunk.width == 1) {
+		f << id(chunk.wire->name);
+		if (chunk.width == chunk.wire->width && chunk.offset == 0)
+			return;
+		if (chunk.width == 1) {
 			if (chunk.wire->upto)
-				f << stringf("%s[%d]", id(chunk.wire->name).c_str(), (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset);
+				f << '[' << (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset << ']';
 			else
-				f << stringf("%s[%d]", id(chunk.wire->name).c_str(), chunk.offset + chunk.wire->start_offset);
+				f << '[' << chunk.offset + chunk.wire->start_offset << ']';
 		} else {
 			if (chunk.wire->upto)
-				f << stringf("%s[%d:%d]", id(chunk.wire->name).c_str(),
-						(chunk.wire->width - (chunk.offset + chunk.width - 1) - 1) + chunk.wire->start_offset,
-						(chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset);
+				f << '[' << (chunk.wire->width - (chunk.offset + chunk.width - 1) - 1) + chunk.wire->start_offset
+						<< ':' << (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset << ']';
 			else
-				f << stringf("%s[%d:%d]", id(chunk.wire->name).c_str(),
-						(chunk.offset + chunk.width - 1) + chunk.wire->start_offset,
-						chunk.offset + chunk.wire->start_offset);
+				f << '[' << (chunk.offset + chunk.width - 1) + chunk.wire->start_offset
+						<< ':' << chunk.offset + chunk.wire->start_offset << ']';
 		}
 	}
 }
@@ -365,17 +367,17 @@ void dump_sigspec(std::ostream &f, const RTLIL::SigSpec &sig)
 	if (sig.is_chunk()) {
 		dump_sigchunk(f, sig.as_chunk());
 	} else {
-		f << stringf("{ ");
+		f << "{ ";
 		for (auto it = sig.chunks().rbegin(); it != sig.chunks().rend(); ++it) {
 			if (it != sig.chunks().rbegin())
-				f << stringf(", ");
+				f << ", ";
 			dump_sigchunk(f, *it, true);
 		}
-		f << stringf(" }");
+		f << " }";
 	}
 }
 
-void dump_attributes(std::ostream &f, std::string indent, dict<RTLIL::IdString, RTLIL::Const> &attributes, char term = '\n', bool modattr = false, bool regattr = false, bool as_comment = false)
+void dump_attributes(std::ostream &f, const std::string &indent, dict<RTLIL::IdString, RTLIL::Const> &attributes, char term = '\n', bool modattr = false, bool regattr = false, bool as_comment = false)
 {
 	if (noattr)
 		return;
@@ -384,18 +386,18 @@ void dump_attributes(std::ostream &f, std::string indent, dict<RTLIL::IdString,
 	for (auto it = attributes.begin(); it != attributes.end(); ++it) {
 		if (it->first == ID::init && regattr) continue;
 		f << stringf("%s" "%s %s", indent.c_str(), as_comment ? "/*" : "(*", id(it->first).c_str());
-		f << stringf(" = ");
+		f << " = ";
 		if (modattr && (it->second == State::S0 || it->second == Const(0)))
-			f << stringf(" 0 ");
+			f << " 0 ";
 		else if (modattr && (it->second == State::S1 || it->second == Const(1)))
-			f << stringf(" 1 ");
+			f << " 1 ";
 		else
 			dump_const(f, it->second, -1, 0, false, as_comment);
 		f << stringf(" %s%c", as_comment ? "*/" : "*)", term);
 	}
 }
 
-void dump_wire(std::ostream &f, std::string indent, RTLIL::Wire *wire)
+void dump_wire(std::ostream &f, const std::string &indent, RTLIL::Wire *wire)
 {
 	dump_attributes(f, indent, wire->attributes, '\n', /*modattr=*/false, /*regattr=*/reg_wires.count(wire->name));
 #if 0
@@ -428,10 +430,10 @@ void dump_wire(std::ostream &f, std::string indent, RTLIL::Wire *wire)
 	if (reg_wires.count(wire->name)) {
 		f << stringf("%s" "reg%s %s", indent.c_str(), range.c_str(), id(wire->name).c_str());
 		if (wire->attributes.count(ID::init)) {
-			f << stringf(" = ");
+			f << " = ";
 			dump_const(f, wire->attributes.at(ID::init));
 		}
-		f << stringf(";\n");
+		f << ";\n";
 	} else
 		f << stringf("%s" "wire%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
 #endif
@@ -522,7 +524,7 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 							f << stringf("%s" "  %s[%d][%d:%d] = ", indent.c_str(), mem_id.c_str(), i + start, j, start_j);
 						}
 						dump_const(f, init.data.extract(i*mem.width+start_j, width));
-						f << stringf(";\n");
+						f << ";\n";
 					}
 				}
 			}
@@ -863,19 +865,19 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 					f << stringf("%s%s", indent.c_str(), indent.c_str());
 					if (wen_bit != State::S1)
 					{
-						f << stringf("if (");
+						f << "if (";
 						dump_sigspec(f, wen_bit);
-						f << stringf(")\n");
+						f << ")\n";
 						f << stringf("%s%s%s", indent.c_str(), indent.c_str(), indent.c_str());
 					}
 					f << stringf("%s[", mem_id.c_str());
 					dump_sigspec(f, addr);
 					if (width == GetSize(port.en))
-						f << stringf("] <= ");
+						f << "] <= ";
 					else
 						f << stringf("][%d:%d] <= ", i, start_i);
 					dump_sigspec(f, port.data.extract(sub * mem.width + start_i, width));
-					f << stringf(";\n");
+					f << ";\n";
 				}
 			}
 		}
@@ -937,14 +939,19 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 	}
 }
 
-void dump_cell_expr_port(std::ostream &f, RTLIL::Cell *cell, std::string port, bool gen_signed = true)
+void dump_cell_expr_port(std::ostream &f, RTLIL::Cell *cell, const std::string &port, bool gen_signed = true)
 {
-	if (gen_signed && cell->parameters.count("\\" + port + "_SIGNED") > 0 && cell->parameters["\\" + port + "_SIGNED"].as_bool()) {
-		f << stringf("$signed(");
-		dump_sigspec(f, cell->getPort("\\" + port));
-		f << stringf(")");
-	} else
-		dump_sigspec(f, cell->getPort("\\" + port));
+	std::string port_name = "\\" + port;
+	if (gen_signed) {
+		auto it = cell->parameters.find(port_name + "_SIGNED");
+		if (it != cell->parameters.end() && it->second.as_bool()) {
+			f << "$signed(";
+			dump_sigspec(f, cell->getPort(port_name));
+			f << ")";
+			return;
+		}
+	}
+	dump_sigspec(f, cell->getPort(port_name));
 }
 
 std::string cellname(RTLIL::Cell *cell)
@@ -983,123 +990,123 @@ no_special_reg_name:
 	}
 }
 
-void dump_cell_expr_uniop(std::ostream &f, std::string indent, RTLIL::Cell *cell, std::string op)
+void dump_cell_expr_uniop(std::ostream &f, const std::string &indent, RTLIL::Cell *cell, const std::string &op)
 {
 	f << stringf("%s" "assign ", indent.c_str());
 	dump_sigspec(f, cell->getPort(ID::Y));
 	f << stringf(" = %s ", op.c_str());
 	dump_attributes(f, "", cell->attributes, ' ');
 	dump_cell_expr_port(f, cell, "A", true);
-	f << stringf(";\n");
+	f << ";\n";
 }
 
-void dump_cell_expr_binop(std::ostream &f, std::string indent, RTLIL::Cell *cell, std::string op)
+void dump_cell_expr_binop(std::ostream &f, const std::string &indent, RTLIL::Cell *cell, const std::string &op)
 {
 	f << stringf("%s" "assign ", indent.c_str());
 	dump_sigspec(f, cell->getPort(ID::Y));
-	f << stringf(" = ");
+	f << " = ";
 	dump_cell_expr_port(f, cell, "A", true);
 	f << stringf(" %s ", op.c_str());
 	dump_attributes(f, "", cell->attributes, ' ');
 	dump_cell_expr_port(f, cell, "B", true);
-	f << stringf(";\n");
+	f << ";\n";
 }
 
-bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
+bool dump_cell_expr(std::ostream &f, const std::string &indent, RTLIL::Cell *cell)
 {
 	if (cell->type == ID($_NOT_)) {
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
-		f << stringf("~");
+		f << " = ";
+		f << "~";
 		dump_attributes(f, "", cell->attributes, ' ');
 		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
 	if (cell->type.in(ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_))) {
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		if (cell->type.in(ID($_NAND_), ID($_NOR_), ID($_XNOR_)))
-			f << stringf("~(");
+			f << "~(";
 		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(" ");
+		f << " ";
 		if (cell->type.in(ID($_AND_), ID($_NAND_), ID($_ANDNOT_)))
-			f << stringf("&");
+			f << "&";
 		if (cell->type.in(ID($_OR_), ID($_NOR_), ID($_ORNOT_)))
-			f << stringf("|");
+			f << "|";
 		if (cell->type.in(ID($_XOR_), ID($_XNOR_)))
-			f << stringf("^");
+			f << "^";
 		dump_attributes(f, "", cell->attributes, ' ');
-		f << stringf(" ");
+		f << " ";
 		if (cell->type.in(ID($_ANDNOT_), ID($_ORNOT_)))
-			f << stringf("~(");
+			f << "~(";
 		dump_cell_expr_port(f, cell, "B", false);
 		if (cell->type.in(ID($_NAND_), ID($_NOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_)))
-			f << stringf(")");
-		f << stringf(";\n");
+			f << ")";
+		f << ";\n";
 		return true;
 	}
 
 	if (cell->type == ID($_MUX_)) {
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_cell_expr_port(f, cell, "S", false);
-		f << stringf(" ? ");
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, ' ');
 		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(" : ");
+		f << " : ";
 		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
 	if (cell->type == ID($_NMUX_)) {
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = !(");
+		f << " = !(";
 		dump_cell_expr_port(f, cell, "S", false);
-		f << stringf(" ? ");
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, ' ');
 		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(" : ");
+		f << " : ";
 		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(");\n");
+		f << ");\n";
 		return true;
 	}
 
 	if (cell->type.in(ID($_AOI3_), ID($_OAI3_))) {
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ~((");
+		f << " = ~((";
 		dump_cell_expr_port(f, cell, "A", false);
 		f << stringf(cell->type == ID($_AOI3_) ? " & " : " | ");
 		dump_cell_expr_port(f, cell, "B", false);
 		f << stringf(cell->type == ID($_AOI3_) ? ") |" : ") &");
 		dump_attributes(f, "", cell->attributes, ' ');
-		f << stringf(" ");
+		f << " ";
 		dump_cell_expr_port(f, cell, "C", false);
-		f << stringf(");\n");
+		f << ");\n";
 		return true;
 	}
 
 	if (cell->type.in(ID($_AOI4_), ID($_OAI4_))) {
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ~((");
+		f << " = ~((";
 		dump_cell_expr_port(f, cell, "A", false);
 		f << stringf(cell->type == ID($_AOI4_) ? " & " : " | ");
 		dump_cell_expr_port(f, cell, "B", false);
 		f << stringf(cell->type == ID($_AOI4_) ? ") |" : ") &");
 		dump_attributes(f, "", cell->attributes, ' ');
-		f << stringf(" (");
+		f << " (";
 		dump_cell_expr_port(f, cell, "C", false);
 		f << stringf(cell->type == ID($_AOI4_) ? " & " : " | ");
 		dump_cell_expr_port(f, cell, "D", false);
-		f << stringf("));\n");
+		f << "));\n";
 		return true;
 	}
 
@@ -1175,17 +1182,17 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			f << stringf("%s" "wire [%d:0] %s, %s, %s;\n", indent.c_str(), size_max, buf_a.c_str(), buf_b.c_str(), buf_num.c_str());
 			f << stringf("%s" "assign %s = ", indent.c_str(), buf_a.c_str());
 			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(";\n");
+			f << ";\n";
 			f << stringf("%s" "assign %s = ", indent.c_str(), buf_b.c_str());
 			dump_cell_expr_port(f, cell, "B", true);
-			f << stringf(";\n");
+			f << ";\n";
 
 			f << stringf("%s" "assign %s = ", indent.c_str(), buf_num.c_str());
-			f << stringf("(");
+			f << "(";
 			dump_sigspec(f, sig_a.extract(sig_a.size()-1));
-			f << stringf(" == ");
+			f << " == ";
 			dump_sigspec(f, sig_b.extract(sig_b.size()-1));
-			f << stringf(") || ");
+			f << ") || ";
 			dump_sigspec(f, sig_a);
 			f << stringf(" == 0 ? %s : ", buf_a.c_str());
 			f << stringf("$signed(%s - (", buf_a.c_str());
@@ -1221,13 +1228,13 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			f << stringf(" %% ");
 			dump_attributes(f, "", cell->attributes, ' ');
 			dump_cell_expr_port(f, cell, "B", true);
-			f << stringf(";\n");
+			f << ";\n";
 
 			f << stringf("%s" "assign ", indent.c_str());
 			dump_sigspec(f, cell->getPort(ID::Y));
-			f << stringf(" = (");
+			f << " = (";
 			dump_sigspec(f, sig_a.extract(sig_a.size()-1));
-			f << stringf(" == ");
+			f << " == ";
 			dump_sigspec(f, sig_b.extract(sig_b.size()-1));
 			f << stringf(") || %s == 0 ? %s : ", temp_id.c_str(), temp_id.c_str());
 			dump_cell_expr_port(f, cell, "B", true);
@@ -1244,26 +1251,26 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	{
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		if (cell->getParam(ID::B_SIGNED).as_bool())
 		{
 			dump_cell_expr_port(f, cell, "B", true);
-			f << stringf(" < 0 ? ");
+			f << " < 0 ? ";
 			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(" << - ");
+			f << " << - ";
 			dump_sigspec(f, cell->getPort(ID::B));
-			f << stringf(" : ");
+			f << " : ";
 			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(" >> ");
+			f << " >> ";
 			dump_sigspec(f, cell->getPort(ID::B));
 		}
 		else
 		{
 			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(" >> ");
+			f << " >> ";
 			dump_sigspec(f, cell->getPort(ID::B));
 		}
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
@@ -1272,18 +1279,18 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		std::string temp_id = next_auto_id();
 		f << stringf("%s" "wire [%d:0] %s = ", indent.c_str(), GetSize(cell->getPort(ID::A))-1, temp_id.c_str());
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(";\n");
+		f << ";\n";
 
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
 		f << stringf(" = %s[", temp_id.c_str());
 		if (cell->getParam(ID::B_SIGNED).as_bool())
-			f << stringf("$signed(");
+			f << "$signed(";
 		dump_sigspec(f, cell->getPort(ID::B));
 		if (cell->getParam(ID::B_SIGNED).as_bool())
-			f << stringf(")");
+			f << ")";
 		f << stringf(" +: %d", cell->getParam(ID::Y_WIDTH).as_int());
-		f << stringf("];\n");
+		f << "];\n";
 		return true;
 	}
 
@@ -1291,14 +1298,14 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	{
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, cell->getPort(ID::S));
-		f << stringf(" ? ");
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, ' ');
 		dump_sigspec(f, cell->getPort(ID::B));
-		f << stringf(" : ");
+		f << " : ";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
@@ -1326,7 +1333,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			for (int j = s_width-1; j >= 0; j--)
 				f << stringf("%c", j == i ? '1' : '?');
 
-			f << stringf(":\n");
+			f << ":\n";
 			f << stringf("%s" "      %s = b[%d:%d];\n", indent.c_str(), func_name.c_str(), (i+1)*width-1, i*width);
 		}
 
@@ -1340,11 +1347,11 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		dump_sigspec(f, cell->getPort(ID::Y));
 		f << stringf(" = %s(", func_name.c_str());
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(", ");
+		f << ", ";
 		dump_sigspec(f, cell->getPort(ID::B));
-		f << stringf(", ");
+		f << ", ";
 		dump_sigspec(f, cell->getPort(ID::S));
-		f << stringf(");\n");
+		f << ");\n";
 		return true;
 	}
 
@@ -1352,9 +1359,9 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	{
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, cell->getPort(ID::EN));
-		f << stringf(" ? ");
+		f << " ? ";
 		dump_sigspec(f, cell->getPort(ID::A));
 		f << stringf(" : %d'bz;\n", cell->parameters.at(ID::WIDTH).as_int());
 		return true;
@@ -1364,7 +1371,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	{
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, cell->getPort(ID::A));
 		f << stringf(" >> %d;\n", cell->parameters.at(ID::OFFSET).as_int());
 		return true;
@@ -1374,11 +1381,11 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	{
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = { ");
+		f << " = { ";
 		dump_sigspec(f, cell->getPort(ID::B));
-		f << stringf(" , ");
+		f << " , ";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(" };\n");
+		f << " };\n";
 		return true;
 	}
 
@@ -1386,12 +1393,12 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	{
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_const(f, cell->parameters.at(ID::LUT));
-		f << stringf(" >> ");
+		f << " >> ";
 		dump_attributes(f, "", cell->attributes, ' ');
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
@@ -1448,14 +1455,14 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 						sig_set_name = next_auto_id();
 						f << stringf("%s" "wire %s = ", indent.c_str(), sig_set_name.c_str());
 						dump_const(f, ff.sig_set[i].data);
-						f << stringf(";\n");
+						f << ";\n";
 					}
 					if (ff.sig_clr[i].wire == NULL)
 					{
 						sig_clr_name = next_auto_id();
 						f << stringf("%s" "wire %s = ", indent.c_str(), sig_clr_name.c_str());
 						dump_const(f, ff.sig_clr[i].data);
-						f << stringf(";\n");
+						f << ";\n";
 					}
 				} else if (ff.has_arst) {
 					if (ff.sig_arst[0].wire == NULL)
@@ -1463,7 +1470,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 						sig_arst_name = next_auto_id();
 						f << stringf("%s" "wire %s = ", indent.c_str(), sig_arst_name.c_str());
 						dump_const(f, ff.sig_arst[0].data);
-						f << stringf(";\n");
+						f << ";\n";
 					}
 				} else if (ff.has_aload) {
 					if (ff.sig_aload[0].wire == NULL)
@@ -1471,7 +1478,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 						sig_aload_name = next_auto_id();
 						f << stringf("%s" "wire %s = ", indent.c_str(), sig_aload_name.c_str());
 						dump_const(f, ff.sig_aload[0].data);
-						f << stringf(";\n");
+						f << ";\n";
 					}
 				}
 			}
@@ -1507,7 +1514,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 					else
 						dump_sigspec(f, ff.sig_aload);
 				}
-				f << stringf(")\n");
+				f << ")\n";
 
 				f << stringf("%s" "  ", indent.c_str());
 				if (ff.has_sr) {
@@ -1532,7 +1539,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 						dump_sigspec(f, ff.sig_arst);
 					f << stringf(") %s <= ", reg_bit_name.c_str());
 					dump_sigspec(f, val_arst);
-					f << stringf(";\n");
+					f << ";\n";
 					f << stringf("%s" "  else ", indent.c_str());
 				} else if (ff.has_aload) {
 					f << stringf("if (%s", ff.pol_aload ? "" : "!");
@@ -1542,19 +1549,19 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 						dump_sigspec(f, ff.sig_aload);
 					f << stringf(") %s <= ", reg_bit_name.c_str());
 					dump_sigspec(f, sig_ad);
-					f << stringf(";\n");
+					f << ";\n";
 					f << stringf("%s" "  else ", indent.c_str());
 				}
 
 				if (ff.has_srst && ff.has_ce && ff.ce_over_srst) {
 					f << stringf("if (%s", ff.pol_ce ? "" : "!");
 					dump_sigspec(f, ff.sig_ce);
-					f << stringf(")\n");
+					f << ")\n";
 					f << stringf("%s" "    if (%s", indent.c_str(), ff.pol_srst ? "" : "!");
 					dump_sigspec(f, ff.sig_srst);
 					f << stringf(") %s <= ", reg_bit_name.c_str());
 					dump_sigspec(f, val_srst);
-					f << stringf(";\n");
+					f << ";\n";
 					f << stringf("%s" "    else ", indent.c_str());
 				} else {
 					if (ff.has_srst) {
@@ -1562,19 +1569,19 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 						dump_sigspec(f, ff.sig_srst);
 						f << stringf(") %s <= ", reg_bit_name.c_str());
 						dump_sigspec(f, val_srst);
-						f << stringf(";\n");
+						f << ";\n";
 						f << stringf("%s" "  else ", indent.c_str());
 					}
 					if (ff.has_ce) {
 						f << stringf("if (%s", ff.pol_ce ? "" : "!");
 						dump_sigspec(f, ff.sig_ce);
-						f << stringf(") ");
+						f << ") ";
 					}
 				}
 
 				f << stringf("%s <= ", reg_bit_name.c_str());
 				dump_sigspec(f, sig_d);
-				f << stringf(";\n");
+				f << ";\n";
 			}
 			else
 			{
@@ -1596,7 +1603,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 					dump_sigspec(f, ff.sig_arst);
 					f << stringf(") %s = ", reg_bit_name.c_str());
 					dump_sigspec(f, val_arst);
-					f << stringf(";\n");
+					f << ";\n";
 					if (ff.has_aload)
 						f << stringf("%s" "  else ", indent.c_str());
 				}
@@ -1605,7 +1612,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 					dump_sigspec(f, ff.sig_aload);
 					f << stringf(") %s = ", reg_bit_name.c_str());
 					dump_sigspec(f, sig_ad);
-					f << stringf(";\n");
+					f << ";\n";
 				}
 			}
 		}
@@ -1625,7 +1632,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		dump_sigspec(f, cell->getPort(ID::EN));
 		f << stringf(") %s(", cell->type.c_str()+1);
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(");\n");
+		f << ");\n";
 		return true;
 	}
 
@@ -1635,9 +1642,9 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 
 		SigSpec en = cell->getPort(ID::EN);
 		if (en != State::S1) {
-			f << stringf("if (");
+			f << "if (";
 			dump_sigspec(f, cell->getPort(ID::EN));
-			f << stringf(") ");
+			f << ") ";
 		}
 
 		f << "(";
@@ -1744,7 +1751,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	return false;
 }
 
-void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
+void dump_cell(std::ostream &f, const std::string &indent, RTLIL::Cell *cell)
 {
 	// Handled by dump_memory
 	if (cell->is_mem_cell())
@@ -1759,13 +1766,13 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	f << stringf("%s" "%s", indent.c_str(), id(cell->type, false).c_str());
 
 	if (!defparam && cell->parameters.size() > 0) {
-		f << stringf(" #(");
+		f << " #(";
 		for (auto it = cell->parameters.begin(); it != cell->parameters.end(); ++it) {
 			if (it != cell->parameters.begin())
-				f << stringf(",");
+				f << ",";
 			f << stringf("\n%s  .%s(", indent.c_str(), id(it->first).c_str());
 			dump_const(f, it->second);
-			f << stringf(")");
+			f << ")";
 		}
 		f << stringf("\n%s" ")", indent.c_str());
 	}
@@ -1785,7 +1792,7 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			if (it->first != str)
 				continue;
 			if (!first_arg)
-				f << stringf(",");
+				f << ",";
 			first_arg = false;
 			f << stringf("\n%s  ", indent.c_str());
 			dump_sigspec(f, it->second);
@@ -1799,12 +1806,12 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		if (numbered_ports.count(it->first))
 			continue;
 		if (!first_arg)
-			f << stringf(",");
+			f << ",";
 		first_arg = false;
 		f << stringf("\n%s  .%s(", indent.c_str(), id(it->first).c_str());
 		if (it->second.size() > 0)
 			dump_sigspec(f, it->second);
-		f << stringf(")");
+		f << ")";
 	}
 	f << stringf("\n%s" ");\n", indent.c_str());
 
@@ -1812,7 +1819,7 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		for (auto it = cell->parameters.begin(); it != cell->parameters.end(); ++it) {
 			f << stringf("%sdefparam %s.%s = ", indent.c_str(), cell_name.c_str(), id(it->first).c_str());
 			dump_const(f, it->second);
-			f << stringf(";\n");
+			f << ";\n";
 		}
 	}
 
@@ -1827,24 +1834,24 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	}
 }
 
-void dump_conn(std::ostream &f, std::string indent, const RTLIL::SigSpec &left, const RTLIL::SigSpec &right)
+void dump_conn(std::ostream &f, const std::string &indent, const RTLIL::SigSpec &left, const RTLIL::SigSpec &right)
 {
 	if (simple_lhs) {
 		int offset = 0;
 		for (auto &chunk : left.chunks()) {
 			f << stringf("%s" "assign ", indent.c_str());
 			dump_sigspec(f, chunk);
-			f << stringf(" = ");
+			f << " = ";
 			dump_sigspec(f, right.extract(offset, GetSize(chunk)));
-			f << stringf(";\n");
+			f << ";\n";
 			offset += GetSize(chunk);
 		}
 	} else {
 		f << stringf("%s" "assign ", indent.c_str());
 		dump_sigspec(f, left);
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, right);
-		f << stringf(";\n");
+		f << ";\n";
 	}
 }
 
@@ -1862,9 +1869,9 @@ void dump_case_body(std::ostream &f, std::string indent, RTLIL::CaseRule *cs, bo
 			continue;
 		f << stringf("%s  ", indent.c_str());
 		dump_sigspec(f, it->first);
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, it->second);
-		f << stringf(";\n");
+		f << ";\n";
 	}
 
 	for (auto it = cs->switches.begin(); it != cs->switches.end(); ++it)
@@ -1892,7 +1899,7 @@ void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw
 	dump_attributes(f, indent, sw->attributes);
 	f << stringf("%s" "casez (", indent.c_str());
 	dump_sigspec(f, sw->signal);
-	f << stringf(")\n");
+	f << ")\n";
 
 	bool got_default = false;
 	for (auto it = sw->cases.begin(); it != sw->cases.end(); ++it) {
@@ -1906,11 +1913,11 @@ void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw
 			f << stringf("%s  ", indent.c_str());
 			for (size_t i = 0; i < (*it)->compare.size(); i++) {
 				if (i > 0)
-					f << stringf(", ");
+					f << ", ";
 				dump_sigspec(f, (*it)->compare[i]);
 			}
 		}
-		f << stringf(":\n");
+		f << ":\n";
 		dump_case_body(f, indent + "    ", *it);
 	}
 
@@ -1962,11 +1969,11 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		} else {
 			f << stringf("%s" "always%s @(", indent.c_str(), systemverilog ? "_ff" : "");
 			if (sync->type == RTLIL::STp || sync->type == RTLIL::ST1)
-				f << stringf("posedge ");
+				f << "posedge ";
 			if (sync->type == RTLIL::STn || sync->type == RTLIL::ST0)
-				f << stringf("negedge ");
+				f << "negedge ";
 			dump_sigspec(f, sync->signal);
-			f << stringf(") begin\n");
+			f << ") begin\n";
 		}
 		std::string ends = indent + "end\n";
 		indent += "  ";
@@ -1974,7 +1981,7 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		if (sync->type == RTLIL::ST0 || sync->type == RTLIL::ST1) {
 			f << stringf("%s" "if (%s", indent.c_str(), sync->type == RTLIL::ST0 ? "!" : "");
 			dump_sigspec(f, sync->signal);
-			f << stringf(") begin\n");
+			f << ") begin\n";
 			ends = indent + "end\n" + ends;
 			indent += "  ";
 		}
@@ -1985,7 +1992,7 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 				if (sync2->type == RTLIL::ST0 || sync2->type == RTLIL::ST1) {
 					f << stringf("%s" "if (%s", indent.c_str(), sync2->type == RTLIL::ST1 ? "!" : "");
 					dump_sigspec(f, sync2->signal);
-					f << stringf(") begin\n");
+					f << ") begin\n";
 					ends = indent + "end\n" + ends;
 					indent += "  ";
 				}
@@ -1997,9 +2004,9 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 				continue;
 			f << stringf("%s  ", indent.c_str());
 			dump_sigspec(f, it->first);
-			f << stringf(" <= ");
+			f << " <= ";
 			dump_sigspec(f, it->second);
-			f << stringf(";\n");
+			f << ";\n";
 		}
 
 		f << stringf("%s", ends.c_str());
@@ -2029,7 +2036,7 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 				"changes in simulation behavior are possible! Use \"proc\" to convert\n"
 				"processes to logic networks and registers.\n", log_id(module));
 
-	f << stringf("\n");
+	f << "\n";
 	for (auto it = module->processes.begin(); it != module->processes.end(); ++it)
 		dump_process(f, indent + "  ", it->second, true);
 
@@ -2070,15 +2077,15 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 		for (auto wire : module->wires()) {
 			if (wire->port_id == port_id) {
 				if (port_id != 1)
-					f << stringf(", ");
+					f << ", ";
 				f << stringf("%s", id(wire->name).c_str());
 				keep_running = true;
-				if (cnt==20) { f << stringf("\n"); cnt = 0; } else cnt++;
+				if (cnt==20) { f << "\n"; cnt = 0; } else cnt++;
 				continue;
 			}
 		}
 	}
-	f << stringf(");\n");
+	f << ");\n";
 	if (!systemverilog && !module->processes.empty()) {
 		initial_id = NEW_ID;
 		f << indent + "  " << "reg " << id(initial_id) << " = 0;\n";
@@ -268,7 +268,7 @@ end_of_header:
 	else
 		log_abort();
 
-	RTLIL::Wire* n0 = module->wire(stringf("$aiger%d$0", aiger_autoidx));
+	RTLIL::Wire* n0 = literal_wire(0);
 	if (n0)
 		module->connect(n0, State::S0);
 
@@ -336,29 +336,80 @@ static uint32_t parse_xaiger_literal(std::istream &f)
 	return from_big_endian(l);
 }
 
+void AigerReader::reserve_from_header()
+{
+	if (uint64_t(M) < uint64_t(I) + L + A)
+		log_error("Invalid AIGER header: M=%u is smaller than I+L+A=%" PRIu64 "!\n", M, uint64_t(I) + L + A);
+
+	// The counts come from the file and are not trusted for reservations. A
+	// truncated or malformed file has to fail with an error, not by
+	// allocating gigabytes first. Everything but the inputs of a binary file
+	// takes at least one byte, so the reservations are capped by the size of
+	// the rest of the file (if it is known).
+	uint64_t limit = 1 << 20;
+	std::streampos pos = f.tellg();
+	if (pos != std::streampos(-1)) {
+		f.seekg(0, std::ios::end);
+		std::streampos end = f.tellg();
+		if (end != std::streampos(-1))
+			limit = uint64_t(end - pos);
+		f.clear();
+		f.seekg(pos);
+	}
+	auto capped = [&](uint64_t n) { return size_t(std::min(n, limit)); };
+
+	// Wires are looked up by literal in a table that is sized from the
+	// header (and grown on demand), instead of by name in the module.
+	literal_wires.clear();
+	literal_wires.resize(2 * (capped(M) + 1));
+
+	inputs.reserve(capped(I));
+	latches.reserve(capped(L));
+	outputs.reserve(capped(O));
+	bad_properties.reserve(capped(B));
+
+	// Each AND gate creates (at most) one wire for its output, one for the
+	// inverted output and two cells.
+	module->wires_.reserve(capped(2 * (uint64_t(I) + L) + O + 2 * uint64_t(A) + 1));
+	module->cells_.reserve(capped(L + 2 * uint64_t(A)));
+}
+
+RTLIL::Wire* AigerReader::literal_wire(unsigned literal)
+{
+	return literal < literal_wires.size() ? literal_wires[literal] : nullptr;
+}
+
 RTLIL::Wire* AigerReader::createWireIfNotExists(RTLIL::Module *module, unsigned literal)
 {
+	if (literal >= literal_wires.size()) {
+		if (literal > 2 * uint64_t(M) + 1)
+			log_error("Literal %u is out of range for M=%u!\n", literal, M);
+		literal_wires.resize(size_t(literal) + 2);
+	}
+	if (literal_wires[literal])
+		return literal_wires[literal];
+
 	const unsigned variable = literal >> 1;
 	const bool invert = literal & 1;
 	RTLIL::IdString wire_name(stringf("$aiger%d$%d%s", aiger_autoidx, variable, invert ? "b" : ""));
-	RTLIL::Wire *wire = module->wire(wire_name);
-	if (wire) return wire;
 	log_debug2("Creating %s\n", wire_name.c_str());
-	wire = module->addWire(wire_name);
+	RTLIL::Wire *wire = module->addWire(wire_name);
 	wire->port_input = wire->port_output = false;
+	literal_wires[literal] = wire;
 	if (!invert) return wire;
-	RTLIL::IdString wire_inv_name(stringf("$aiger%d$%d", aiger_autoidx, variable));
-	RTLIL::Wire *wire_inv = module->wire(wire_inv_name);
+	RTLIL::Wire *wire_inv = literal_wires[literal ^ 1];
 	if (wire_inv) {
-		if (module->cell(wire_inv_name)) return wire;
+		if (module->cell(wire_inv->name)) return wire;
 	}
 	else {
+		RTLIL::IdString wire_inv_name(stringf("$aiger%d$%d", aiger_autoidx, variable));
 		log_debug2("Creating %s\n", wire_inv_name.c_str());
 		wire_inv = module->addWire(wire_inv_name);
 		wire_inv->port_input = wire_inv->port_output = false;
+		literal_wires[literal ^ 1] = wire_inv;
 	}
 
-	log_debug2("Creating %s = ~%s\n", wire_name.c_str(), wire_inv_name.c_str());
+	log_debug2("Creating %s = ~%s\n", wire_name.c_str(), wire_inv->name.c_str());
 	module->addNotGate(stringf("$not$aiger%d$%d", aiger_autoidx, variable), wire_inv, wire);
 
 	return wire;
@@ -396,7 +447,7 @@ void AigerReader::parse_xaiger()
 	else
 		log_abort();
 
-	RTLIL::Wire* n0 = module->wire(stringf("$aiger%d$0", aiger_autoidx));
+	RTLIL::Wire* n0 = literal_wire(0);
 	if (n0)
 		module->connect(n0, State::S0);
 
@@ -420,7 +471,7 @@ void AigerReader::parse_xaiger()
 				uint32_t rootNodeID = parse_xaiger_literal(f);
 				uint32_t cutLeavesM = parse_xaiger_literal(f);
 				log_debug2("rootNodeID=%d cutLeavesM=%d\n", rootNodeID, cutLeavesM);
-				RTLIL::Wire *output_sig = module->wire(stringf("$aiger%d$%d", aiger_autoidx, rootNodeID));
+				RTLIL::Wire *output_sig = literal_wire(rootNodeID << 1);
 				log_assert(output_sig);
 				uint32_t nodeID;
 				RTLIL::SigSpec input_sig;
@@ -431,7 +482,7 @@ void AigerReader::parse_xaiger()
 						log_debug("\tLUT '$lut$aiger%d$%d' input %d is constant!\n", aiger_autoidx, rootNodeID, cutLeavesM);
 						continue;
 					}
-					RTLIL::Wire *wire = module->wire(stringf("$aiger%d$%d", aiger_autoidx, nodeID));
+					RTLIL::Wire *wire = literal_wire(nodeID << 1);
 					log_assert(wire);
 					input_sig.append(wire);
 				}
@@ -525,6 +576,8 @@ void AigerReader::parse_aiger_ascii()
 
 	unsigned l1, l2, l3;
 
+	reserve_from_header();
+
 	// Parse inputs
 	int digits = decimal_digits(I);
 	for (unsigned i = 1; i <= I; ++i, ++line_count) {
@@ -639,12 +692,17 @@ void AigerReader::parse_aiger_ascii()
 	std::getline(f, line); // Ignore up to start of next line
 }
 
-static unsigned parse_next_delta_literal(std::istream &f, unsigned ref)
+// Reads from the stream buffer directly, which avoids constructing a sentry
+// object for each byte as istream::get() does.
+static unsigned parse_next_delta_literal(std::streambuf *buf, unsigned ref, unsigned line_count)
 {
+	const int eof = std::char_traits<char>::eof();
 	unsigned x = 0, i = 0;
-	unsigned char ch;
-	while ((ch = f.get()) & 0x80)
+	int ch;
+	while ((ch = buf->sbumpc()) != eof && (ch & 0x80))
 		x |= (ch & 0x7f) << (7 * i++);
+	if (ch == eof)
+		log_error("Line %u: unexpected end of file in AND gate section!\n", line_count);
 	return ref - (x | (ch << (7 * i)));
 }
 
@@ -653,6 +711,8 @@ void AigerReader::parse_aiger_binary()
 	unsigned l1, l2, l3;
 	std::string line;
 
+	reserve_from_header();
+
 	// Parse inputs
 	int digits = decimal_digits(I);
 	for (unsigned i = 1; i <= I; ++i) {
@@ -750,10 +810,11 @@ void AigerReader::parse_aiger_binary()
 		std::getline(f, line); // Ignore up to start of next line
 
 	// Parse AND
+	std::streambuf *buf = f.rdbuf();
 	l1 = (I+L+1) << 1;
 	for (unsigned i = 0; i < A; ++i, ++line_count, l1 += 2) {
-		l2 = parse_next_delta_literal(f, l1);
-		l3 = parse_next_delta_literal(f, l2);
+		l2 = parse_next_delta_literal(buf, l1, line_count);
+		l3 = parse_next_delta_literal(buf, l2, line_count);
 
 		log_debug2("%d %d %d is an AND\n", l1, l2, l3);
 		log_assert(!(l1 & 1));
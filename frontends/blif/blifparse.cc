@@ -18,6 +18,7 @@
  */
 
 #include "blifparse.h"
+#include "kernel/truthtable.h"
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -586,19 +587,31 @@ void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool
 			if (input_len > lut_input_plane_limit)
 				goto error;
 
-			for (int i = 0; i < (1 << input_len); i++) {
-				for (int j = 0; j < input_len; j++) {
-					char c1 = input[j];
-					if (c1 != '-') {
-						char c2 = (i & (1 << j)) != 0 ? '1' : '0';
-						if (c1 != c2)
-							goto try_next_value;
-					}
-				}
-				lutptr->bits.at(i) = !strcmp(output, "0") ? RTLIL::State::S0 : RTLIL::State::S1;
-			try_next_value:;
+			int lut_width = ceil_log2(GetSize(lutptr->bits));
+			if (input_len > lut_width)
+				goto error;
+
+			// Inputs missing from the cube are treated as 0.
+			TruthTable cube(lut_width, true);
+			for (int j = 0; j < lut_width; j++) {
+				char c = j < input_len ? input[j] : '0';
+				if (c == '1')
+					cube &= TruthTable::var(lut_width, j);
+				else if (c == '0')
+					cube &= ~TruthTable::var(lut_width, j);
+				else if (c != '-')
+					cube = TruthTable(lut_width, false);
 			}
 
+			RTLIL::State value = !strcmp(output, "0") ? RTLIL::State::S0 : RTLIL::State::S1;
+			for (int w = 0; w < cube.num_words(); w++)
+				for (uint64_t word = cube.words[w]; word != 0; word &= word - 1) {
+					int i = 64 * w + TruthTable::lowest_bit(word);
+					if (i >= GetSize(lutptr->bits))
+						break;
+					lutptr->bits[i] = value;
+				}
+
 			lut_default_state = !strcmp(output, "0") ? RTLIL::State::S1 : RTLIL::State::S0;
 		}
 	}
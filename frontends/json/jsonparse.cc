@@ -21,6 +21,66 @@
 
 YOSYS_NAMESPACE_BEGIN
 
+// Buffered character source for the JSON parser. Reading the input in large
+// blocks is much faster than calling std::istream::get() for every character.
+struct JsonReader
+{
+	std::istream &f;
+	std::vector<char> buffer;
+	size_t pos, len;
+
+	JsonReader(std::istream &f) : f(f), buffer(1 << 16), pos(0), len(0) { }
+
+	int get()
+	{
+		if (pos == len) {
+			f.read(buffer.data(), buffer.size());
+			len = f.gcount();
+			pos = 0;
+			if (len == 0)
+				return EOF;
+		}
+		return (unsigned char)buffer[pos++];
+	}
+
+	void unget()
+	{
+		log_assert(pos > 0);
+		pos--;
+	}
+
+	// Returns true if ch is whitespace or the start of a /* ... */ comment
+	// (as written by "write_json -aig"), consuming the rest of the comment.
+	bool space(int ch)
+	{
+		if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
+			return true;
+		if (ch != '/')
+			return false;
+		if (get() != '*')
+			log_error("Unexpected character in JSON file: '/'\n");
+		for (int last = 0; (ch = get()) != '/' || last != '*'; last = ch)
+			if (ch == EOF)
+				log_error("Unexpected EOF in JSON comment.\n");
+		return true;
+	}
+
+	// Skip whitespace, comments and any of the given separator characters
+	// and return the next character without consuming it.
+	int skip(const char *separators)
+	{
+		while (1) {
+			int ch = get();
+			if (ch == EOF)
+				return EOF;
+			if (space(ch) || strchr(separators, ch) != nullptr)
+				continue;
+			unget();
+			return ch;
+		}
+	}
+};
+
 struct JsonNode
 {
 	char type; // S=String, N=Number, A=Array, D=Dict
@@ -30,7 +90,7 @@ struct JsonNode
 	dict<string, JsonNode*> data_dict;
 	vector<string> data_dict_keys;
 
-	JsonNode(std::istream &f)
+	JsonNode(JsonReader &f)
 	{
 		type = 0;
 		data_number = 0;
@@ -42,7 +102,7 @@ struct JsonNode
 			if (ch == EOF)
 				log_error("Unexpected EOF in JSON file.\n");
 
-			if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
+			if (f.space(ch))
 				continue;
 
 			if (ch == '"')
@@ -170,7 +230,7 @@ struct JsonNode
 					if (ch == EOF)
 						log_error("Unexpected EOF in JSON file.\n");
 
-					if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ',')
+					if (f.space(ch) || ch == ',')
 						continue;
 
 					if (ch == ']')
@@ -194,7 +254,7 @@ struct JsonNode
 					if (ch == EOF)
 						log_error("Unexpected EOF in JSON file.\n");
 
-					if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ',')
+					if (f.space(ch) || ch == ',')
 						continue;
 
 					if (ch == '}')
@@ -210,7 +270,7 @@ struct JsonNode
 						if (ch == EOF)
 							log_error("Unexpected EOF in JSON file.\n");
 
-						if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ':')
+						if (f.space(ch) || ch == ':')
 							continue;
 
 						f.unget();
@@ -287,7 +347,7 @@ void json_parse_attr_param(dict<IdString, Const> &results, JsonNode *node)
 	}
 }
 
-void json_import(Design *design, string &modname, JsonNode *node)
+void json_import(Design *design, const string &modname, JsonNode *node)
 {
 	log("Importing module %s from JSON tree.\n", modname.c_str());
 
@@ -646,20 +706,61 @@ struct JsonFrontend : public Frontend {
 		}
 		extra_args(f, filename, args, argidx);
 
-		JsonNode root(*f);
+		// The root and "modules" dictionaries are parsed incrementally, so that
+		// only the JSON tree of a single module needs to be held in memory while
+		// it is imported.
+		JsonReader reader(*f);
 
-		if (root.type != 'D')
+		int ch = reader.skip("");
+		if (ch == EOF)
+			log_error("Unexpected EOF in JSON file.\n");
+		if (ch != '{')
 			log_error("JSON root node is not a dictionary.\n");
+		reader.get();
 
-		if (root.data_dict.count("modules") != 0)
+		while (1)
 		{
-			JsonNode *modules = root.data_dict.at("modules");
+			ch = reader.skip(",");
+			if (ch == EOF)
+				log_error("Unexpected EOF in JSON file.\n");
+			if (ch == '}')
+				break;
+
+			JsonNode key(reader);
+			if (key.type != 'S')
+				log_error("Unexpected non-string key in JSON dict.\n");
+			reader.skip(":");
+
+			if (key.data_string != "modules") {
+				JsonNode value(reader);
+				continue;
+			}
 
-			if (modules->type != 'D')
+			ch = reader.skip("");
+			if (ch == EOF)
+				log_error("Unexpected EOF in JSON file.\n");
+			if (ch != '{')
 				log_error("JSON modules node is not a dictionary.\n");
+			reader.get();
 
-			for (auto &it : modules->data_dict)
-				json_import(design, it.first, it.second);
+			while (1)
+			{
+				ch = reader.skip(",");
+				if (ch == EOF)
+					log_error("Unexpected EOF in JSON file.\n");
+				if (ch == '}') {
+					reader.get();
+					break;
+				}
+
+				JsonNode modname(reader);
+				if (modname.type != 'S')
+					log_error("Unexpected non-string key in JSON dict.\n");
+				reader.skip(":");
+
+				JsonNode module_node(reader);
+				json_import(design, modname.data_string, &module_node);
+			}
 		}
 	}
 } JsonFrontend;
@@ -546,7 +546,7 @@ struct LibertyFrontend : public Frontend {
 		if (flag_wb && flag_lib)
 			log_error("-wb and -lib cannot be specified together!\n");
 
-		LibertyParser parser(*f);
+		LibertyParser parser(*f, LibertyParser::timing_groups());
 		int cell_count = 0;
 
 		std::map<std::string, std::tuple<int, int, bool>> global_type_map;
@@ -0,0 +1,135 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/celltypes.h"
+
+#include <algorithm>
+
+YOSYS_NAMESPACE_BEGIN
+
+// Type names with an index below this are looked up in the type_ids vector.
+// This covers all internal cell types, which are created by yosys_setup().
+static const int DENSE_INDEX_LIMIT = 1 << 16;
+
+void CellTypeTable::get_signature(RTLIL::Design *design, std::vector<int> &signature)
+{
+	signature.clear();
+	signature.push_back(GetSize(yosys_celltypes.cell_types));
+
+	for (auto &it : design->modules_) {
+		RTLIL::Module *module = it.second;
+		signature.push_back(module->name.index_);
+		signature.push_back(GetSize(module->ports));
+		for (auto port : module->ports) {
+			RTLIL::Wire *wire = module->wire(port);
+			int flags = (wire->port_input ? PORT_INPUT : 0) | (wire->port_output ? PORT_OUTPUT : 0);
+			signature.push_back(port.index_);
+			signature.push_back(flags);
+		}
+	}
+}
+
+void CellTypeTable::add_type(RTLIL::IdString type, std::vector<std::pair<int, int>> &&ports, bool is_evaluable)
+{
+	std::sort(ports.begin(), ports.end());
+
+	int id = type_id(type);
+	if (id < 0) {
+		id = GetSize(types);
+		types.emplace_back();
+		if (type.index_ < DENSE_INDEX_LIMIT) {
+			if (type.index_ >= GetSize(type_ids))
+				type_ids.resize(type.index_ + 1, -1);
+			type_ids[type.index_] = id;
+		} else {
+			large_type_ids[type.index_] = id;
+		}
+	}
+
+	TypeEntry &entry = types[id];
+	entry.type = type;
+	entry.is_evaluable = is_evaluable;
+	entry.ports = std::move(ports);
+}
+
+bool CellTypeTable::update(RTLIL::Design *design)
+{
+	std::vector<int> new_signature;
+	get_signature(design, new_signature);
+	if (!types.empty() && new_signature == signature)
+		return false;
+
+	types.clear();
+	type_ids.clear();
+	large_type_ids.clear();
+	signature.swap(new_signature);
+
+	// Same precedence as CellTypes::setup(design): internal cell types
+	// override modules of the same name.
+	for (auto module : design->modules()) {
+		std::vector<std::pair<int, int>> ports;
+		for (auto port : module->ports) {
+			RTLIL::Wire *wire = module->wire(port);
+			int flags = (wire->port_input ? PORT_INPUT : 0) | (wire->port_output ? PORT_OUTPUT : 0);
+			if (flags)
+				ports.push_back(std::make_pair(port.index_, flags));
+		}
+		add_type(module->name, std::move(ports), false);
+	}
+
+	for (auto &it : yosys_celltypes.cell_types) {
+		const CellType &ct = it.second;
+		std::vector<std::pair<int, int>> ports;
+		for (auto port : ct.inputs)
+			ports.push_back(std::make_pair(port.index_, PORT_INPUT | (ct.outputs.count(port) ? PORT_OUTPUT : 0)));
+		for (auto port : ct.outputs)
+			if (!ct.inputs.count(port))
+				ports.push_back(std::make_pair(port.index_, PORT_OUTPUT));
+		add_type(ct.type, std::move(ports), ct.is_evaluable);
+	}
+
+	return true;
+}
+
+int CellTypeTable::port_flags(int type_id, RTLIL::IdString port) const
+{
+	if (type_id < 0)
+		return 0;
+
+	const std::vector<std::pair<int, int>> &ports = types[type_id].ports;
+	if (GetSize(ports) <= 8) {
+		for (auto &it : ports)
+			if (it.first == port.index_)
+				return it.second;
+		return 0;
+	}
+
+	auto it = std::lower_bound(ports.begin(), ports.end(), std::make_pair(port.index_, 0));
+	return it != ports.end() && it->first == port.index_ ? it->second : 0;
+}
+
+const CellTypeTable &RTLIL::Design::cell_types()
+{
+	if (cell_types_ == nullptr)
+		cell_types_.reset(new CellTypeTable);
+	cell_types_->update(this);
+	return *cell_types_;
+}
+
+YOSYS_NAMESPACE_END
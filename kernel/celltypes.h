@@ -516,6 +516,85 @@ struct CellTypes
 // initialized by yosys_setup()
 extern CellTypes yosys_celltypes;
 
+// A read-only index of the cell types known in a design, i.e. the same types
+// as CellTypes(design): the modules of the design and the internal cell types
+// from yosys_celltypes. Use RTLIL::Design::cell_types() to get the shared
+// table of a design instead of setting up a CellTypes for every pass (or,
+// worse, for every module). The table is checked against the modules and
+// their ports when it is acquired and only rebuilt if they have changed.
+//
+// Types are numbered densely by the index of their IdString and the ports of
+// each type are kept in a small table sorted by port name with the direction
+// flags, so that the lookups in hot loops don't need to hash.
+struct CellTypeTable
+{
+	CellTypeTable() { }
+	CellTypeTable(RTLIL::Design *design) { update(design); }
+
+	// Rebuild the table if the modules of design or their ports have
+	// changed since the last call. Returns true if it was rebuilt.
+	bool update(RTLIL::Design *design);
+
+	// Returns the dense id of type, or -1 if the type is unknown
+	int type_id(RTLIL::IdString type) const
+	{
+		if (type.index_ < GetSize(type_ids))
+			return type_ids[type.index_];
+		auto it = large_type_ids.find(type.index_);
+		return it != large_type_ids.end() ? it->second : -1;
+	}
+
+	int num_types() const { return GetSize(types); }
+	RTLIL::IdString type_name(int id) const { return types.at(id).type; }
+
+	bool cell_known(RTLIL::IdString type) const
+	{
+		return type_id(type) >= 0;
+	}
+
+	bool cell_output(RTLIL::IdString type, RTLIL::IdString port) const
+	{
+		return (port_flags(type_id(type), port) & PORT_OUTPUT) != 0;
+	}
+
+	bool cell_input(RTLIL::IdString type, RTLIL::IdString port) const
+	{
+		return (port_flags(type_id(type), port) & PORT_INPUT) != 0;
+	}
+
+	bool cell_evaluable(RTLIL::IdString type) const
+	{
+		int id = type_id(type);
+		return id >= 0 && types[id].is_evaluable;
+	}
+
+private:
+	enum : int {
+		PORT_INPUT = 1,
+		PORT_OUTPUT = 2
+	};
+
+	struct TypeEntry
+	{
+		RTLIL::IdString type;
+		bool is_evaluable;
+		// (port name index, PORT_* flags), sorted by name index
+		std::vector<std::pair<int, int>> ports;
+	};
+
+	std::vector<TypeEntry> types;
+	// Indexed by IdString::index_. Module names with a very large index go
+	// to large_type_ids instead, to keep the vector reasonably sized.
+	std::vector<int> type_ids;
+	dict<int, int> large_type_ids;
+	// Module names and port directions the table was built from
+	std::vector<int> signature;
+
+	int port_flags(int type_id, RTLIL::IdString port) const;
+	void add_type(RTLIL::IdString type, std::vector<std::pair<int, int>> &&ports, bool is_evaluable);
+	static void get_signature(RTLIL::Design *design, std::vector<int> &signature);
+};
+
 YOSYS_NAMESPACE_END
 
 #endif
@@ -24,6 +24,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
 #include "kernel/macc.h"
+#include "kernel/truthtable.h"
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -420,6 +421,431 @@ struct ConstEval
 	}
 };
 
+// Evaluates the combinational cone of a set of output signals for 64 input
+// patterns at once. The cone is levelized once in compile(), afterwards each
+// call of eval() computes the outputs for all 64 patterns that are set in the
+// bits of the input words. Only two-valued logic is supported: compile() fails
+// for cones that contain undefined constants, loops, or cell types that have
+// no evaluator, and eval() fails when a cell produces an undefined result for
+// one of the patterns. Callers should fall back to ConstEval in that case.
+struct ConstEvalBatch
+{
+	enum OpType {
+		OP_BUF, OP_AND, OP_OR, OP_XOR, OP_MUX, OP_AOI3, OP_OAI3, OP_AOI4, OP_OAI4,
+		OP_REDUCE_AND, OP_REDUCE_OR, OP_REDUCE_XOR, OP_LOGIC_AND, OP_LOGIC_OR,
+		OP_EQ, OP_ADD, OP_GENERIC
+	};
+
+	// Ports A, B, C and D are stored in the order of the CellTypes::eval()
+	// arguments, with the select input of $mux, $pmux, $bmux and $demux
+	// taking the place of the last argument.
+	struct Op
+	{
+		OpType type;
+		bool invert_b, invert_y;
+		RTLIL::Cell *cell;
+		std::vector<int> a, b, c, d, y;
+	};
+
+	RTLIL::Module *module;
+	SigMap assign_map;
+	dict<RTLIL::SigBit, RTLIL::Cell*> bit2driver;
+
+	std::vector<RTLIL::SigBit> inputs, outputs;
+	std::vector<int> input_slots, output_slots;
+	std::vector<Op> ops;
+	std::vector<uint64_t> slots;
+
+	ConstEvalBatch(RTLIL::Module *module) : module(module), assign_map(module)
+	{
+		CellTypes ct;
+		ct.setup_internals();
+		ct.setup_stdcells();
+
+		for (auto cell : module->cells()) {
+			if (!ct.cell_known(cell->type))
+				continue;
+			for (auto &conn : cell->connections())
+				if (ct.cell_output(cell->type, conn.first))
+					for (auto bit : assign_map(conn.second))
+						if (bit.wire != nullptr)
+							bit2driver.emplace(bit, cell);
+		}
+	}
+
+	bool compile_op(RTLIL::Cell *cell, dict<RTLIL::SigBit, int> &bit2slot)
+	{
+		Op op;
+		op.cell = cell;
+		op.invert_b = false;
+		op.invert_y = false;
+
+		IdString type = cell->type;
+		bool signed_a = cell->hasParam(ID::A_SIGNED) && cell->getParam(ID::A_SIGNED).as_bool();
+		bool signed_b = cell->hasParam(ID::B_SIGNED) && cell->getParam(ID::B_SIGNED).as_bool();
+		int width = GetSize(cell->getPort(ID::Y));
+
+		auto slots_of = [&](RTLIL::SigSpec sig) {
+			std::vector<int> result;
+			for (auto bit : assign_map(sig))
+				result.push_back(bit2slot.at(bit));
+			return result;
+		};
+		auto operand = [&](IdString port, bool is_signed, int w) {
+			std::vector<int> result = slots_of(cell->getPort(port));
+			if (GetSize(result) > w)
+				result.resize(w);
+			int ext = is_signed && !result.empty() ? result.back() : 0;
+			while (GetSize(result) < w)
+				result.push_back(ext);
+			return result;
+		};
+
+		if (type.in(ID($_BUF_), ID($_NOT_), ID($pos), ID($not))) {
+			op.type = OP_BUF;
+			op.invert_y = type.in(ID($_NOT_), ID($not));
+			op.a = operand(ID::A, signed_a, width);
+		} else
+		if (type.in(ID($_AND_), ID($_NAND_), ID($_ANDNOT_), ID($and), ID($_OR_), ID($_NOR_), ID($_ORNOT_), ID($or),
+				ID($_XOR_), ID($_XNOR_), ID($xor), ID($xnor))) {
+			op.type = type.in(ID($_AND_), ID($_NAND_), ID($_ANDNOT_), ID($and)) ? OP_AND :
+					type.in(ID($_OR_), ID($_NOR_), ID($_ORNOT_), ID($or)) ? OP_OR : OP_XOR;
+			op.invert_b = type.in(ID($_ANDNOT_), ID($_ORNOT_));
+			op.invert_y = type.in(ID($_NAND_), ID($_NOR_), ID($_XNOR_), ID($xnor));
+			op.a = operand(ID::A, signed_a && signed_b, width);
+			op.b = operand(ID::B, signed_a && signed_b, width);
+		} else
+		if (type.in(ID($_MUX_), ID($_NMUX_), ID($mux))) {
+			op.type = OP_MUX;
+			op.invert_y = type == ID($_NMUX_);
+			op.a = slots_of(cell->getPort(ID::A));
+			op.b = slots_of(cell->getPort(ID::B));
+			op.c = slots_of(cell->getPort(ID::S));
+		} else
+		if (type.in(ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_))) {
+			op.type = type == ID($_AOI3_) ? OP_AOI3 : type == ID($_OAI3_) ? OP_OAI3 : type == ID($_AOI4_) ? OP_AOI4 : OP_OAI4;
+			op.a = slots_of(cell->getPort(ID::A));
+			op.b = slots_of(cell->getPort(ID::B));
+			op.c = slots_of(cell->getPort(ID::C));
+			if (cell->hasPort(ID::D))
+				op.d = slots_of(cell->getPort(ID::D));
+		} else
+		if (type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool), ID($logic_not), ID($reduce_xor), ID($reduce_xnor))) {
+			op.type = type == ID($reduce_and) ? OP_REDUCE_AND : type.in(ID($reduce_xor), ID($reduce_xnor)) ? OP_REDUCE_XOR : OP_REDUCE_OR;
+			op.invert_y = type.in(ID($logic_not), ID($reduce_xnor));
+			op.a = slots_of(cell->getPort(ID::A));
+		} else
+		if (type.in(ID($logic_and), ID($logic_or))) {
+			op.type = type == ID($logic_and) ? OP_LOGIC_AND : OP_LOGIC_OR;
+			op.a = slots_of(cell->getPort(ID::A));
+			op.b = slots_of(cell->getPort(ID::B));
+		} else
+		if (type.in(ID($eq), ID($ne), ID($eqx), ID($nex))) {
+			int w = std::max(GetSize(cell->getPort(ID::A)), GetSize(cell->getPort(ID::B)));
+			op.type = OP_EQ;
+			op.invert_y = type.in(ID($ne), ID($nex));
+			op.a = operand(ID::A, signed_a && signed_b, w);
+			op.b = operand(ID::B, signed_a && signed_b, w);
+		} else
+		if (type.in(ID($add), ID($sub))) {
+			op.type = OP_ADD;
+			op.invert_b = type == ID($sub);
+			op.a = operand(ID::A, signed_a && signed_b, width);
+			op.b = operand(ID::B, signed_a && signed_b, width);
+		} else
+		if (type == ID($neg)) {
+			op.type = OP_ADD;
+			op.invert_b = true;
+			op.a = std::vector<int>(width, 0);
+			op.b = operand(ID::A, signed_a, width);
+		} else
+		if (type.in(ID($lcu), ID($alu), ID($fa), ID($macc)) || !yosys_celltypes.cell_evaluable(type)) {
+			return false;
+		} else {
+			op.type = OP_GENERIC;
+			if (cell->hasPort(ID::A))
+				op.a = slots_of(cell->getPort(ID::A));
+			if (type.in(ID($bmux), ID($demux)))
+				op.b = slots_of(cell->getPort(ID::S));
+			else if (cell->hasPort(ID::B))
+				op.b = slots_of(cell->getPort(ID::B));
+			if (type == ID($pmux))
+				op.c = slots_of(cell->getPort(ID::S));
+		}
+
+		for (auto bit : assign_map(cell->getPort(ID::Y))) {
+			int slot = GetSize(slots);
+			slots.push_back(0);
+			if (bit.wire != nullptr)
+				bit2slot[bit] = slot;
+			op.y.push_back(slot);
+		}
+
+		ops.push_back(op);
+		return true;
+	}
+
+	// Prepares the evaluation of the given outputs as functions of the given
+	// inputs. Returns false and sets undef to the offending signals if that
+	// isn't possible.
+	bool compile(const RTLIL::SigSpec &input_sig, const RTLIL::SigSpec &output_sig, RTLIL::SigSpec &undef)
+	{
+		inputs = assign_map(input_sig).bits();
+		outputs = assign_map(output_sig).bits();
+		input_slots.clear();
+		output_slots.clear();
+		ops.clear();
+		slots.assign(2, 0);
+		slots[1] = ~uint64_t(0);
+
+		dict<RTLIL::SigBit, int> bit2slot;
+		bit2slot[State::S0] = 0;
+		bit2slot[State::S1] = 1;
+		for (auto bit : inputs) {
+			if (bit.wire == nullptr) {
+				input_slots.push_back(-1);
+				continue;
+			}
+			if (!bit2slot.count(bit)) {
+				bit2slot[bit] = GetSize(slots);
+				slots.push_back(0);
+			}
+			input_slots.push_back(bit2slot.at(bit));
+		}
+
+		// Find the cells in the cone in topological order, without recursion
+		// so that deep gate-level netlists can be handled.
+		dict<RTLIL::Cell*, bool> visited;
+		std::vector<std::pair<RTLIL::Cell*, bool>> stack;
+
+		auto visit_bit = [&](RTLIL::SigBit bit) {
+			if (bit2slot.count(bit))
+				return true;
+			if (bit.wire == nullptr) {
+				undef.append(bit);
+				return false;
+			}
+			auto it = bit2driver.find(bit);
+			if (it == bit2driver.end()) {
+				undef.append(bit);
+				return false;
+			}
+			auto it2 = visited.find(it->second);
+			if (it2 != visited.end() && !it2->second) {
+				undef.append(bit);
+				return false;
+			}
+			if (it2 == visited.end())
+				stack.push_back(std::make_pair(it->second, false));
+			return true;
+		};
+
+		for (auto bit : outputs)
+		{
+			if (!visit_bit(bit))
+				return false;
+
+			while (!stack.empty())
+			{
+				RTLIL::Cell *cell = stack.back().first;
+				bool finish = stack.back().second;
+				stack.pop_back();
+
+				if (finish) {
+					visited[cell] = true;
+					if (!compile_op(cell, bit2slot)) {
+						undef.append(cell->getPort(ID::Y));
+						return false;
+					}
+					continue;
+				}
+				if (visited.count(cell))
+					continue;
+
+				if (!cell->hasPort(ID::Y)) {
+					undef.append(bit);
+					return false;
+				}
+
+				visited[cell] = false;
+				stack.push_back(std::make_pair(cell, true));
+				for (auto &conn : cell->connections()) {
+					if (yosys_celltypes.cell_output(cell->type, conn.first))
+						continue;
+					for (auto b : assign_map(conn.second))
+						if (!visit_bit(b))
+							return false;
+				}
+			}
+		}
+
+		for (auto bit : outputs)
+			output_slots.push_back(bit2slot.at(bit));
+		return true;
+	}
+
+	// Sets the values of the input with the given index for all 64 patterns.
+	void set(int index, uint64_t value)
+	{
+		if (input_slots[index] >= 0)
+			slots[input_slots[index]] = value;
+	}
+
+	uint64_t get(int index) const
+	{
+		return slots[output_slots[index]];
+	}
+
+	bool eval_generic(const Op &op)
+	{
+		RTLIL::Const arg1(State::S0, GetSize(op.a)), arg2(State::S0, GetSize(op.b)), arg3(State::S0, GetSize(op.c));
+		for (int pattern = 0; pattern < 64; pattern++)
+		{
+			for (int i = 0; i < GetSize(op.a); i++)
+				arg1.bits[i] = ((slots[op.a[i]] >> pattern) & 1) ? State::S1 : State::S0;
+			for (int i = 0; i < GetSize(op.b); i++)
+				arg2.bits[i] = ((slots[op.b[i]] >> pattern) & 1) ? State::S1 : State::S0;
+			for (int i = 0; i < GetSize(op.c); i++)
+				arg3.bits[i] = ((slots[op.c[i]] >> pattern) & 1) ? State::S1 : State::S0;
+
+			bool eval_err = false;
+			RTLIL::Const result = CellTypes::eval(op.cell, arg1, arg2, arg3, &eval_err);
+			if (eval_err || GetSize(result) < GetSize(op.y))
+				return false;
+
+			for (int i = 0; i < GetSize(op.y); i++) {
+				uint64_t &word = slots[op.y[i]];
+				if (result.bits[i] == State::S1)
+					word |= uint64_t(1) << pattern;
+				else if (result.bits[i] == State::S0)
+					word &= ~(uint64_t(1) << pattern);
+				else
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Computes the outputs for the current input words. Returns false if
+	// a cell produced an undefined value for any of the patterns.
+	bool eval()
+	{
+		for (auto &op : ops)
+		{
+			uint64_t inv_b = op.invert_b ? ~uint64_t(0) : 0;
+			uint64_t inv_y = op.invert_y ? ~uint64_t(0) : 0;
+			int width = GetSize(op.y);
+
+			switch (op.type)
+			{
+			case OP_BUF:
+				for (int i = 0; i < width; i++)
+					slots[op.y[i]] = slots[op.a[i]] ^ inv_y;
+				break;
+			case OP_AND:
+				for (int i = 0; i < width; i++)
+					slots[op.y[i]] = (slots[op.a[i]] & (slots[op.b[i]] ^ inv_b)) ^ inv_y;
+				break;
+			case OP_OR:
+				for (int i = 0; i < width; i++)
+					slots[op.y[i]] = (slots[op.a[i]] | (slots[op.b[i]] ^ inv_b)) ^ inv_y;
+				break;
+			case OP_XOR:
+				for (int i = 0; i < width; i++)
+					slots[op.y[i]] = slots[op.a[i]] ^ slots[op.b[i]] ^ inv_y;
+				break;
+			case OP_MUX: {
+				uint64_t s = slots[op.c[0]];
+				for (int i = 0; i < width; i++)
+					slots[op.y[i]] = ((slots[op.a[i]] & ~s) | (slots[op.b[i]] & s)) ^ inv_y;
+				break;
+			}
+			case OP_AOI3:
+				slots[op.y[0]] = ~((slots[op.a[0]] & slots[op.b[0]]) | slots[op.c[0]]);
+				break;
+			case OP_OAI3:
+				slots[op.y[0]] = ~((slots[op.a[0]] | slots[op.b[0]]) & slots[op.c[0]]);
+				break;
+			case OP_AOI4:
+				slots[op.y[0]] = ~((slots[op.a[0]] & slots[op.b[0]]) | (slots[op.c[0]] & slots[op.d[0]]));
+				break;
+			case OP_OAI4:
+				slots[op.y[0]] = ~((slots[op.a[0]] | slots[op.b[0]]) & (slots[op.c[0]] | slots[op.d[0]]));
+				break;
+			case OP_REDUCE_AND:
+			case OP_REDUCE_OR:
+			case OP_REDUCE_XOR: {
+				uint64_t value = op.type == OP_REDUCE_AND ? ~uint64_t(0) : 0;
+				for (int slot : op.a)
+					value = op.type == OP_REDUCE_AND ? value & slots[slot] :
+							op.type == OP_REDUCE_OR ? value | slots[slot] : value ^ slots[slot];
+				slots[op.y[0]] = value ^ inv_y;
+				for (int i = 1; i < width; i++)
+					slots[op.y[i]] = 0;
+				break;
+			}
+			case OP_LOGIC_AND:
+			case OP_LOGIC_OR: {
+				uint64_t value_a = 0, value_b = 0;
+				for (int slot : op.a)
+					value_a |= slots[slot];
+				for (int slot : op.b)
+					value_b |= slots[slot];
+				slots[op.y[0]] = op.type == OP_LOGIC_AND ? value_a & value_b : value_a | value_b;
+				for (int i = 1; i < width; i++)
+					slots[op.y[i]] = 0;
+				break;
+			}
+			case OP_EQ: {
+				uint64_t diff = 0;
+				for (int i = 0; i < GetSize(op.a); i++)
+					diff |= slots[op.a[i]] ^ slots[op.b[i]];
+				slots[op.y[0]] = ~diff ^ inv_y;
+				for (int i = 1; i < width; i++)
+					slots[op.y[i]] = 0;
+				break;
+			}
+			case OP_ADD: {
+				uint64_t carry = inv_b;
+				for (int i = 0; i < width; i++) {
+					uint64_t a = slots[op.a[i]], b = slots[op.b[i]] ^ inv_b;
+					slots[op.y[i]] = a ^ b ^ carry;
+					carry = (a & b) | (a & carry) | (b & carry);
+				}
+				break;
+			}
+			case OP_GENERIC:
+				if (!eval_generic(op))
+					return false;
+				break;
+			}
+		}
+		return true;
+	}
+
+	// Computes the complete truth tables of all outputs, with the first
+	// input as variable 0 of the tables.
+	bool eval_tables(std::vector<TruthTable> &tables)
+	{
+		int num_inputs = GetSize(inputs);
+		std::vector<TruthTable> patterns;
+		for (int i = 0; i < num_inputs; i++)
+			patterns.push_back(TruthTable::var(num_inputs, i));
+		tables.assign(GetSize(outputs), TruthTable(num_inputs));
+
+		for (int w = 0; w < TruthTable(num_inputs).num_words(); w++)
+		{
+			for (int i = 0; i < num_inputs; i++)
+				set(i, patterns[i].words[w]);
+			if (!eval())
+				return false;
+			for (int k = 0; k < GetSize(outputs); k++)
+				tables[k].words[w] = get(k);
+		}
+		return true;
+	}
+};
+
 YOSYS_NAMESPACE_END
 
 #endif
@@ -18,6 +18,7 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/profile.h"
 #include "libs/sha1/sha1.h"
 
 #ifdef YOSYS_ENABLE_READLINE
@@ -215,6 +216,7 @@ int main(int argc, char **argv)
 	std::string depsfile = "";
 	std::string topmodule = "";
 	std::string perffile = "";
+	std::string profile_file = "";
 	bool scriptfile_tcl = false;
 	bool print_banner = true;
 	bool print_stats = true;
@@ -326,6 +328,10 @@ int main(int argc, char **argv)
 		printf("    -E <depsfile>\n");
 		printf("        write a Makefile dependencies file with in- and output file names\n");
 		printf("\n");
+		printf("    -J <tracefile>\n");
+		printf("        write a profile of all executed commands (with time, memory use and\n");
+		printf("        cell counts) to the specified file, in the Chrome trace event format\n");
+		printf("\n");
 		printf("    -x <feature>\n");
 		printf("        do not print warnings for the specified experimental feature\n");
 		printf("\n");
@@ -358,7 +364,7 @@ int main(int argc, char **argv)
 	}
 
 	int opt;
-	while ((opt = getopt(argc, argv, "MXAQTVSgm:f:Hh:b:o:p:l:L:qv:tds:c:W:w:e:r:D:P:E:x:B:")) != -1)
+	while ((opt = getopt(argc, argv, "MXAQTVSgm:f:Hh:b:o:p:l:L:qv:tds:c:W:w:e:r:D:P:E:x:B:J:")) != -1)
 	{
 		switch (opt)
 		{
@@ -496,6 +502,10 @@ int main(int argc, char **argv)
 		case 'B':
 			perffile = optarg;
 			break;
+		case 'J':
+			profile_file = optarg;
+			profile_start();
+			break;
 		default:
 			fprintf(stderr, "Run '%s -h' for help.\n", argv[0]);
 			exit(1);
@@ -707,6 +717,9 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (!profile_file.empty())
+		profile_write(profile_file);
+
 #if defined(YOSYS_ENABLE_COVER) && (defined(__linux__) || defined(__FreeBSD__))
 	if (getenv("YOSYS_COVER_DIR") || getenv("YOSYS_COVER_FILE"))
 	{
@@ -17,6 +17,10 @@
 #include <string>
 #include <vector>
 
+#if defined(HASHLIB_OPEN_ADDRESSING) && defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
 namespace hashlib {
 
 const int hashtable_size_trigger = 2;
@@ -197,6 +201,157 @@ inline int hashtable_size(int min_size)
 	throw std::length_error("hash table exceeded maximum size.");
 }
 
+#ifdef HASHLIB_OPEN_ADDRESSING
+// Finalizer of MurmurHash3. The hash functions above are fast, but their low
+// bits are of poor quality, which matters for an open addressing table.
+inline unsigned int mkhash_mix(unsigned int h) {
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+// Open addressing index into the entries vector of a dict or pool, in the style
+// of a Swiss table: slots are organized in groups of 16, with one control byte
+// per slot that holds 7 bits of the hash of the entry in the slot (or marks it
+// as empty or deleted), so that a whole group can be probed with a couple of
+// SIMD instructions before any entry is looked at. The entries themselves stay
+// in a dense vector, which keeps the iteration order the same as with the
+// chained hashtable.
+class hashtable_index
+{
+	enum { group_size = 16 };
+	enum : signed char { ctrl_empty = -128, ctrl_deleted = -2 };
+
+	std::vector<signed char> ctrl;
+	std::vector<int> slots;
+	// Number of slots that are not empty, including deleted ones.
+	int used = 0;
+
+	static unsigned int match(const signed char *group, signed char value) {
+#ifdef __SSE2__
+		__m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(value)));
+#else
+		unsigned int mask = 0;
+		for (int i = 0; i < group_size; i++)
+			if (group[i] == value)
+				mask |= 1u << i;
+		return mask;
+#endif
+	}
+
+	// Slots that are empty or deleted, i.e. have a negative control byte.
+	static unsigned int match_free(const signed char *group) {
+#ifdef __SSE2__
+		return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+#else
+		unsigned int mask = 0;
+		for (int i = 0; i < group_size; i++)
+			if (group[i] < 0)
+				mask |= 1u << i;
+		return mask;
+#endif
+	}
+
+	static int lowest_bit(unsigned int mask) {
+#ifdef __GNUC__
+		return __builtin_ctz(mask);
+#else
+		int i = 0;
+		while (!(mask & 1))
+			mask >>= 1, i++;
+		return i;
+#endif
+	}
+
+	int find_slot(unsigned int hash, int index) const {
+		int group_mask = int(ctrl.size()) / group_size - 1;
+		int g = (hash >> 7) & group_mask;
+		for (int step = 1;; step++) {
+			const signed char *group = &ctrl[g * group_size];
+			for (unsigned int m = match(group, hash & 0x7f); m; m &= m - 1) {
+				int slot = g * group_size + lowest_bit(m);
+				if (slots[slot] == index)
+					return slot;
+			}
+			g = (g + step) & group_mask;
+		}
+	}
+
+public:
+	bool empty() const { return ctrl.empty(); }
+	void clear() { ctrl.clear(); slots.clear(); used = 0; }
+
+	void swap(hashtable_index &other) {
+		ctrl.swap(other.ctrl);
+		slots.swap(other.slots);
+		std::swap(used, other.used);
+	}
+
+	// Whether another insertion would exceed the maximum load factor of 7/8.
+	bool full() const { return 8 * (used + 1) > 7 * int(ctrl.size()); }
+
+	// Makes room for (at least) n entries at a load factor of 1/2.
+	void reset(int n) {
+		size_t size = group_size;
+		while (size < 2 * size_t(n))
+			size *= 2;
+		if (size > size_t(1) << 30)
+			throw std::length_error("hash table exceeded maximum size.");
+		ctrl.assign(size, ctrl_empty);
+		slots.assign(size, -1);
+		used = 0;
+	}
+
+	template<typename Pred>
+	int lookup(unsigned int hash, Pred pred) const {
+		if (ctrl.empty())
+			return -1;
+		int group_mask = int(ctrl.size()) / group_size - 1;
+		int g = (hash >> 7) & group_mask;
+		for (int step = 1;; step++) {
+			const signed char *group = &ctrl[g * group_size];
+			for (unsigned int m = match(group, hash & 0x7f); m; m &= m - 1) {
+				int index = slots[g * group_size + lowest_bit(m)];
+				if (pred(index))
+					return index;
+			}
+			if (match(group, ctrl_empty))
+				return -1;
+			g = (g + step) & group_mask;
+		}
+	}
+
+	void insert(unsigned int hash, int index) {
+		int group_mask = int(ctrl.size()) / group_size - 1;
+		int g = (hash >> 7) & group_mask;
+		for (int step = 1;; step++) {
+			unsigned int m = match_free(&ctrl[g * group_size]);
+			if (m) {
+				int slot = g * group_size + lowest_bit(m);
+				if (ctrl[slot] == ctrl_empty)
+					used++;
+				ctrl[slot] = hash & 0x7f;
+				slots[slot] = index;
+				return;
+			}
+			g = (g + step) & group_mask;
+		}
+	}
+
+	void erase(unsigned int hash, int index) {
+		ctrl[find_slot(hash, index)] = ctrl_deleted;
+	}
+
+	void renumber(unsigned int hash, int old_index, int new_index) {
+		slots[find_slot(hash, old_index)] = new_index;
+	}
+};
+#endif
+
 template<typename K, typename T, typename OPS = hash_ops<K>> class dict;
 template<typename K, int offset = 0, typename OPS = hash_ops<K>> class idict;
 template<typename K, typename OPS = hash_ops<K>> class pool;
@@ -216,7 +371,11 @@ class dict
 		bool operator<(const entry_t &other) const { return udata.first < other.udata.first; }
 	};
 
+#ifdef HASHLIB_OPEN_ADDRESSING
+	hashtable_index hashtable;
+#else
 	std::vector<int> hashtable;
+#endif
 	std::vector<entry_t> entries;
 	OPS ops;
 
@@ -228,6 +387,78 @@ class dict
 	}
 #endif
 
+#ifdef HASHLIB_OPEN_ADDRESSING
+	int do_hash(const K &key) const
+	{
+		return mkhash_mix(ops.hash(key));
+	}
+
+	void do_rehash()
+	{
+		hashtable.reset(entries.capacity());
+		for (int i = 0; i < int(entries.size()); i++)
+			hashtable.insert(do_hash(entries[i].udata.first), i);
+	}
+
+	int do_erase(int index, int hash)
+	{
+		do_assert(index < int(entries.size()));
+		if (hashtable.empty() || index < 0)
+			return 0;
+
+		hashtable.erase(hash, index);
+
+		int back_idx = entries.size()-1;
+
+		if (index != back_idx)
+		{
+			hashtable.renumber(do_hash(entries[back_idx].udata.first), back_idx, index);
+			entries[index] = std::move(entries[back_idx]);
+		}
+
+		entries.pop_back();
+
+		if (entries.empty())
+			hashtable.clear();
+
+		return 1;
+	}
+
+	int do_lookup(const K &key, int &hash) const
+	{
+		return hashtable.lookup(hash, [&](int index) { return ops.cmp(entries[index].udata.first, key); });
+	}
+
+	int do_insert(const K &key, int &hash)
+	{
+		entries.emplace_back(std::pair<K, T>(key, T()), -1);
+		if (hashtable.full())
+			do_rehash();
+		else
+			hashtable.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
+
+	int do_insert(const std::pair<K, T> &value, int &hash)
+	{
+		entries.emplace_back(value, -1);
+		if (hashtable.full())
+			do_rehash();
+		else
+			hashtable.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
+
+	int do_insert(std::pair<K, T> &&rvalue, int &hash)
+	{
+		entries.emplace_back(std::forward<std::pair<K, T>>(rvalue), -1);
+		if (hashtable.full())
+			do_rehash();
+		else
+			hashtable.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
+#else
 	int do_hash(const K &key) const
 	{
 		unsigned int hash = 0;
@@ -357,6 +588,7 @@ class dict
 		}
 		return entries.size() - 1;
 	}
+#endif
 
 public:
 	class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<K, T>>
@@ -663,7 +895,11 @@ protected:
 		entry_t(K &&udata, int next) : udata(std::move(udata)), next(next) { }
 	};
 
+#ifdef HASHLIB_OPEN_ADDRESSING
+	hashtable_index hashtable;
+#else
 	std::vector<int> hashtable;
+#endif
 	std::vector<entry_t> entries;
 	OPS ops;
 
@@ -675,6 +911,68 @@ protected:
 	}
 #endif
 
+#ifdef HASHLIB_OPEN_ADDRESSING
+	int do_hash(const K &key) const
+	{
+		return mkhash_mix(ops.hash(key));
+	}
+
+	void do_rehash()
+	{
+		hashtable.reset(entries.capacity());
+		for (int i = 0; i < int(entries.size()); i++)
+			hashtable.insert(do_hash(entries[i].udata), i);
+	}
+
+	int do_erase(int index, int hash)
+	{
+		do_assert(index < int(entries.size()));
+		if (hashtable.empty() || index < 0)
+			return 0;
+
+		hashtable.erase(hash, index);
+
+		int back_idx = entries.size()-1;
+
+		if (index != back_idx)
+		{
+			hashtable.renumber(do_hash(entries[back_idx].udata), back_idx, index);
+			entries[index] = std::move(entries[back_idx]);
+		}
+
+		entries.pop_back();
+
+		if (entries.empty())
+			hashtable.clear();
+
+		return 1;
+	}
+
+	int do_lookup(const K &key, int &hash) const
+	{
+		return hashtable.lookup(hash, [&](int index) { return ops.cmp(entries[index].udata, key); });
+	}
+
+	int do_insert(const K &value, int &hash)
+	{
+		entries.emplace_back(value, -1);
+		if (hashtable.full())
+			do_rehash();
+		else
+			hashtable.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
+
+	int do_insert(K &&rvalue, int &hash)
+	{
+		entries.emplace_back(std::forward<K>(rvalue), -1);
+		if (hashtable.full())
+			do_rehash();
+		else
+			hashtable.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
+#else
 	int do_hash(const K &key) const
 	{
 		unsigned int hash = 0;
@@ -786,6 +1084,7 @@ protected:
 		}
 		return entries.size() - 1;
 	}
+#endif
 
 public:
 	class const_iterator : public std::iterator<std::forward_iterator_tag, K>
@@ -0,0 +1,196 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/profile.h"
+
+#include <chrono>
+
+#ifdef __linux__
+#  include <unistd.h>
+#endif
+#if defined(__linux__) || defined(__FreeBSD__)
+#  include <sys/resource.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+struct ProfileEvent
+{
+	const char *category;
+	std::string name;
+	RTLIL::Design *design;
+	RTLIL::Module *module;
+	int64_t begin_us, end_us;
+	int64_t begin_cpu_ns, end_cpu_ns;
+	int64_t begin_rss, end_rss, peak_rss;
+	int begin_cells, begin_wires, end_cells, end_wires;
+};
+
+bool enabled = false;
+std::chrono::steady_clock::time_point start_time;
+std::vector<ProfileEvent> events;
+
+int64_t wall_us()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+// Current resident set size in kB, or 0 where we can't tell.
+int64_t current_rss()
+{
+#ifdef __linux__
+	FILE *f = fopen("/proc/self/statm", "r");
+	if (f == nullptr)
+		return 0;
+	long long size = 0, resident = 0;
+	if (fscanf(f, "%lld %lld", &size, &resident) != 2)
+		resident = 0;
+	fclose(f);
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+	return 0;
+#endif
+}
+
+// Peak resident set size in kB, or 0 where we can't tell.
+int64_t peak_rss()
+{
+#if defined(__linux__) || defined(__FreeBSD__)
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) == 0)
+		return ru.ru_maxrss;
+#endif
+	return 0;
+}
+
+void count_objects(ProfileEvent &ev, int &cells, int &wires)
+{
+	cells = -1;
+	wires = -1;
+	if (ev.module != nullptr) {
+		cells = GetSize(ev.module->cells_);
+		wires = GetSize(ev.module->wires_);
+	} else if (ev.design != nullptr) {
+		cells = 0;
+		wires = 0;
+		for (auto &it : ev.design->modules_) {
+			cells += GetSize(it.second->cells_);
+			wires += GetSize(it.second->wires_);
+		}
+	}
+}
+
+void write_json_string(FILE *f, const std::string &str)
+{
+	fputc('"', f);
+	for (char c : str) {
+		if (c == '"' || c == '\\')
+			fprintf(f, "\\%c", c);
+		else if ((unsigned char)c < 0x20)
+			fprintf(f, "\\u%04x", c);
+		else
+			fputc(c, f);
+	}
+	fputc('"', f);
+}
+
+}
+
+void profile_start()
+{
+	enabled = true;
+	start_time = std::chrono::steady_clock::now();
+	events.clear();
+}
+
+bool profile_enabled()
+{
+	return enabled;
+}
+
+int profile_begin(const char *category, const std::string &name, RTLIL::Design *design, RTLIL::Module *module)
+{
+	if (!enabled)
+		return -1;
+	events.emplace_back();
+	ProfileEvent &ev = events.back();
+	ev.category = category;
+	ev.name = name.empty() && module != nullptr ? RTLIL::unescape_id(module->name) : name;
+	ev.design = design;
+	ev.module = module;
+	ev.begin_us = wall_us();
+	ev.end_us = -1;
+	ev.begin_cpu_ns = PerformanceTimer::query();
+	ev.begin_rss = current_rss();
+	count_objects(ev, ev.begin_cells, ev.begin_wires);
+	return GetSize(events) - 1;
+}
+
+void profile_end(int event)
+{
+	if (event < 0)
+		return;
+	ProfileEvent &ev = events.at(event);
+	ev.end_us = wall_us();
+	ev.end_cpu_ns = PerformanceTimer::query();
+	ev.end_rss = current_rss();
+	ev.peak_rss = peak_rss();
+	count_objects(ev, ev.end_cells, ev.end_wires);
+	// The module may be deleted by a later pass.
+	ev.design = nullptr;
+	ev.module = nullptr;
+}
+
+void profile_write(const std::string &filename)
+{
+	FILE *f = fopen(filename.c_str(), "wt");
+	if (f == nullptr)
+		log_error("Can't open profile file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"displayTimeUnit\": \"ms\",\n");
+	fprintf(f, "  \"otherData\": { \"generator\": ");
+	write_json_string(f, yosys_version_str);
+	fprintf(f, " },\n");
+	fprintf(f, "  \"traceEvents\": [");
+	bool first = true;
+	for (auto &ev : events) {
+		// Events that never finished belong to a pass that was aborted by an error.
+		if (ev.end_us < 0)
+			continue;
+		fprintf(f, "%s\n    { \"name\": ", first ? "" : ",");
+		write_json_string(f, ev.name);
+		fprintf(f, ", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1", ev.category);
+		fprintf(f, ", \"ts\": %lld, \"dur\": %lld", (long long)ev.begin_us, (long long)(ev.end_us - ev.begin_us));
+		fprintf(f, ", \"args\": { \"cpu_us\": %lld", (long long)((ev.end_cpu_ns - ev.begin_cpu_ns) / 1000));
+		fprintf(f, ", \"rss_kb\": %lld, \"rss_delta_kb\": %lld, \"peak_rss_kb\": %lld",
+				(long long)ev.end_rss, (long long)(ev.end_rss - ev.begin_rss), (long long)ev.peak_rss);
+		if (ev.begin_cells >= 0)
+			fprintf(f, ", \"cells_before\": %d, \"cells_after\": %d, \"wires_before\": %d, \"wires_after\": %d",
+					ev.begin_cells, ev.end_cells, ev.begin_wires, ev.end_wires);
+		fprintf(f, " } }");
+		first = false;
+	}
+	fprintf(f, "\n  ]\n}\n");
+	fclose(f);
+}
+
+YOSYS_NAMESPACE_END
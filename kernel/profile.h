@@ -0,0 +1,60 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Recording of a pass-level profile, enabled with the -J command line option.
+//
+// Every pass invocation is recorded as an event with its wall and CPU time,
+// the resident set size (current and peak) and the number of cells and wires
+// in the design before and after the pass. Passes can add nested events for
+// the work they do on individual modules by creating a ProfileScope. The
+// events are written in the Chrome trace event format, which can be loaded
+// into chrome://tracing, Perfetto and similar viewers.
+
+void profile_start();
+bool profile_enabled();
+void profile_write(const std::string &filename);
+
+// Returns an event handle to pass to profile_end(), or -1 if profiling is
+// disabled. If a design (or a module) is given, its cell and wire counts are
+// recorded at the beginning and the end of the event. For module events the
+// name defaults to the module name.
+int profile_begin(const char *category, const std::string &name, RTLIL::Design *design = nullptr, RTLIL::Module *module = nullptr);
+void profile_end(int event);
+
+struct ProfileScope
+{
+	int event;
+
+	ProfileScope(RTLIL::Module *module) : event(profile_begin("module", std::string(), nullptr, module)) { }
+	ProfileScope(const char *category, const std::string &name) : event(profile_begin(category, name)) { }
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+	~ProfileScope() { profile_end(event); }
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
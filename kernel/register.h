@@ -45,9 +45,10 @@ struct Pass
 	struct pre_post_exec_state_t {
 		Pass *parent_pass;
 		int64_t begin_ns;
+		int profile_event;
 	};
 
-	pre_post_exec_state_t pre_execute();
+	pre_post_exec_state_t pre_execute(RTLIL::Design *design);
 	void post_execute(pre_post_exec_state_t state);
 
 	void cmd_log_args(const std::vector<std::string> &args);
@@ -1031,6 +1031,9 @@ struct RTLIL::Monitor
 // Forward declaration; defined in preproc.h.
 struct define_map_t;
 
+// Forward declaration; defined in celltypes.h.
+struct CellTypeTable;
+
 struct RTLIL::Design
 {
 	unsigned int hashidx_;
@@ -1050,9 +1053,16 @@ struct RTLIL::Design
 	dict<RTLIL::IdString, RTLIL::Selection> selection_vars;
 	std::string selected_active_module;
 
+	// Shared cell type table, see cell_types()
+	std::unique_ptr<CellTypeTable> cell_types_;
+
 	Design();
 	~Design();
 
+	// The cell types known in this design (modules and internal cells),
+	// brought up to date with the modules and their ports on each call.
+	const CellTypeTable &cell_types();
+
 	RTLIL::ObjRange<RTLIL::Module*> modules();
 	RTLIL::Module *module(const RTLIL::IdString &name);
 	const RTLIL::Module *module(const RTLIL::IdString &name) const;
@@ -231,22 +231,55 @@ class SigSet<T, sort_by_name_id_guard<T>> : public SigSet<T, RTLIL::sort_by_name
 
 struct SigMap
 {
-	mfp<SigBit> database;
+	// Union-find over the bits of a module. Every wire that takes part in a
+	// connection gets a contiguous range of nodes, so that all but the first
+	// lookup of a wire are plain array accesses instead of SigBit hashing.
+	// Constants get one node per state. Bits beyond the width a wire had when
+	// its range was allocated (its width may change later) go to extra_nodes.
+	//
+	// parents[i] is -2 for nodes of bits that are not in the database yet,
+	// -1 for roots, and the parent node otherwise.
+	//
+	// Lookups compress paths and update the wire cache, so even the const
+	// methods (apply(), operator()) modify the SigMap. It must not be shared
+	// between threads: workers need their own copy, or have to map their
+	// signals before they are started.
+	mutable std::vector<int> parents;
+	std::vector<RTLIL::SigBit> node_bits;
+	dict<const RTLIL::Wire*, std::pair<int, int>> wire_nodes;
+	dict<RTLIL::SigBit, int> extra_nodes;
+	int const_nodes[6];
+
+	mutable const RTLIL::Wire *cached_wire;
+	mutable std::pair<int, int> cached_nodes;
 
 	SigMap(RTLIL::Module *module = NULL)
 	{
+		clear();
 		if (module != NULL)
 			set(module);
 	}
 
 	void swap(SigMap &other)
 	{
-		database.swap(other.database);
+		parents.swap(other.parents);
+		node_bits.swap(other.node_bits);
+		wire_nodes.swap(other.wire_nodes);
+		extra_nodes.swap(other.extra_nodes);
+		std::swap(const_nodes, other.const_nodes);
+		std::swap(cached_wire, other.cached_wire);
+		std::swap(cached_nodes, other.cached_nodes);
 	}
 
 	void clear()
 	{
-		database.clear();
+		parents.clear();
+		node_bits.clear();
+		wire_nodes.clear();
+		extra_nodes.clear();
+		for (auto &n : const_nodes)
+			n = -1;
+		cached_wire = nullptr;
 	}
 
 	void set(RTLIL::Module *module)
@@ -255,43 +288,130 @@ struct SigMap
 		for (auto &it : module->connections())
 			bitcount += it.first.size();
 
-		database.clear();
-		database.reserve(bitcount);
+		clear();
+		parents.reserve(2 * bitcount);
+		node_bits.reserve(2 * bitcount);
 
 		for (auto &it : module->connections())
 			add(it.first, it.second);
 	}
 
+	// Returns the node of a bit, or -1 if the bit is not in the database. With
+	// create set, the bit is added to the database if necessary.
+	int node(const RTLIL::SigBit &bit, bool create) const
+	{
+		int i;
+		if (bit.wire == nullptr) {
+			i = const_nodes[bit.data];
+			if (i < 0) {
+				if (!create)
+					return -1;
+				SigMap *self = const_cast<SigMap*>(this);
+				i = self->const_nodes[bit.data] = GetSize(parents);
+				self->node_bits.push_back(bit);
+				parents.push_back(-2);
+			}
+		} else {
+			if (bit.wire != cached_wire) {
+				auto it = wire_nodes.find(bit.wire);
+				if (it == wire_nodes.end()) {
+					if (!create)
+						return -1;
+					SigMap *self = const_cast<SigMap*>(this);
+					std::pair<int, int> nodes(GetSize(parents), bit.wire->width);
+					for (int k = 0; k < nodes.second; k++)
+						self->node_bits.push_back(RTLIL::SigBit(bit.wire, k));
+					parents.resize(GetSize(parents) + nodes.second, -2);
+					it = self->wire_nodes.insert(std::make_pair(bit.wire, nodes)).first;
+				}
+				cached_wire = bit.wire;
+				cached_nodes = it->second;
+			}
+			if (bit.offset < cached_nodes.second) {
+				i = cached_nodes.first + bit.offset;
+			} else {
+				auto it = extra_nodes.find(bit);
+				if (it != extra_nodes.end()) {
+					i = it->second;
+				} else {
+					if (!create)
+						return -1;
+					SigMap *self = const_cast<SigMap*>(this);
+					i = GetSize(parents);
+					self->extra_nodes[bit] = i;
+					self->node_bits.push_back(bit);
+					parents.push_back(-2);
+				}
+			}
+		}
+		if (parents[i] == -2) {
+			if (!create)
+				return -1;
+			parents[i] = -1;
+		}
+		return i;
+	}
+
+	int ifind(int i) const
+	{
+		int p = i, k = i;
+
+		while (parents[p] != -1)
+			p = parents[p];
+
+		while (k != p) {
+			int next_k = parents[k];
+			parents[k] = p;
+			k = next_k;
+		}
+
+		return p;
+	}
+
+	void ipromote(int i)
+	{
+		int k = i;
+
+		while (k != -1) {
+			int next_k = parents[k];
+			parents[k] = i;
+			k = next_k;
+		}
+
+		parents[i] = -1;
+	}
+
 	void add(const RTLIL::SigSpec& from, const RTLIL::SigSpec& to)
 	{
 		log_assert(GetSize(from) == GetSize(to));
 
 		for (int i = 0; i < GetSize(from); i++)
 		{
-			int bfi = database.lookup(from[i]);
-			int bti = database.lookup(to[i]);
+			int bfi = ifind(node(from[i], true));
+			int bti = ifind(node(to[i], true));
 
-			const RTLIL::SigBit &bf = database[bfi];
-			const RTLIL::SigBit &bt = database[bti];
+			bool bf_wire = node_bits[bfi].wire != nullptr;
+			bool bt_wire = node_bits[bti].wire != nullptr;
 
-			if (bf.wire || bt.wire)
+			if (bf_wire || bt_wire)
 			{
-				database.imerge(bfi, bti);
+				if (bfi != bti)
+					parents[bfi] = bti;
 
-				if (bf.wire == nullptr)
-					database.ipromote(bfi);
+				if (!bf_wire)
+					ipromote(bfi);
 
-				if (bt.wire == nullptr)
-					database.ipromote(bti);
+				if (!bt_wire)
+					ipromote(bti);
 			}
 		}
 	}
 
 	void add(const RTLIL::SigBit &bit)
 	{
-		const auto &b = database.find(bit);
-		if (b.wire != nullptr)
-			database.promote(bit);
+		int i = node(bit, false);
+		if (i >= 0 && node_bits[ifind(i)].wire != nullptr)
+			ipromote(i);
 	}
 
 	void add(const RTLIL::SigSpec &sig)
@@ -304,7 +424,9 @@ struct SigMap
 
 	void apply(RTLIL::SigBit &bit) const
 	{
-		bit = database.find(bit);
+		int i = node(bit, false);
+		if (i >= 0)
+			bit = node_bits[ifind(i)];
 	}
 
 	void apply(RTLIL::SigSpec &sig) const
@@ -335,9 +457,9 @@ struct SigMap
 	RTLIL::SigSpec allbits() const
 	{
 		RTLIL::SigSpec sig;
-		for (const auto &bit : database)
-			if (bit.wire != nullptr)
-				sig.append(bit);
+		for (int i = 0; i < GetSize(parents); i++)
+			if (parents[i] != -2 && node_bits[i].wire != nullptr)
+				sig.append(node_bits[i]);
 		return sig;
 	}
 };
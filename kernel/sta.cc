@@ -0,0 +1,556 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/sta.h"
+#include "kernel/threading.h"
+
+#include <queue>
+
+YOSYS_NAMESPACE_BEGIN
+
+// Levels with fewer nodes than this are evaluated on the calling thread;
+// starting the workers would take longer than the work itself.
+static const int min_parallel_level_size = 1024;
+
+StaEngine::StaEngine(RTLIL::Module *module) : module(module), reload_pending(true), building(false), loops(false)
+{
+	module->monitors.insert(this);
+}
+
+StaEngine::~StaEngine()
+{
+	module->monitors.erase(this);
+}
+
+void StaEngine::notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &port, const RTLIL::SigSpec&, const RTLIL::SigSpec &new_sig)
+{
+	log_assert(cell->module == module);
+	if (reload_pending)
+		return;
+
+	// The old arcs are removed right away and the new ones are added by the
+	// next update(). Module::remove() disconnects all ports of a cell before
+	// deleting it, so a cell that loses its last connection is dropped from
+	// the pending cells; it has no arcs until it is connected again anyway.
+	remove_cell(cell);
+	if (new_sig.empty() && GetSize(cell->connections()) == 1 && cell->hasPort(port))
+		pending_cells.erase(cell);
+	else
+		pending_cells.insert(cell);
+}
+
+void StaEngine::notify_connect(RTLIL::Module *mod, const RTLIL::SigSig&)
+{
+	log_assert(module == mod);
+	reload_pending = true;
+}
+
+void StaEngine::notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig>&)
+{
+	log_assert(module == mod);
+	reload_pending = true;
+}
+
+void StaEngine::notify_blackout(RTLIL::Module *mod)
+{
+	log_assert(module == mod);
+	reload_pending = true;
+}
+
+void StaEngine::reload()
+{
+	reload_pending = true;
+}
+
+void StaEngine::check()
+{
+	if (reload_pending || !pending_cells.empty() || !dirty_nodes.empty())
+		update();
+}
+
+int StaEngine::node(RTLIL::SigBit bit)
+{
+	auto r = node_ids.insert(std::make_pair(bit, GetSize(node_bits)));
+	if (r.second) {
+		node_bits.push_back(bit);
+		fanin_arcs.emplace_back();
+		fanout_arcs.emplace_back();
+		node_driver.push_back(nullptr);
+		node_dst_port.emplace_back();
+		node_input.push_back(false);
+		node_output.push_back(false);
+		node_endpoints.emplace_back();
+		node_level.push_back(0);
+		node_arrival.push_back(-1);
+		node_backtrack.push_back(-1);
+	}
+	return r.first->second;
+}
+
+int StaEngine::lookup(RTLIL::SigBit bit)
+{
+	auto it = node_ids.find(sigmap(bit));
+	return it == node_ids.end() ? -1 : it->second;
+}
+
+void StaEngine::add_arc(CellInfo &info, int from, int to, int delay, RTLIL::Cell *cell, RTLIL::IdString src_port)
+{
+	int id;
+	if (free_arcs.empty()) {
+		id = GetSize(arcs);
+		arcs.emplace_back();
+	} else {
+		id = free_arcs.back();
+		free_arcs.pop_back();
+	}
+
+	Arc &arc = arcs[id];
+	arc.from = from;
+	arc.to = to;
+	arc.delay = delay;
+	arc.cell = cell;
+	arc.src_port = src_port;
+
+	fanout_arcs[from].push_back(id);
+	fanin_arcs[to].push_back(id);
+	info.arcs.push_back(id);
+
+	if (!building) {
+		if (node_level[to] <= node_level[from])
+			raise_level(to, node_level[from] + 1);
+		dirty_nodes.insert(to);
+	}
+}
+
+void StaEngine::add_cell(RTLIL::Cell *cell)
+{
+	RTLIL::Design *design = module->design;
+
+	Module *inst_module = design->module(cell->type);
+	if (!inst_module) {
+		if (unrecognised_cells.insert(cell->type).second)
+			log_warning("Cell type '%s' not recognised! Ignoring.\n", log_id(cell->type));
+		return;
+	}
+
+	if (!inst_module->get_blackbox_attribute()) {
+		log_warning("Cell type '%s' is not a black- nor white-box! Ignoring.\n", log_id(cell->type));
+		return;
+	}
+
+	IdString derived_type = cell->type;
+	if (!cell->parameters.empty()) {
+		derived_type = inst_module->derive(design, cell->parameters);
+		inst_module = design->module(derived_type);
+		log_assert(inst_module);
+	}
+
+	if (!timing.count(derived_type)) {
+		auto &t = timing.setup_module(inst_module);
+		if (t.has_inputs && t.comb.empty() && t.arrival.empty() && t.required.empty())
+			log_warning("Module '%s' has no timing arcs!\n", log_id(cell->type));
+	}
+
+	auto &t = timing.at(derived_type);
+	if (t.comb.empty() && t.arrival.empty() && t.required.empty())
+		return;
+
+	CellInfo &info = cell_info[cell];
+	pool<std::pair<int,TimingInfo::NameBit>> src_nodes, dst_nodes;
+
+	for (auto &conn : cell->connections()) {
+		auto rhs = sigmap(conn.second);
+		for (auto i = 0; i < GetSize(rhs); i++) {
+			const auto &bit = rhs[i];
+			if (!bit.wire)
+				continue;
+			int n = node(bit);
+			TimingInfo::NameBit namebit(conn.first,i);
+			if (cell->input(conn.first)) {
+				src_nodes.insert(std::make_pair(n,namebit));
+
+				auto it = t.required.find(namebit);
+				if (it == t.required.end())
+					continue;
+				node_endpoints[n].push_back({cell, conn.first, it->second.first});
+				info.endpoint_nodes.push_back(n);
+			}
+			if (cell->output(conn.first)) {
+				dst_nodes.insert(std::make_pair(n,namebit));
+				node_driver[n] = cell;
+				node_dst_port[n] = conn.first;
+				info.driven_nodes.push_back(n);
+
+				auto it = t.arrival.find(namebit);
+				if (it == t.arrival.end())
+					continue;
+				const auto &s = it->second.second;
+				if (cell->hasPort(s.name)) {
+					auto s_bit = sigmap(cell->getPort(s.name)[s.offset]);
+					if (s_bit.wire)
+						add_arc(info, node(s_bit), n, it->second.first, cell, s.name);
+				}
+			}
+		}
+	}
+
+	for (const auto &s : src_nodes)
+		for (const auto &d : dst_nodes) {
+			auto it = t.comb.find(TimingInfo::BitBit(s.second,d.second));
+			if (it == t.comb.end())
+				continue;
+			add_arc(info, s.first, d.first, it->second, cell, s.second.name);
+		}
+}
+
+void StaEngine::remove_cell(RTLIL::Cell *cell)
+{
+	auto it = cell_info.find(cell);
+	if (it == cell_info.end())
+		return;
+
+	for (int id : it->second.arcs) {
+		Arc &arc = arcs[id];
+		auto &fanout = fanout_arcs[arc.from];
+		fanout.erase(std::find(fanout.begin(), fanout.end(), id));
+		auto &fanin = fanin_arcs[arc.to];
+		fanin.erase(std::find(fanin.begin(), fanin.end(), id));
+		dirty_nodes.insert(arc.to);
+		arc.cell = nullptr;
+		free_arcs.push_back(id);
+	}
+
+	for (int n : it->second.driven_nodes)
+		if (node_driver[n] == cell) {
+			node_driver[n] = nullptr;
+			node_dst_port[n] = IdString();
+		}
+
+	for (int n : it->second.endpoint_nodes) {
+		auto &endpoints = node_endpoints[n];
+		endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+				[&](const CellEndpoint &e) { return e.cell == cell; }), endpoints.end());
+	}
+
+	cell_info.erase(it);
+}
+
+// Moves node n (and everything in its transitive fanout, as needed) to at
+// least the given level. A level that exceeds the number of nodes can only
+// be reached through a combinational loop, in which case the graph is
+// rebuilt to find all nodes affected by the loop.
+void StaEngine::raise_level(int n, int level)
+{
+	std::vector<int> worklist;
+	node_level[n] = level;
+	worklist.push_back(n);
+
+	while (!worklist.empty()) {
+		int m = worklist.back();
+		worklist.pop_back();
+		if (node_level[m] > GetSize(node_bits)) {
+			reload_pending = true;
+			return;
+		}
+		for (int id : fanout_arcs[m]) {
+			int to = arcs[id].to;
+			if (node_level[to] <= node_level[m]) {
+				node_level[to] = node_level[m] + 1;
+				worklist.push_back(to);
+			}
+		}
+	}
+}
+
+// Recomputes the arrival time of node n from its fanin, returning true if
+// its arrival time or the arc that determines it has changed.
+bool StaEngine::compute_arrival(int n)
+{
+	int arrival = -1, backtrack = -1;
+	if (node_level[n] >= 0) {
+		if (node_input[n])
+			arrival = 0;
+		for (int id : fanin_arcs[n]) {
+			const Arc &arc = arcs[id];
+			int src_arrival = node_arrival[arc.from];
+			if (src_arrival < 0 || src_arrival + arc.delay <= arrival)
+				continue;
+			arrival = src_arrival + arc.delay;
+			backtrack = id;
+		}
+	}
+
+	bool changed = arrival != node_arrival[n] || backtrack != node_backtrack[n];
+	node_arrival[n] = arrival;
+	node_backtrack[n] = backtrack;
+	return changed;
+}
+
+void StaEngine::build()
+{
+	sigmap.set(module);
+	timing = TimingInfo();
+
+	node_bits.clear();
+	node_ids.clear();
+	fanin_arcs.clear();
+	fanout_arcs.clear();
+	node_driver.clear();
+	node_dst_port.clear();
+	node_input.clear();
+	node_output.clear();
+	node_endpoints.clear();
+	node_level.clear();
+	node_arrival.clear();
+	node_backtrack.clear();
+	arcs.clear();
+	free_arcs.clear();
+	cell_info.clear();
+	pending_cells.clear();
+	dirty_nodes.clear();
+
+	building = true;
+	for (auto cell : module->cells())
+		add_cell(cell);
+	building = false;
+
+	for (auto port_name : module->ports) {
+		auto wire = module->wire(port_name);
+		for (const auto &b : sigmap(wire)) {
+			if (!b.wire)
+				continue;
+			int n = node(b);
+			if (wire->port_input)
+				node_input[n] = true;
+			if (wire->port_output)
+				node_output[n] = true;
+		}
+	}
+
+	// Levelize the graph. Nodes that are never reached are on, or in the
+	// fanout of, a combinational loop and keep level -1.
+	int num_nodes = GetSize(node_bits);
+	std::vector<int> pending_fanin(num_nodes), worklist;
+	for (int n = 0; n < num_nodes; n++) {
+		pending_fanin[n] = GetSize(fanin_arcs[n]);
+		node_level[n] = -1;
+		if (pending_fanin[n] == 0) {
+			node_level[n] = 0;
+			worklist.push_back(n);
+		}
+	}
+
+	int num_levelized = 0;
+	while (!worklist.empty()) {
+		int n = worklist.back();
+		worklist.pop_back();
+		num_levelized++;
+		for (int id : fanout_arcs[n]) {
+			int to = arcs[id].to;
+			node_level[to] = std::max(node_level[to], node_level[n] + 1);
+			if (--pending_fanin[to] == 0)
+				worklist.push_back(to);
+		}
+	}
+	loops = num_levelized < num_nodes;
+
+	// Nodes on a loop may have been given a level by their other fanin
+	if (loops)
+		for (int n = 0; n < num_nodes; n++)
+			if (pending_fanin[n] > 0)
+				node_level[n] = -1;
+
+	propagate_all();
+	reload_pending = false;
+}
+
+void StaEngine::propagate_all()
+{
+	std::vector<std::vector<int>> levels;
+	for (int n = 0; n < GetSize(node_bits); n++) {
+		node_arrival[n] = -1;
+		node_backtrack[n] = -1;
+		if (node_level[n] < 0)
+			continue;
+		if (node_level[n] >= GetSize(levels))
+			levels.resize(node_level[n] + 1);
+		levels[node_level[n]].push_back(n);
+	}
+
+	// All fanin of a node is on lower levels, so the nodes of one level can
+	// be evaluated independently of each other.
+	int max_threads = yosys_max_threads();
+	for (auto &level : levels) {
+		int num_workers = std::min(max_threads, GetSize(level) / min_parallel_level_size);
+		if (num_workers <= 1) {
+			for (int n : level)
+				compute_arrival(n);
+			continue;
+		}
+		parallel_for(num_workers, [&](int worker) {
+			for (int i = worker; i < GetSize(level); i += num_workers)
+				compute_arrival(level[i]);
+		}, num_workers);
+	}
+}
+
+void StaEngine::propagate_dirty()
+{
+	// Process the dirty nodes and their fanout in level order, so that each
+	// node is recomputed at most once.
+	typedef std::pair<int, int> entry_t;
+	std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+	pool<int> queued;
+
+	for (int n : dirty_nodes)
+		if (node_level[n] >= 0 && queued.insert(n).second)
+			queue.push(entry_t(node_level[n], n));
+	dirty_nodes.clear();
+
+	while (!queue.empty()) {
+		int n = queue.top().second;
+		queue.pop();
+		if (!compute_arrival(n))
+			continue;
+		for (int id : fanout_arcs[n]) {
+			int to = arcs[id].to;
+			if (queued.insert(to).second)
+				queue.push(entry_t(node_level[to], to));
+		}
+	}
+}
+
+void StaEngine::update()
+{
+	if (!reload_pending) {
+		pool<Cell*> cells;
+		std::swap(cells, pending_cells);
+		for (auto cell : cells) {
+			remove_cell(cell);
+			add_cell(cell);
+		}
+	}
+
+	// Incremental updates of graphs with loops are not worth the trouble
+	if (reload_pending || loops)
+		build();
+	else
+		propagate_dirty();
+}
+
+int StaEngine::arrival(RTLIL::SigBit bit)
+{
+	check();
+	int n = lookup(bit);
+	return n < 0 ? -1 : node_arrival[n];
+}
+
+bool StaEngine::driven(RTLIL::SigBit bit)
+{
+	check();
+	int n = lookup(bit);
+	return n >= 0 && (node_input[n] || node_driver[n] != nullptr);
+}
+
+StaEngine::Endpoint StaEngine::get_endpoint(int n)
+{
+	Endpoint result;
+	bool found = false;
+	for (auto &e : node_endpoints[n])
+		if (!found || result.required < e.required) {
+			result.sink = e.cell;
+			result.port = e.port;
+			result.required = e.required;
+			found = true;
+		}
+	return result;
+}
+
+std::vector<RTLIL::SigBit> StaEngine::endpoints()
+{
+	check();
+	std::vector<RTLIL::SigBit> result;
+	for (int n = 0; n < GetSize(node_bits); n++)
+		if (node_output[n] || !node_endpoints[n].empty())
+			result.push_back(node_bits[n]);
+	return result;
+}
+
+bool StaEngine::endpoint(RTLIL::SigBit bit, Endpoint *result)
+{
+	check();
+	int n = lookup(bit);
+	if (n < 0 || (!node_output[n] && node_endpoints[n].empty()))
+		return false;
+	if (result)
+		*result = get_endpoint(n);
+	return true;
+}
+
+RTLIL::SigBit StaEngine::critical_bit(int *arrival)
+{
+	check();
+	int max_node = -1, max_arrival = 0;
+	for (int n = 0; n < GetSize(node_bits); n++) {
+		// Only arrival times that are the result of a timing path count,
+		// not the arrival time of an unconnected primary input.
+		if (node_backtrack[n] < 0)
+			continue;
+		int a = node_arrival[n];
+		if (node_output[n] || !node_endpoints[n].empty())
+			a += get_endpoint(n).required;
+		if (a > max_arrival) {
+			max_node = n;
+			max_arrival = a;
+		}
+	}
+
+	if (arrival)
+		*arrival = max_node < 0 ? 0 : max_arrival;
+	return max_node < 0 ? RTLIL::SigBit() : node_bits[max_node];
+}
+
+std::vector<StaEngine::PathStep> StaEngine::critical_path(RTLIL::SigBit bit)
+{
+	check();
+	std::vector<PathStep> path;
+	for (int n = lookup(bit); n >= 0; ) {
+		PathStep step;
+		step.bit = node_bits[n];
+		step.arrival = node_arrival[n];
+		step.driver = node_driver[n];
+		step.dst_port = node_dst_port[n];
+		int id = node_backtrack[n];
+		if (id >= 0)
+			step.src_port = arcs[id].src_port;
+		path.push_back(step);
+		if (id < 0)
+			break;
+		n = arcs[id].from;
+	}
+	return path;
+}
+
+bool StaEngine::has_loops()
+{
+	check();
+	return loops;
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,165 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef STA_H
+#define STA_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+#include "kernel/timinginfo.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Static timing analysis of a single (flattened) module, based on the
+// timing arcs of the (* blackbox *) / (* whitebox *) cell types as provided
+// by TimingInfo. All primary inputs arrive at time zero.
+//
+// The timing graph is levelized when it is built, and arrival times are then
+// propagated one level at a time, with the nodes of each level evaluated in
+// parallel. The engine registers itself as a monitor of the module: changes
+// to cell connections are picked up by the next call to update(), which only
+// re-evaluates the part of the graph downstream of the changed cells. Changes
+// to the module-level connections cause a full rebuild.
+//
+// As with ModIndex, changes that do not go through the monitor interface
+// (removing wires, changing port directions, changing cell parameters) are
+// not tracked; call reload() after making them.
+struct StaEngine : public RTLIL::Monitor
+{
+	struct Endpoint
+	{
+		// The cell with the largest required time on this bit, or nullptr
+		// for a primary output that is not also a cell endpoint.
+		RTLIL::Cell *sink = nullptr;
+		RTLIL::IdString port;
+		int required = 0;
+	};
+
+	struct PathStep
+	{
+		RTLIL::SigBit bit;
+		int arrival;
+		// The cell (and its ports) driving bit along the path, or nullptr
+		// for the primary input at the start of the path.
+		RTLIL::Cell *driver;
+		RTLIL::IdString src_port, dst_port;
+	};
+
+	RTLIL::Module *module;
+	SigMap sigmap;
+
+	StaEngine(RTLIL::Module *module);
+	~StaEngine();
+
+	// Bring all arrival times up to date with the netlist.
+	void update();
+
+	// Rebuild the timing graph from scratch on the next update().
+	void reload();
+
+	// The arrival time of bit, or -1 if no timing path reaches it.
+	int arrival(RTLIL::SigBit bit);
+
+	// True if bit is a primary input or driven by a recognised cell.
+	bool driven(RTLIL::SigBit bit);
+
+	// All endpoints, i.e. inputs with a required time (setup check) of a
+	// recognised cell and primary outputs, in no particular order.
+	std::vector<RTLIL::SigBit> endpoints();
+
+	// Returns false if bit is not an endpoint.
+	bool endpoint(RTLIL::SigBit bit, Endpoint *result = nullptr);
+
+	// The bit with the latest arrival time, including the required time if
+	// it is an endpoint. Returns SigBit() if there are no timing paths.
+	RTLIL::SigBit critical_bit(int *arrival = nullptr);
+
+	// The path that determines the arrival time of bit, starting at bit and
+	// ending at the primary input it originates from.
+	std::vector<PathStep> critical_path(RTLIL::SigBit bit);
+
+	// True if the timing graph contains combinational loops. Arrival times
+	// of bits on or after a loop are reported as unknown (-1).
+	bool has_loops();
+
+	// Monitor interface, not to be called directly
+	void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &port, const RTLIL::SigSpec &old_sig, const RTLIL::SigSpec &new_sig) override;
+	void notify_connect(RTLIL::Module *mod, const RTLIL::SigSig &sigsig) override;
+	void notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig> &sigsig) override;
+	void notify_blackout(RTLIL::Module *mod) override;
+
+private:
+	struct Arc
+	{
+		int from, to, delay;
+		RTLIL::Cell *cell;
+		RTLIL::IdString src_port;
+	};
+
+	struct CellInfo
+	{
+		std::vector<int> arcs, driven_nodes, endpoint_nodes;
+	};
+
+	struct CellEndpoint
+	{
+		RTLIL::Cell *cell;
+		RTLIL::IdString port;
+		int required;
+	};
+
+	TimingInfo timing;
+	pool<RTLIL::IdString> unrecognised_cells;
+
+	bool reload_pending, building, loops;
+	pool<RTLIL::Cell*> pending_cells;
+
+	std::vector<RTLIL::SigBit> node_bits;
+	dict<RTLIL::SigBit, int> node_ids;
+	std::vector<std::vector<int>> fanin_arcs, fanout_arcs;
+	std::vector<RTLIL::Cell*> node_driver;
+	std::vector<RTLIL::IdString> node_dst_port;
+	std::vector<bool> node_input, node_output;
+	std::vector<std::vector<CellEndpoint>> node_endpoints;
+	std::vector<int> node_level, node_arrival, node_backtrack;
+
+	std::vector<Arc> arcs;
+	std::vector<int> free_arcs;
+	dict<RTLIL::Cell*, CellInfo> cell_info;
+
+	// Nodes whose arrival time needs to be recomputed
+	pool<int> dirty_nodes;
+
+	void check();
+	int node(RTLIL::SigBit bit);
+	int lookup(RTLIL::SigBit bit);
+	void add_arc(CellInfo &info, int from, int to, int delay, RTLIL::Cell *cell, RTLIL::IdString src_port);
+	void add_cell(RTLIL::Cell *cell);
+	void remove_cell(RTLIL::Cell *cell);
+	bool compute_arrival(int n);
+	void raise_level(int n, int level);
+	void build();
+	void propagate_all();
+	void propagate_dirty();
+	Endpoint get_endpoint(int n);
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/threading.h"
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <atomic>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+int yosys_max_threads()
+{
+#ifdef YOSYS_ENABLE_THREADS
+	const char *env = getenv("YOSYS_MAX_THREADS");
+	if (env != nullptr && atoi(env) > 0)
+		return atoi(env);
+	int hw_threads = std::thread::hardware_concurrency();
+	return hw_threads > 0 ? hw_threads : 1;
+#else
+	return 1;
+#endif
+}
+
+void parallel_for(int n, const std::function<void(int)> &worker, int max_threads)
+{
+	if (max_threads <= 0)
+		max_threads = yosys_max_threads();
+	int num_threads = std::min(n, max_threads);
+
+#ifdef YOSYS_ENABLE_THREADS
+	if (num_threads > 1)
+	{
+		std::atomic<int> next_index(0);
+		auto thread_main = [&]() {
+			for (int i = next_index++; i < n; i = next_index++)
+				worker(i);
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < num_threads; i++)
+			threads.emplace_back(thread_main);
+		thread_main();
+		for (auto &thread : threads)
+			thread.join();
+		return;
+	}
+#else
+	(void)num_threads;
+#endif
+
+	for (int i = 0; i < n; i++)
+		worker(i);
+}
+
+void AsyncTask::start(std::function<void()> task)
+{
+	wait();
+#ifdef YOSYS_ENABLE_THREADS
+	thread = std::thread(task);
+#else
+	deferred = task;
+#endif
+}
+
+void AsyncTask::wait()
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (thread.joinable())
+		thread.join();
+#else
+	if (deferred) {
+		auto task = std::move(deferred);
+		deferred = nullptr;
+		task();
+	}
+#endif
+}
+
+YOSYS_NAMESPACE_END
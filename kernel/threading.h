@@ -0,0 +1,76 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#include "kernel/yosys.h"
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <thread>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+// Helpers for running independent pieces of work of a pass concurrently.
+//
+// Most of the Yosys kernel is not thread safe: the log functions, creating
+// new IdStrings and modifying a design must only happen on the main thread.
+// Work handed to these helpers should therefore only operate on data that
+// was fully prepared beforehand and that is private to the individual task
+// (e.g. a separate SAT solver instance or a separate output buffer).
+//
+// When Yosys is built without ENABLE_THREADS all helpers fall back to running
+// the work on the calling thread, so callers don't need any #ifdefs.
+
+// The number of worker threads a pass should use by default. This is the
+// number of hardware threads, unless overridden by the YOSYS_MAX_THREADS
+// environment variable. Always 1 without thread support.
+int yosys_max_threads();
+
+// Call worker(i) for all i in [0, n). The calls are distributed over up to
+// max_threads threads (0 for yosys_max_threads()), in no particular order.
+// Returns after all calls have completed.
+void parallel_for(int n, const std::function<void(int)> &worker, int max_threads = 0);
+
+// A single piece of work that runs in the background while the main thread
+// continues. Without thread support the work is deferred until wait() is
+// called. The destructor waits for the task to finish.
+struct AsyncTask
+{
+	AsyncTask() { }
+	AsyncTask(std::function<void()> task) { start(task); }
+	AsyncTask(const AsyncTask &) = delete;
+	AsyncTask &operator=(const AsyncTask &) = delete;
+	~AsyncTask() { wait(); }
+
+	void start(std::function<void()> task);
+	void wait();
+
+private:
+#ifdef YOSYS_ENABLE_THREADS
+	std::thread thread;
+#else
+	std::function<void()> deferred;
+#endif
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,410 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/truthtable.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+static const uint64_t var_masks[6] = {
+	0xaaaaaaaaaaaaaaaaull, 0xccccccccccccccccull, 0xf0f0f0f0f0f0f0f0ull,
+	0xff00ff00ff00ff00ull, 0xffff0000ffff0000ull, 0xffffffff00000000ull
+};
+
+TruthTable::TruthTable(int num_vars, bool value) : num_vars(num_vars)
+{
+	log_assert(num_vars >= 0 && num_vars <= 30);
+	words.assign(num_vars > 6 ? 1 << (num_vars - 6) : 1, value ? ~uint64_t(0) : 0);
+}
+
+TruthTable TruthTable::var(int num_vars, int var)
+{
+	log_assert(var >= 0 && var < num_vars);
+	TruthTable result(num_vars);
+	for (int i = 0; i < result.num_words(); i++)
+		result.words[i] = var < 6 ? var_masks[var] : ((i >> (var - 6)) & 1) ? ~uint64_t(0) : 0;
+	return result;
+}
+
+TruthTable TruthTable::from_const(const RTLIL::Const &table, int num_vars)
+{
+	TruthTable result(num_vars);
+	int size = std::min(GetSize(table), result.num_bits());
+	for (int i = 0; i < size; i++)
+		if (table.bits[i] == State::S1)
+			result.words[i >> 6] |= uint64_t(1) << (i & 63);
+	if (num_vars < 6)
+		for (int i = result.num_bits(); i < 64; i++)
+			if (result.get(i & (result.num_bits() - 1)))
+				result.words[0] |= uint64_t(1) << i;
+	return result;
+}
+
+RTLIL::Const TruthTable::to_const() const
+{
+	RTLIL::Const result(State::S0, num_bits());
+	for (int i = 0; i < num_bits(); i++)
+		if (get(i))
+			result.bits[i] = State::S1;
+	return result;
+}
+
+static TruthTable from_lut_worker(const RTLIL::Const &table, int offset, int width, const std::vector<TruthTable> &inputs,
+		const TruthTable &const0, const TruthTable &const1)
+{
+	if (width == 0)
+		return offset < GetSize(table) && table.bits[offset] == State::S1 ? const1 : const0;
+
+	int half = 1 << (width - 1);
+	TruthTable lo = from_lut_worker(table, offset, width - 1, inputs, const0, const1);
+	TruthTable hi = from_lut_worker(table, offset + half, width - 1, inputs, const0, const1);
+	if (lo == hi)
+		return lo;
+
+	const TruthTable &sel = inputs[width - 1];
+	for (int i = 0; i < lo.num_words(); i++)
+		lo.words[i] = (lo.words[i] & ~sel.words[i]) | (hi.words[i] & sel.words[i]);
+	return lo;
+}
+
+TruthTable TruthTable::from_lut(const RTLIL::Const &table, const std::vector<TruthTable> &inputs, int num_vars)
+{
+	for (auto &input : inputs)
+		log_assert(input.num_vars == num_vars);
+	return from_lut_worker(table, 0, GetSize(inputs), inputs, TruthTable(num_vars, false), TruthTable(num_vars, true));
+}
+
+void TruthTable::set(int index, bool value)
+{
+	if (num_vars >= 6) {
+		if (value)
+			words[index >> 6] |= uint64_t(1) << (index & 63);
+		else
+			words[index >> 6] &= ~(uint64_t(1) << (index & 63));
+		return;
+	}
+	for (int i = index; i < 64; i += num_bits()) {
+		if (value)
+			words[0] |= uint64_t(1) << i;
+		else
+			words[0] &= ~(uint64_t(1) << i);
+	}
+}
+
+bool TruthTable::is_const0() const
+{
+	for (auto word : words)
+		if (word != 0)
+			return false;
+	return true;
+}
+
+bool TruthTable::is_const1() const
+{
+	for (auto word : words)
+		if (word != ~uint64_t(0))
+			return false;
+	return true;
+}
+
+int TruthTable::count_ones() const
+{
+	int count = 0;
+	for (auto word : words)
+		count += popcount(word);
+	if (num_vars < 6)
+		count >>= 6 - num_vars;
+	return count;
+}
+
+bool TruthTable::operator<(const TruthTable &other) const
+{
+	if (num_vars != other.num_vars)
+		return num_vars < other.num_vars;
+	for (int i = num_words() - 1; i >= 0; i--)
+		if (words[i] != other.words[i])
+			return words[i] < other.words[i];
+	return false;
+}
+
+TruthTable TruthTable::operator~() const
+{
+	TruthTable result = *this;
+	for (auto &word : result.words)
+		word = ~word;
+	return result;
+}
+
+TruthTable &TruthTable::operator&=(const TruthTable &other)
+{
+	log_assert(num_vars == other.num_vars);
+	for (int i = 0; i < num_words(); i++)
+		words[i] &= other.words[i];
+	return *this;
+}
+
+TruthTable &TruthTable::operator|=(const TruthTable &other)
+{
+	log_assert(num_vars == other.num_vars);
+	for (int i = 0; i < num_words(); i++)
+		words[i] |= other.words[i];
+	return *this;
+}
+
+TruthTable &TruthTable::operator^=(const TruthTable &other)
+{
+	log_assert(num_vars == other.num_vars);
+	for (int i = 0; i < num_words(); i++)
+		words[i] ^= other.words[i];
+	return *this;
+}
+
+TruthTable TruthTable::cofactor0(int var) const
+{
+	log_assert(var >= 0 && var < num_vars);
+	TruthTable result = *this;
+	if (var < 6) {
+		int shift = 1 << var;
+		for (auto &word : result.words) {
+			word &= ~var_masks[var];
+			word |= word << shift;
+		}
+	} else {
+		int step = 1 << (var - 6);
+		for (int i = 0; i < num_words(); i += 2 * step)
+			for (int j = i; j < i + step; j++)
+				result.words[j + step] = result.words[j];
+	}
+	return result;
+}
+
+TruthTable TruthTable::cofactor1(int var) const
+{
+	log_assert(var >= 0 && var < num_vars);
+	TruthTable result = *this;
+	if (var < 6) {
+		int shift = 1 << var;
+		for (auto &word : result.words) {
+			word &= var_masks[var];
+			word |= word >> shift;
+		}
+	} else {
+		int step = 1 << (var - 6);
+		for (int i = 0; i < num_words(); i += 2 * step)
+			for (int j = i; j < i + step; j++)
+				result.words[j] = result.words[j + step];
+	}
+	return result;
+}
+
+bool TruthTable::depends_on(int var) const
+{
+	log_assert(var >= 0 && var < num_vars);
+	if (var < 6) {
+		int shift = 1 << var;
+		for (auto word : words)
+			if (((word >> shift) ^ word) & ~var_masks[var])
+				return true;
+		return false;
+	}
+	int step = 1 << (var - 6);
+	for (int i = 0; i < num_words(); i += 2 * step)
+		for (int j = i; j < i + step; j++)
+			if (words[j] != words[j + step])
+				return true;
+	return false;
+}
+
+std::vector<int> TruthTable::support() const
+{
+	std::vector<int> result;
+	for (int var = 0; var < num_vars; var++)
+		if (depends_on(var))
+			result.push_back(var);
+	return result;
+}
+
+void TruthTable::flip(int var)
+{
+	log_assert(var >= 0 && var < num_vars);
+	if (var < 6) {
+		int shift = 1 << var;
+		for (auto &word : words)
+			word = ((word & var_masks[var]) >> shift) | ((word & ~var_masks[var]) << shift);
+	} else {
+		int step = 1 << (var - 6);
+		for (int i = 0; i < num_words(); i += 2 * step)
+			for (int j = i; j < i + step; j++)
+				std::swap(words[j], words[j + step]);
+	}
+}
+
+void TruthTable::swap(int var1, int var2)
+{
+	log_assert(var1 >= 0 && var1 < num_vars);
+	log_assert(var2 >= 0 && var2 < num_vars);
+	if (var1 == var2)
+		return;
+	if (var1 > var2)
+		std::swap(var1, var2);
+
+	if (var2 < 6) {
+		// Move the bits where var1 is 1 and var2 is 0 up, and the bits
+		// where var1 is 0 and var2 is 1 down.
+		int shift = (1 << var2) - (1 << var1);
+		uint64_t mask = var_masks[var1] & ~var_masks[var2];
+		for (auto &word : words)
+			word = (word & ~(mask | (mask << shift))) | ((word & mask) << shift) | ((word >> shift) & mask);
+	} else if (var1 < 6) {
+		int shift = 1 << var1;
+		int step = 1 << (var2 - 6);
+		uint64_t mask = var_masks[var1];
+		for (int i = 0; i < num_words(); i += 2 * step)
+			for (int j = i; j < i + step; j++) {
+				uint64_t w0 = words[j], w1 = words[j + step];
+				words[j] = (w0 & ~mask) | ((w1 & ~mask) << shift);
+				words[j + step] = ((w0 & mask) >> shift) | (w1 & mask);
+			}
+	} else {
+		int bit1 = 1 << (var1 - 6), bit2 = 1 << (var2 - 6);
+		for (int i = 0; i < num_words(); i++)
+			if ((i & bit1) && !(i & bit2))
+				std::swap(words[i], words[i - bit1 + bit2]);
+	}
+}
+
+TruthTable TruthTable::permute(const std::vector<int> &perm) const
+{
+	log_assert(GetSize(perm) == num_vars);
+	TruthTable result = *this;
+	std::vector<int> current(num_vars);
+	for (int i = 0; i < num_vars; i++)
+		current[i] = i;
+	for (int i = 0; i < num_vars; i++) {
+		int j = i;
+		while (current[j] != perm[i])
+			j++;
+		if (j != i) {
+			result.swap(i, j);
+			std::swap(current[i], current[j]);
+		}
+	}
+	return result;
+}
+
+TruthTable NpnTransform::apply(const TruthTable &func) const
+{
+	TruthTable result = func.permute(perm);
+	for (int i = 0; i < func.num_vars; i++)
+		if ((input_phase >> i) & 1)
+			result.flip(i);
+	if (output_phase)
+		result = ~result;
+	return result;
+}
+
+TruthTable TruthTable::npn_canonical(NpnTransform *transform) const
+{
+	NpnTransform best_transform;
+	best_transform.perm.resize(num_vars);
+	for (int i = 0; i < num_vars; i++)
+		best_transform.perm[i] = i;
+
+	if (num_vars <= 6)
+	{
+		// Exhaustive search. The input phases are enumerated in Gray code
+		// order, so that each step only flips one variable.
+		TruthTable best = *this;
+		std::vector<int> perm = best_transform.perm;
+		do {
+			TruthTable current = permute(perm);
+			uint32_t phase = 0;
+			for (int k = 0; ; k++) {
+				TruthTable inverted = ~current;
+				if (current < best) {
+					best = current;
+					best_transform.perm = perm;
+					best_transform.input_phase = phase;
+					best_transform.output_phase = false;
+				}
+				if (inverted < best) {
+					best = inverted;
+					best_transform.perm = perm;
+					best_transform.input_phase = phase;
+					best_transform.output_phase = true;
+				}
+				if (k + 1 == (1 << num_vars))
+					break;
+				int var = lowest_bit(k + 1);
+				current.flip(var);
+				phase ^= 1 << var;
+			}
+		} while (std::next_permutation(perm.begin(), perm.end()));
+
+		if (transform != nullptr)
+			*transform = best_transform;
+		return best;
+	}
+
+	// Semi-canonical form: the output is negated if more than half of the
+	// table is 1, each input is negated so that its negative cofactor has
+	// at least as many ones as the positive one, and the inputs are sorted
+	// by the number of ones in their negative cofactors.
+	best_transform.output_phase = 2 * count_ones() > num_bits();
+	TruthTable func = best_transform.output_phase ? ~*this : *this;
+
+	std::vector<int> weights(num_vars);
+	uint32_t phase = 0;
+	for (int var = 0; var < num_vars; var++) {
+		int ones0 = func.cofactor0(var).count_ones();
+		int ones1 = func.cofactor1(var).count_ones();
+		if (ones1 > ones0)
+			phase |= 1 << var;
+		weights[var] = std::max(ones0, ones1);
+	}
+
+	std::stable_sort(best_transform.perm.begin(), best_transform.perm.end(), [&](int a, int b) {
+		return weights[a] < weights[b];
+	});
+	for (int i = 0; i < num_vars; i++)
+		if ((phase >> best_transform.perm[i]) & 1)
+			best_transform.input_phase |= 1 << i;
+
+	if (transform != nullptr)
+		*transform = best_transform;
+	return best_transform.apply(*this);
+}
+
+unsigned int TruthTable::hash() const
+{
+	unsigned int h = mkhash_init;
+	h = mkhash(h, num_vars);
+	for (auto word : words)
+		h = mkhash(mkhash(h, uint32_t(word)), uint32_t(word >> 32));
+	return h;
+}
+
+std::string TruthTable::as_string() const
+{
+	std::string result;
+	for (int i = num_bits() - 1; i >= 0; i--)
+		result += get(i) ? '1' : '0';
+	return result;
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,139 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef TRUTHTABLE_H
+#define TRUTHTABLE_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+struct NpnTransform;
+
+// The truth table of a boolean function of num_vars variables, stored in
+// 64-bit words. Bit i of the table is the value of the function for the
+// input assignment i, with variable 0 as the least significant bit (the
+// same order as the LUT parameter of a $lut cell).
+//
+// Tables of fewer than 6 variables are stored in a single word, with the
+// table repeated to fill all 64 bits. This way all operations can work on
+// whole words without masking.
+struct TruthTable
+{
+	int num_vars;
+	std::vector<uint64_t> words;
+
+	TruthTable(int num_vars = 0, bool value = false);
+
+	// Number of set bits, and index of the lowest set bit (word != 0)
+	static int popcount(uint64_t word)
+	{
+#ifdef __GNUC__
+		return __builtin_popcountll(word);
+#else
+		int count = 0;
+		for (; word != 0; word &= word - 1)
+			count++;
+		return count;
+#endif
+	}
+
+	static int lowest_bit(uint64_t word)
+	{
+#ifdef __GNUC__
+		return __builtin_ctzll(word);
+#else
+		int i = 0;
+		while (!(word & 1))
+			word >>= 1, i++;
+		return i;
+#endif
+	}
+
+	static TruthTable var(int num_vars, int var);
+
+	// Undefined bits of the table are read as 0. Tables that are shorter
+	// than 2^num_vars bits are padded with 0.
+	static TruthTable from_const(const RTLIL::Const &table, int num_vars);
+	RTLIL::Const to_const() const;
+
+	// The function of num_vars variables implemented by a LUT with the given
+	// table, when the LUT inputs are driven by the functions in `inputs`.
+	static TruthTable from_lut(const RTLIL::Const &table, const std::vector<TruthTable> &inputs, int num_vars);
+
+	int num_bits() const { return 1 << num_vars; }
+	int num_words() const { return GetSize(words); }
+	bool get(int index) const { return (words[index >> 6] >> (index & 63)) & 1; }
+	void set(int index, bool value);
+
+	bool is_const0() const;
+	bool is_const1() const;
+	int count_ones() const;
+
+	bool operator==(const TruthTable &other) const { return num_vars == other.num_vars && words == other.words; }
+	bool operator!=(const TruthTable &other) const { return !(*this == other); }
+	bool operator<(const TruthTable &other) const;
+
+	TruthTable operator~() const;
+	TruthTable &operator&=(const TruthTable &other);
+	TruthTable &operator|=(const TruthTable &other);
+	TruthTable &operator^=(const TruthTable &other);
+	TruthTable operator&(const TruthTable &other) const { TruthTable result = *this; return result &= other; }
+	TruthTable operator|(const TruthTable &other) const { TruthTable result = *this; return result |= other; }
+	TruthTable operator^(const TruthTable &other) const { TruthTable result = *this; return result ^= other; }
+
+	// The cofactors have the same number of variables, the result doesn't
+	// depend on var.
+	TruthTable cofactor0(int var) const;
+	TruthTable cofactor1(int var) const;
+	bool depends_on(int var) const;
+	std::vector<int> support() const;
+
+	// Negates the input var, or exchanges the inputs var1 and var2.
+	void flip(int var);
+	void swap(int var1, int var2);
+
+	// Variable i of the result is variable perm[i] of this function.
+	TruthTable permute(const std::vector<int> &perm) const;
+
+	// The canonical representative of the NPN class (input negation, input
+	// permutation, output negation) of this function. The search is exact
+	// for up to 6 variables. Larger functions are brought into a
+	// semi-canonical form by the weights of their cofactors, so that
+	// equivalent functions usually, but not always, get the same result.
+	TruthTable npn_canonical(NpnTransform *transform = nullptr) const;
+
+	unsigned int hash() const;
+	std::string as_string() const;
+};
+
+// canonical(x) = f(y) ^ output_phase, where y[perm[i]] = x[i] ^ bit i of
+// input_phase.
+struct NpnTransform
+{
+	std::vector<int> perm;
+	uint32_t input_phase = 0;
+	bool output_phase = false;
+
+	TruthTable apply(const TruthTable &func) const;
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -201,7 +201,17 @@ contradiction:
 	}
 #endif
 
-	bool foundSolution = minisatSolver->solve(assumps);
+	bool foundSolution;
+
+	if (solverConflictBudget > 0) {
+		using namespace Minisat;
+		minisatSolver->setConfBudget(solverConflictBudget);
+		lbool result = minisatSolver->solveLimited(assumps);
+		if (result == l_Undef)
+			solverTimoutStatus = true;
+		foundSolution = result == l_True;
+	} else
+		foundSolution = minisatSolver->solve(assumps);
 
 #if defined(HAS_ALARM)
 	if (solverTimeout > 0) {
@@ -54,6 +54,7 @@ ezSAT::ezSAT()
 	cnfClausesCount = 0;
 
 	solverTimeout = 0;
+	solverConflictBudget = 0;
 	solverTimoutStatus = false;
 
 	literal("CONST_TRUE");
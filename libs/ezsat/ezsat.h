@@ -78,6 +78,7 @@ protected:
 
 public:
 	int solverTimeout;
+	int solverConflictBudget;
 	bool solverTimoutStatus;
 
 	ezSAT();
@@ -153,6 +154,12 @@ public:
 		solverTimeout = newTimeoutSeconds;
 	}
 
+	// limits each following solver call to the given number of conflicts
+	// (0 = no limit), running out is reported like a timeout
+	void setSolverConflictBudget(int newConflictBudget) {
+		solverConflictBudget = newConflictBudget;
+	}
+
 	bool getSolverTimoutStatus() {
 		return solverTimoutStatus;
 	}
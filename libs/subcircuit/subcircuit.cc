@@ -23,10 +23,12 @@
 #include <algorithm>
 #include <assert.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #ifdef _YOSYS_
 #  include "kernel/yosys.h"
+#  include "kernel/threading.h"
 #  define my_printf YOSYS_NAMESPACE_PREFIX log
 #else
 #  define my_printf printf
@@ -680,13 +682,20 @@ class SubCircuit::SolverWorker
 			}
 		}
 
+		// When several searches run concurrently, each of them passes a
+		// localCache for new results and compareCache is only read.
 		bool compare(int needleEdge, int haystackEdge, const std::map<std::string, std::set<std::set<std::string>>> &swapPorts,
-				const std::map<std::string, std::set<std::map<std::string, std::string>>> &swapPermutations)
+				const std::map<std::string, std::set<std::map<std::string, std::string>>> &swapPermutations, std::map<std::pair<int, int>, bool> *localCache = nullptr)
 		{
 			std::pair<int, int> key(needleEdge, haystackEdge);
-			if (!compareCache.count(key))
-				compareCache[key] = edgeTypes.at(needleEdge).compare(edgeTypes.at(haystackEdge), swapPorts, swapPermutations);
-			return compareCache[key];
+			auto it = compareCache.find(key);
+			if (it != compareCache.end())
+				return it->second;
+			std::map<std::pair<int, int>, bool> &cache = localCache ? *localCache : compareCache;
+			it = cache.find(key);
+			if (it == cache.end())
+				it = cache.insert(std::make_pair(key, edgeTypes.at(needleEdge).compare(edgeTypes.at(haystackEdge), swapPorts, swapPermutations))).first;
+			return it->second;
 		}
 
 		bool compare(int needleEdge, int haystackEdge, const std::map<std::string, std::string> &mapFromPorts, const std::map<std::string, std::set<std::set<std::string>>> &swapPorts,
@@ -717,6 +726,7 @@ class SubCircuit::SolverWorker
 	std::map<std::string, std::set<std::map<std::string, std::string>>> swapPermutations;
 	DiCache diCache;
 	bool verbose;
+	int maxThreads;
 
 	// main solver functions
 
@@ -880,26 +890,151 @@ class SubCircuit::SolverWorker
 		}
 	}
 
-	bool checkEnumerationMatrix(std::vector<std::set<int>> &enumerationMatrix, int i, int j, const GraphData &needle, const GraphData &haystack)
+	// The enumeration matrix holds the remaining haystack candidates for each
+	// needle node. A row is a bitset over the sorted list of haystack nodes
+	// that passed the initial node matching for that needle node, so copying
+	// and pruning the matrix are cheap word-wise operations. The edges are
+	// checked once up front: for each candidate and each needle neighbour the
+	// enumeration index stores the positions of the compatible haystack
+	// neighbours, and pruning only has to test these bits.
+
+	typedef std::vector<std::vector<uint64_t>> bitMatrix_t;
+
+	struct EnumerationRow
 	{
-		for (const auto &it_needle : needle.adjMatrix.at(i))
+		std::vector<int> candidates, neighbours;
+
+		// compatible neighbour positions for candidate c and neighbour n are
+		// compatPositions[compatOffsets[c*N+n]] .. compatPositions[compatOffsets[c*N+n+1]-1]
+		std::vector<int> compatOffsets, compatPositions;
+
+		int position(int haystackNodeIdx) const
 		{
-			int needleNeighbour = it_needle.first;
-			int needleEdgeType = it_needle.second;
+			auto it = std::lower_bound(candidates.begin(), candidates.end(), haystackNodeIdx);
+			if (it == candidates.end() || *it != haystackNodeIdx)
+				return -1;
+			return it - candidates.begin();
+		}
+	};
 
-			for (int haystackNeighbour : enumerationMatrix[needleNeighbour])
-				if (haystack.adjMatrix.at(j).count(haystackNeighbour) > 0) {
-					int haystackEdgeType = haystack.adjMatrix.at(j).at(haystackNeighbour);
-					if (diCache.compare(needleEdgeType, haystackEdgeType, swapPorts, swapPermutations)) {
-						const Graph::Node &needleFromNode = needle.graph.nodes[i];
-						const Graph::Node &needleToNode = needle.graph.nodes[needleNeighbour];
-						const Graph::Node &haystackFromNode = haystack.graph.nodes[j];
+	typedef std::vector<EnumerationRow> enumerationIndex_t;
+
+	static bool testBit(const std::vector<uint64_t> &row, int pos)
+	{
+		return (row[pos >> 6] >> (pos & 63)) & 1;
+	}
+
+	static void setBit(std::vector<uint64_t> &row, int pos)
+	{
+		row[pos >> 6] |= uint64_t(1) << (pos & 63);
+	}
+
+	static void clearBit(std::vector<uint64_t> &row, int pos)
+	{
+		row[pos >> 6] &= ~(uint64_t(1) << (pos & 63));
+	}
+
+	static int lowestBit(uint64_t word)
+	{
+#ifdef __GNUC__
+		return __builtin_ctzll(word);
+#else
+		int pos = 0;
+		while ((word & 1) == 0)
+			word >>= 1, pos++;
+		return pos;
+#endif
+	}
+
+	// call func(pos) for all bits set in row, in increasing order (func may clear bits in row)
+	template<typename F>
+	static void forEachBit(const std::vector<uint64_t> &row, F func)
+	{
+		for (int w = 0; w < int(row.size()); w++)
+			for (uint64_t word = row[w]; word != 0; word &= word - 1)
+				func(w*64 + lowestBit(word));
+	}
+
+	void generateEnumerationIndex(enumerationIndex_t &index, bitMatrix_t &enumerationMatrix, const std::vector<std::set<int>> &initialMatrix,
+			const GraphData &needle, const GraphData &haystack, std::map<std::pair<int, int>, bool> *localCompareCache)
+	{
+		int numRows = initialMatrix.size();
+
+		index.clear();
+		index.resize(numRows);
+		enumerationMatrix.clear();
+		enumerationMatrix.resize(numRows);
+
+		for (int i = 0; i < numRows; i++) {
+			index[i].candidates.assign(initialMatrix[i].begin(), initialMatrix[i].end());
+			for (const auto &it_needle : needle.adjMatrix.at(i))
+				index[i].neighbours.push_back(it_needle.first);
+			enumerationMatrix[i].resize((index[i].candidates.size() + 63) / 64);
+			for (int pos = 0; pos < int(index[i].candidates.size()); pos++)
+				setBit(enumerationMatrix[i], pos);
+		}
+
+		for (int i = 0; i < numRows; i++)
+		{
+			EnumerationRow &row = index[i];
+			const Graph::Node &needleFromNode = needle.graph.nodes[i];
+			row.compatOffsets.push_back(0);
+
+			for (int j : row.candidates)
+			{
+				const Graph::Node &haystackFromNode = haystack.graph.nodes[j];
+				const std::map<int, int> &haystackEdges = haystack.adjMatrix.at(j);
+
+				for (const auto &it_needle : needle.adjMatrix.at(i))
+				{
+					int needleNeighbour = it_needle.first;
+					int needleEdgeType = it_needle.second;
+					const Graph::Node &needleToNode = needle.graph.nodes[needleNeighbour];
+					const EnumerationRow &neighbourRow = index[needleNeighbour];
+
+					auto checkEdge = [&](int haystackNeighbour, int haystackEdgeType, int pos) {
+						if (!diCache.compare(needleEdgeType, haystackEdgeType, swapPorts, swapPermutations, localCompareCache))
+							return;
 						const Graph::Node &haystackToNode = haystack.graph.nodes[haystackNeighbour];
 						if (userSolver->userCompareEdge(needle.graphId, needleFromNode.nodeId,  needleFromNode.userData, needleToNode.nodeId,  needleToNode.userData,
 								haystack.graphId, haystackFromNode.nodeId, haystackFromNode.userData, haystackToNode.nodeId, haystackToNode.userData))
-							goto found_match;
+							row.compatPositions.push_back(pos);
+					};
+
+					if (neighbourRow.candidates.size() < haystackEdges.size()) {
+						for (int pos = 0; pos < int(neighbourRow.candidates.size()); pos++) {
+							auto it = haystackEdges.find(neighbourRow.candidates[pos]);
+							if (it != haystackEdges.end())
+								checkEdge(it->first, it->second, pos);
+						}
+					} else {
+						for (const auto &it : haystackEdges) {
+							int pos = neighbourRow.position(it.first);
+							if (pos >= 0)
+								checkEdge(it.first, it.second, pos);
+						}
 					}
+
+					row.compatOffsets.push_back(row.compatPositions.size());
 				}
+			}
+		}
+	}
+
+	bool checkEnumerationMatrix(const bitMatrix_t &enumerationMatrix, const enumerationIndex_t &index, int i, int pos) const
+	{
+		const EnumerationRow &row = index[i];
+		int numNeighbours = row.neighbours.size();
+
+		for (int n = 0; n < numNeighbours; n++)
+		{
+			const std::vector<uint64_t> &neighbourRow = enumerationMatrix[row.neighbours[n]];
+			int begin = row.compatOffsets[pos*numNeighbours + n];
+			int end = row.compatOffsets[pos*numNeighbours + n + 1];
+
+			for (int k = begin; k < end; k++)
+				if (testBit(neighbourRow, row.compatPositions[k]))
+					goto found_match;
 
 			return false;
 		found_match:;
@@ -908,7 +1043,7 @@ class SubCircuit::SolverWorker
 		return true;
 	}
 
-	bool pruneEnumerationMatrix(std::vector<std::set<int>> &enumerationMatrix, const GraphData &needle, const GraphData &haystack, int &nextRow, bool allowOverlap)
+	bool pruneEnumerationMatrix(bitMatrix_t &enumerationMatrix, const enumerationIndex_t &index, const GraphData &needle, const GraphData &haystack, int &nextRow, bool allowOverlap) const
 	{
 		bool didSomething = true;
 		while (didSomething)
@@ -916,20 +1051,19 @@ class SubCircuit::SolverWorker
 			nextRow = -1;
 			didSomething = false;
 			for (int i = 0; i < int(enumerationMatrix.size()); i++) {
-				std::set<int> newRow;
-				for (int j : enumerationMatrix[i]) {
-					if (!checkEnumerationMatrix(enumerationMatrix, i, j, needle, haystack))
+				std::vector<uint64_t> &row = enumerationMatrix[i];
+				int rowSize = 0;
+				forEachBit(row, [&](int pos) {
+					if ((!allowOverlap && haystack.usedNodes[index[i].candidates[pos]]) || !checkEnumerationMatrix(enumerationMatrix, index, i, pos)) {
+						clearBit(row, pos);
 						didSomething = true;
-					else if (!allowOverlap && haystack.usedNodes[j])
-						didSomething = true;
-					else
-						newRow.insert(j);
-				}
-				if (newRow.size() == 0)
+					} else
+						rowSize++;
+				});
+				if (rowSize == 0)
 					return false;
-				if (newRow.size() >= 2 && (nextRow < 0 || needle.adjMatrix.at(nextRow).size() < needle.adjMatrix.at(i).size()))
+				if (rowSize >= 2 && (nextRow < 0 || needle.adjMatrix.at(nextRow).size() < needle.adjMatrix.at(i).size()))
 					nextRow = i;
-				enumerationMatrix[i].swap(newRow);
 			}
 		}
 		return true;
@@ -960,10 +1094,17 @@ class SubCircuit::SolverWorker
 		}
 	}
 
-	bool checkPortmapCandidate(const std::vector<std::set<int>> &enumerationMatrix, const GraphData &needle,  const GraphData &haystack, int idx, const std::map<std::string, std::string> &currentCandidate)
+	void printEnumerationMatrix(const bitMatrix_t &enumerationMatrix, const enumerationIndex_t &index, int maxHaystackNodeIdx = -1) const
 	{
-		assert(enumerationMatrix[idx].size() == 1);
-		int idxHaystack = *enumerationMatrix[idx].begin();
+		std::vector<std::set<int>> matrix(enumerationMatrix.size());
+		for (int i = 0; i < int(enumerationMatrix.size()); i++)
+			forEachBit(enumerationMatrix[i], [&](int pos) { matrix[i].insert(index[i].candidates[pos]); });
+		printEnumerationMatrix(matrix, maxHaystackNodeIdx);
+	}
+
+	bool checkPortmapCandidate(const std::vector<int> &mapping, const GraphData &needle,  const GraphData &haystack, int idx, const std::map<std::string, std::string> &currentCandidate)
+	{
+		int idxHaystack = mapping[idx];
 
 		const Graph::Node &nn = needle.graph.nodes[idx];
 		const Graph::Node &hn = haystack.graph.nodes[idxHaystack];
@@ -977,8 +1118,7 @@ class SubCircuit::SolverWorker
 			int needleNeighbour = it_needle.first;
 			int needleEdgeType = it_needle.second;
 
-			assert(enumerationMatrix[needleNeighbour].size() == 1);
-			int haystackNeighbour = *enumerationMatrix[needleNeighbour].begin();
+			int haystackNeighbour = mapping[needleNeighbour];
 
 			assert(haystack.adjMatrix.at(idxHaystack).count(haystackNeighbour) > 0);
 			int haystackEdgeType = haystack.adjMatrix.at(idxHaystack).at(haystackNeighbour);
@@ -989,7 +1129,7 @@ class SubCircuit::SolverWorker
 		return true;
 	}
 
-	void generatePortmapCandidates(std::set<std::map<std::string, std::string>> &portmapCandidates, const std::vector<std::set<int>> &enumerationMatrix,
+	void generatePortmapCandidates(std::set<std::map<std::string, std::string>> &portmapCandidates, const std::vector<int> &mapping,
 			const GraphData &needle, const GraphData &haystack, int idx)
 	{
 		std::map<std::string, std::string> currentCandidate;
@@ -999,14 +1139,14 @@ class SubCircuit::SolverWorker
 
 		if (swapPorts.count(needle.graph.nodes[idx].typeId) == 0)
 		{
-			if (checkPortmapCandidate(enumerationMatrix, needle, haystack, idx, currentCandidate))
+			if (checkPortmapCandidate(mapping, needle, haystack, idx, currentCandidate))
 				portmapCandidates.insert(currentCandidate);
 
 			if (swapPermutations.count(needle.graph.nodes[idx].typeId) > 0)
 				for (const auto &permutation : swapPermutations.at(needle.graph.nodes[idx].typeId)) {
 					std::map<std::string, std::string> currentSubCandidate = currentCandidate;
 					applyPermutation(currentSubCandidate, permutation);
-					if (checkPortmapCandidate(enumerationMatrix, needle, haystack, idx, currentSubCandidate))
+					if (checkPortmapCandidate(mapping, needle, haystack, idx, currentSubCandidate))
 						portmapCandidates.insert(currentSubCandidate);
 				}
 		}
@@ -1025,21 +1165,21 @@ class SubCircuit::SolverWorker
 			{
 				permutateVectorToMapArray(currentCandidate, thisSwapPorts, i);
 
-				if (checkPortmapCandidate(enumerationMatrix, needle, haystack, idx, currentCandidate))
+				if (checkPortmapCandidate(mapping, needle, haystack, idx, currentCandidate))
 					portmapCandidates.insert(currentCandidate);
 
 				if (swapPermutations.count(needle.graph.nodes[idx].typeId) > 0)
 					for (const auto &permutation : swapPermutations.at(needle.graph.nodes[idx].typeId)) {
 						std::map<std::string, std::string> currentSubCandidate = currentCandidate;
 						applyPermutation(currentSubCandidate, permutation);
-						if (checkPortmapCandidate(enumerationMatrix, needle, haystack, idx, currentSubCandidate))
+						if (checkPortmapCandidate(mapping, needle, haystack, idx, currentSubCandidate))
 							portmapCandidates.insert(currentSubCandidate);
 					}
 			}
 		}
 	}
 
-	bool prunePortmapCandidates(std::vector<std::set<std::map<std::string, std::string>>> &portmapCandidates, std::vector<std::set<int>> enumerationMatrix, const GraphData &needle, const GraphData &haystack)
+	bool prunePortmapCandidates(std::vector<std::set<std::map<std::string, std::string>>> &portmapCandidates, const std::vector<int> &mapping, const GraphData &needle, const GraphData &haystack)
 	{
 		bool didSomething = false;
 
@@ -1047,8 +1187,7 @@ class SubCircuit::SolverWorker
 
 		for (int i = 0; i < int(needle.graph.nodes.size()); i++)
 		{
-			assert(enumerationMatrix[i].size() == 1);
-			int j = *enumerationMatrix[i].begin();
+			int j = mapping[i];
 
 			std::set<std::map<std::string, std::string>> thisCandidates;
 			portmapCandidates[i].swap(thisCandidates);
@@ -1060,8 +1199,7 @@ class SubCircuit::SolverWorker
 					int needleNeighbour = it_needle.first;
 					int needleEdgeType = it_needle.second;
 
-					assert(enumerationMatrix[needleNeighbour].size() == 1);
-					int haystackNeighbour = *enumerationMatrix[needleNeighbour].begin();
+					int haystackNeighbour = mapping[needleNeighbour];
 
 					assert(haystack.adjMatrix.at(j).count(haystackNeighbour) > 0);
 					int haystackEdgeType = haystack.adjMatrix.at(j).at(haystackNeighbour);
@@ -1102,14 +1240,18 @@ class SubCircuit::SolverWorker
 		return false;
 	}
 
-	void ullmannRecursion(std::vector<Solver::Result> &results, std::vector<std::set<int>> &enumerationMatrix, int iter, const GraphData &needle, GraphData &haystack, bool allowOverlap, int limitResults)
+	void ullmannRecursion(std::vector<Solver::Result> &results, bitMatrix_t &enumerationMatrix, const enumerationIndex_t &index, int iter, const GraphData &needle, GraphData &haystack, bool allowOverlap, int limitResults)
 	{
 		int i = -1;
-		if (!pruneEnumerationMatrix(enumerationMatrix, needle, haystack, i, allowOverlap))
+		if (!pruneEnumerationMatrix(enumerationMatrix, index, needle, haystack, i, allowOverlap))
 			return;
 
 		if (i < 0)
 		{
+			std::vector<int> nodeMapping(enumerationMatrix.size());
+			for (int j = 0; j < int(enumerationMatrix.size()); j++)
+				forEachBit(enumerationMatrix[j], [&](int pos) { nodeMapping[j] = index[j].candidates[pos]; });
+
 			Solver::Result result;
 			result.needleGraphId = needle.graphId;
 			result.haystackGraphId = haystack.graphId;
@@ -1121,13 +1263,13 @@ class SubCircuit::SolverWorker
 				Solver::ResultNodeMapping mapping;
 				mapping.needleNodeId = needle.graph.nodes[j].nodeId;
 				mapping.needleUserData = needle.graph.nodes[j].userData;
-				mapping.haystackNodeId = haystack.graph.nodes[*enumerationMatrix[j].begin()].nodeId;
-				mapping.haystackUserData = haystack.graph.nodes[*enumerationMatrix[j].begin()].userData;
-				generatePortmapCandidates(portmapCandidates[j], enumerationMatrix, needle, haystack, j);
+				mapping.haystackNodeId = haystack.graph.nodes[nodeMapping[j]].nodeId;
+				mapping.haystackUserData = haystack.graph.nodes[nodeMapping[j]].userData;
+				generatePortmapCandidates(portmapCandidates[j], nodeMapping, needle, haystack, j);
 				result.mappings[needle.graph.nodes[j].nodeId] = mapping;
 			}
 
-			while (prunePortmapCandidates(portmapCandidates, enumerationMatrix, needle, haystack)) { }
+			while (prunePortmapCandidates(portmapCandidates, nodeMapping, needle, haystack)) { }
 
 			if (verbose) {
 				my_printf("\nPortmapper results:\n");
@@ -1148,7 +1290,7 @@ class SubCircuit::SolverWorker
 				if (portmapCandidates[j].size() == 0) {
 					if (verbose) {
 						my_printf("\nSolution (rejected by portmapper):\n");
-						printEnumerationMatrix(enumerationMatrix, haystack.graph.nodes.size());
+						printEnumerationMatrix(enumerationMatrix, index, haystack.graph.nodes.size());
 					}
 					return;
 				}
@@ -1158,18 +1300,18 @@ class SubCircuit::SolverWorker
 			if (!userSolver->userCheckSolution(result)) {
 				if (verbose) {
 					my_printf("\nSolution (rejected by userCheckSolution):\n");
-					printEnumerationMatrix(enumerationMatrix, haystack.graph.nodes.size());
+					printEnumerationMatrix(enumerationMatrix, index, haystack.graph.nodes.size());
 				}
 				return;
 			}
 
 			for (int j = 0; j < int(enumerationMatrix.size()); j++)
-				if (!haystack.graph.nodes[*enumerationMatrix[j].begin()].shared)
-					haystack.usedNodes[*enumerationMatrix[j].begin()] = true;
+				if (!haystack.graph.nodes[nodeMapping[j]].shared)
+					haystack.usedNodes[nodeMapping[j]] = true;
 
 			if (verbose) {
 				my_printf("\nSolution:\n");
-				printEnumerationMatrix(enumerationMatrix, haystack.graph.nodes.size());
+				printEnumerationMatrix(enumerationMatrix, index, haystack.graph.nodes.size());
 			}
 
 			results.push_back(result);
@@ -1179,14 +1321,18 @@ class SubCircuit::SolverWorker
 		if (verbose) {
 			my_printf("\n");
 			my_printf("Enumeration Matrix at recursion level %d (%d):\n", iter, i);
-			printEnumerationMatrix(enumerationMatrix, haystack.graph.nodes.size());
+			printEnumerationMatrix(enumerationMatrix, index, haystack.graph.nodes.size());
 		}
 
-		std::set<int> activeRow;
+		std::vector<uint64_t> activeRow(enumerationMatrix[i].size());
 		enumerationMatrix[i].swap(activeRow);
 
-		for (int j : activeRow)
+		for (int w = 0; w < int(activeRow.size()); w++)
+		for (uint64_t word = activeRow[w]; word != 0; word &= word - 1)
 		{
+			int pos = w*64 + lowestBit(word);
+			int j = index[i].candidates[pos];
+
 			// found enough?
 			if (limitResults >= 0 && int(results.size()) >= limitResults)
 				return;
@@ -1196,13 +1342,16 @@ class SubCircuit::SolverWorker
 				continue;
 
 			// create enumeration matrix for child in recursion tree
-			std::vector<std::set<int>> nextEnumerationMatrix = enumerationMatrix;
-			for (int k = 0; k < int(nextEnumerationMatrix.size()); k++)
-				nextEnumerationMatrix[k].erase(j);
-			nextEnumerationMatrix[i].insert(j);
+			bitMatrix_t nextEnumerationMatrix = enumerationMatrix;
+			for (int k = 0; k < int(nextEnumerationMatrix.size()); k++) {
+				int p = index[k].position(j);
+				if (p >= 0)
+					clearBit(nextEnumerationMatrix[k], p);
+			}
+			setBit(nextEnumerationMatrix[i], pos);
 
 			// recursion
-			ullmannRecursion(results, nextEnumerationMatrix, iter+1, needle, haystack, allowOverlap, limitResults);
+			ullmannRecursion(results, nextEnumerationMatrix, index, iter+1, needle, haystack, allowOverlap, limitResults);
 
 			// we just have found something -> unroll to top recursion level
 			if (!allowOverlap && haystack.usedNodes[j] && iter > 0)
@@ -1210,6 +1359,17 @@ class SubCircuit::SolverWorker
 		}
 	}
 
+	void ullmannSearch(std::vector<Solver::Result> &results, const std::vector<std::set<int>> &initialMatrix, const GraphData &needle, GraphData &haystack,
+			bool allowOverlap, int limitResults, std::map<std::pair<int, int>, bool> *localCompareCache = nullptr)
+	{
+		enumerationIndex_t index;
+		bitMatrix_t enumerationMatrix;
+		generateEnumerationIndex(index, enumerationMatrix, initialMatrix, needle, haystack, localCompareCache);
+
+		haystack.usedNodes.resize(haystack.graph.nodes.size());
+		ullmannRecursion(results, enumerationMatrix, index, 0, needle, haystack, allowOverlap, limitResults);
+	}
+
 	// additional data structes and functions for mining
 
 	struct NodeSet {
@@ -1271,8 +1431,7 @@ class SubCircuit::SolverWorker
 			std::map<std::string, std::set<std::string>> initialMappings;
 			generateEnumerationMatrix(enumerationMatrix, needle, haystack, initialMappings);
 
-			haystack.usedNodes.resize(haystack.graph.nodes.size());
-			ullmannRecursion(results, enumerationMatrix, 0, needle, haystack, true, -1);
+			ullmannSearch(results, enumerationMatrix, needle, haystack, true, -1);
 		}
 
 		verbose = backupVerbose;
@@ -1469,7 +1628,7 @@ class SubCircuit::SolverWorker
 	// interface to the public solver class
 
 protected:
-	SolverWorker(Solver *userSolver) : userSolver(userSolver), verbose(false)
+	SolverWorker(Solver *userSolver) : userSolver(userSolver), verbose(false), maxThreads(1)
 	{
 	}
 
@@ -1478,6 +1637,11 @@ protected:
 		verbose = true;
 	}
 
+	void setMaxThreads(int maxThreads)
+	{
+		this->maxThreads = maxThreads;
+	}
+
 	void addGraph(std::string graphId, const Graph &graph)
 	{
 		assert(graphData.count(graphId) == 0);
@@ -1551,8 +1715,61 @@ protected:
 			printEnumerationMatrix(enumerationMatrix, haystack.graph.nodes.size());
 		}
 
-		haystack.usedNodes.resize(haystack.graph.nodes.size());
-		ullmannRecursion(results, enumerationMatrix, 0, needle, haystack, allowOverlap, maxSolutions > 0 ? results.size() + maxSolutions : -1);
+		ullmannSearch(results, enumerationMatrix, needle, haystack, allowOverlap, maxSolutions > 0 ? results.size() + maxSolutions : -1);
+	}
+
+	void solve(std::vector<Solver::Result> &results, const std::vector<std::string> &needleGraphIds, const std::vector<std::string> &haystackGraphIds,
+			bool allowOverlap, int maxSolutions)
+	{
+		std::map<std::string, std::set<std::string>> emptyInitialMappings;
+
+		if (verbose || maxThreads <= 1 || haystackGraphIds.size() <= 1) {
+			for (const auto &needleGraphId : needleGraphIds)
+			for (const auto &haystackGraphId : haystackGraphIds)
+				solve(results, needleGraphId, haystackGraphId, emptyInitialMappings, allowOverlap, maxSolutions);
+			return;
+		}
+
+		// The overlap history of a haystack depends on the order in which the
+		// needles are searched in it, so the haystacks are processed in
+		// parallel and the needles for each haystack in the given order.
+
+		int numNeedles = needleGraphIds.size();
+		int numHaystacks = haystackGraphIds.size();
+
+		std::vector<const GraphData*> needles;
+		for (const auto &needleGraphId : needleGraphIds)
+			needles.push_back(&graphData.at(needleGraphId));
+
+		std::vector<GraphData*> haystacks;
+		for (const auto &haystackGraphId : haystackGraphIds)
+			haystacks.push_back(&graphData.at(haystackGraphId));
+
+		std::vector<std::vector<std::vector<Solver::Result>>> haystackResults(numHaystacks);
+		std::vector<std::map<std::pair<int, int>, bool>> haystackCompareCaches(numHaystacks);
+
+		auto solveHaystack = [&](int h) {
+			haystackResults[h].resize(numNeedles);
+			for (int n = 0; n < numNeedles; n++) {
+				std::vector<std::set<int>> enumerationMatrix;
+				generateEnumerationMatrix(enumerationMatrix, *needles[n], *haystacks[h], emptyInitialMappings);
+				ullmannSearch(haystackResults[h][n], enumerationMatrix, *needles[n], *haystacks[h], allowOverlap, maxSolutions > 0 ? maxSolutions : -1, &haystackCompareCaches[h]);
+			}
+		};
+
+#ifdef _YOSYS_
+		YOSYS_NAMESPACE_PREFIX parallel_for(numHaystacks, solveHaystack, maxThreads);
+#else
+		for (int h = 0; h < numHaystacks; h++)
+			solveHaystack(h);
+#endif
+
+		for (int n = 0; n < numNeedles; n++)
+		for (int h = 0; h < numHaystacks; h++)
+			results.insert(results.end(), haystackResults[h][n].begin(), haystackResults[h][n].end());
+
+		for (auto &cache : haystackCompareCaches)
+			diCache.compareCache.insert(cache.begin(), cache.end());
 	}
 
 	void mine(std::vector<Solver::MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph)
@@ -1627,6 +1844,11 @@ void SubCircuit::Solver::setVerbose()
 	worker->setVerbose();
 }
 
+void SubCircuit::Solver::setMaxThreads(int maxThreads)
+{
+	worker->setMaxThreads(maxThreads);
+}
+
 void SubCircuit::Solver::addGraph(std::string graphId, const Graph &graph)
 {
 	worker->addGraph(graphId, graph);
@@ -1675,6 +1897,12 @@ void SubCircuit::Solver::solve(std::vector<Result> &results, std::string needleG
 	worker->solve(results, needleGraphId, haystackGraphId, initialMappings, allowOverlap, maxSolutions);
 }
 
+void SubCircuit::Solver::solve(std::vector<Result> &results, const std::vector<std::string> &needleGraphIds, const std::vector<std::string> &haystackGraphIds,
+		bool allowOverlap, int maxSolutions)
+{
+	worker->solve(results, needleGraphIds, haystackGraphIds, allowOverlap, maxSolutions);
+}
+
 void SubCircuit::Solver::mine(std::vector<MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph)
 {
 	worker->mine(results, minNodes, maxNodes, minMatches, limitMatchesPerGraph);
@@ -134,6 +134,7 @@ namespace SubCircuit
 		virtual ~Solver();
 
 		void setVerbose();
+		void setMaxThreads(int maxThreads);
 		void addGraph(std::string graphId, const Graph &graph);
 		void addCompatibleTypes(std::string needleTypeId, std::string haystackTypeId);
 		void addCompatibleConstants(int needleConstant, int haystackConstant);
@@ -145,6 +146,12 @@ namespace SubCircuit
 		void solve(std::vector<Result> &results, std::string needleGraphId, std::string haystackGraphId,
 				const std::map<std::string, std::set<std::string>> &initialMapping, bool allowOverlap = true, int maxSolutions = -1);
 
+		// Same as calling solve() for all needles (outer loop) and haystacks (inner loop). With
+		// setMaxThreads(n) for n > 1 the haystacks are searched in parallel, so the user callbacks
+		// may be called concurrently for different haystacks. (Only in Yosys builds with threads.)
+		void solve(std::vector<Result> &results, const std::vector<std::string> &needleGraphIds, const std::vector<std::string> &haystackGraphIds,
+				bool allowOverlap = true, int maxSolutions = -1);
+
 		void mine(std::vector<MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph = -1);
 
 		void clearOverlapHistory();
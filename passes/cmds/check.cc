@@ -96,6 +96,8 @@ struct CheckPass : public Pass {
 
 		log_header(design, "Executing CHECK pass (checking for obvious problems).\n");
 
+		const CellTypeTable &ct = design->cell_types();
+
 		for (auto module : design->selected_whole_modules_warn())
 		{
 			log("Checking module %s...\n", log_id(module));
@@ -160,9 +162,9 @@ struct CheckPass : public Pass {
 					counter++;
 				cell_allowed:;
 				}
+				bool logic_cell = ct.cell_evaluable(cell->type);
 				for (auto &conn : cell->connections()) {
 					SigSpec sig = sigmap(conn.second);
-					bool logic_cell = yosys_celltypes.cell_evaluable(cell->type);
 					if (cell->input(conn.first))
 						for (auto bit : sig)
 							if (bit.wire) {
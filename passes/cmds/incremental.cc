@@ -0,0 +1,347 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "backends/rtlil/rtlil_backend.h"
+#include "libs/sha1/sha1.h"
+
+#include <sys/stat.h>
+#if defined(_WIN32)
+#  include <direct.h>
+#  include <process.h>
+#else
+#  include <unistd.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct IncrementalWorker
+{
+	RTLIL::Design *design;
+	std::string cache_dir, command;
+	bool ignore_src = false;
+
+	dict<RTLIL::Module*, std::string> keys;
+
+	IncrementalWorker(RTLIL::Design *design) : design(design) { }
+
+	// The RTLIL of a module, with all auto-generated ($-prefixed) names
+	// renumbered in order of their first appearance. These names contain the
+	// global autoidx counter, so without this a change in one module would
+	// change the text of all modules read after it. Names that are visible
+	// outside the module are kept: the name of the module (e.g. "$paramod..."),
+	// its ports, and the ports of the cells.
+	std::string canonical_text(RTLIL::Module *module)
+	{
+		std::stringstream buf;
+		RTLIL_BACKEND::dump_module(buf, "", module, design, false);
+
+		pool<std::string> external;
+		external.insert(module->name.str());
+		for (auto port : module->ports)
+			external.insert(port.str());
+
+		dict<std::string, int> renumber;
+		std::string text, line;
+		bool in_cell = false;
+		while (std::getline(buf, line))
+		{
+			size_t first = line.find_first_not_of(' ');
+			if (ignore_src && first != std::string::npos && line.compare(first, 15, "attribute \\src ") == 0)
+				continue;
+
+			// The port name in a "connect" line of a cell
+			size_t cell_port = std::string::npos;
+			if (first != std::string::npos) {
+				if (line.compare(first, 5, "cell ") == 0)
+					in_cell = true;
+				else if (line.compare(first, 3, "end") == 0)
+					in_cell = false;
+				else if (in_cell && line.compare(first, 8, "connect ") == 0)
+					cell_port = first + 8;
+			}
+
+			bool in_string = false, after_cell = false;
+			for (size_t i = 0; i < line.size();)
+			{
+				char ch = line[i];
+				if (in_string) {
+					if (ch == '\\' && i+1 < line.size())
+						text += line[i++];
+					else if (ch == '"')
+						in_string = false;
+					text += line[i++];
+					continue;
+				}
+				if (ch == '"') {
+					in_string = true;
+					text += line[i++];
+					continue;
+				}
+				if (ch == '$' && (i == 0 || line[i-1] == ' ')) {
+					size_t end = line.find(' ', i);
+					if (end == std::string::npos)
+						end = line.size();
+					std::string tok = line.substr(i, end - i);
+					// The cell type of internal cells must not be renamed.
+					if (after_cell || i == cell_port || external.count(tok))
+						text += tok;
+					else {
+						auto it = renumber.find(tok);
+						if (it == renumber.end())
+							it = renumber.emplace(tok, GetSize(renumber)).first;
+						text += stringf("$%d", it->second);
+					}
+					after_cell = false;
+					i = end;
+					continue;
+				}
+				if (ch != ' ' && (i == 0 || line[i-1] == ' '))
+					after_cell = line.compare(i, 5, "cell ") == 0;
+				text += line[i++];
+			}
+			text += "\n";
+		}
+		return text;
+	}
+
+	// The cache key of a module covers the module itself, all modules it
+	// instantiates (recursively), the command and the Yosys version.
+	const std::string &module_key(RTLIL::Module *module)
+	{
+		auto it = keys.find(module);
+		if (it != keys.end())
+			return it->second;
+
+		std::string data = stringf("%s\n%s\n%d\n", yosys_version_str, command.c_str(), ignore_src);
+		data += canonical_text(module);
+		for (auto cell : module->cells()) {
+			RTLIL::Module *child = design->module(cell->type);
+			if (child != nullptr)
+				data += stringf("%s %s\n", log_id(cell->type), module_key(child).c_str());
+		}
+		return keys[module] = sha1(data);
+	}
+
+	std::string cache_file(RTLIL::Module *module)
+	{
+		return cache_dir + "/" + module_key(module) + ".il";
+	}
+
+	void add_with_children(pool<RTLIL::IdString> &names, RTLIL::Module *module)
+	{
+		if (!names.insert(module->name).second)
+			return;
+		for (auto cell : module->cells()) {
+			RTLIL::Module *child = module->design->module(cell->type);
+			if (child != nullptr)
+				add_with_children(names, child);
+		}
+	}
+
+	// Store the result for one module: the module itself and all modules it
+	// instantiates that were created by the command. A file without any
+	// module records that the command removed the module.
+	void write_cache(RTLIL::Module *module, RTLIL::Design *work, const pool<RTLIL::IdString> &input_names)
+	{
+		std::string filename = cache_file(module);
+		std::string tmp_filename = stringf("%s.%d.tmp", filename.c_str(), getpid());
+		std::ofstream f(tmp_filename.c_str());
+		if (f.fail()) {
+			log_warning("Can't write cache file `%s'.\n", tmp_filename.c_str());
+			return;
+		}
+
+		f << stringf("autoidx %d\n", autoidx);
+		RTLIL::Module *result = work->module(module->name);
+		if (result != nullptr) {
+			pool<RTLIL::IdString> names;
+			add_with_children(names, result);
+			for (auto mod : work->modules())
+				if (mod == result || (names.count(mod->name) && !input_names.count(mod->name)))
+					RTLIL_BACKEND::dump_module(f, "", mod, work, false);
+		}
+		f.close();
+
+		if (f.fail() || rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+			log_warning("Can't write cache file `%s'.\n", filename.c_str());
+			remove(tmp_filename.c_str());
+		}
+	}
+
+	// Replace a module in the design by the modules from a result design.
+	void replace_module(RTLIL::Module *module, RTLIL::Design *result, const pool<RTLIL::IdString> &input_names, bool from_work)
+	{
+		RTLIL::IdString name = module->name;
+		design->remove(module);
+
+		RTLIL::Module *mod = result->module(name);
+		if (mod == nullptr)
+			return;
+
+		pool<RTLIL::IdString> names;
+		add_with_children(names, mod);
+		for (auto m : result->modules()) {
+			if (m != mod && (!names.count(m->name) || input_names.count(m->name)))
+				continue;
+			if (m != mod && design->module(m->name) != nullptr)
+				continue;
+			design->add(m->clone());
+		}
+		log_debug("Replaced module %s from %s.\n", log_id(name), from_work ? "new result" : "cache");
+	}
+
+	void run()
+	{
+		std::vector<RTLIL::Module*> hits, misses;
+		pool<RTLIL::IdString> input_names;
+
+		for (auto module : design->modules()) {
+			input_names.insert(module->name);
+			if (module->get_blackbox_attribute())
+				continue;
+			if (check_file_exists(cache_file(module)))
+				hits.push_back(module);
+			else
+				misses.push_back(module);
+		}
+
+		log("Found %d of %d modules in the cache.\n", GetSize(hits), GetSize(hits) + GetSize(misses));
+
+		RTLIL::Design *work = nullptr;
+		if (!misses.empty())
+		{
+			// Run the command on a copy of the modules that are not in the
+			// cache, together with all the modules they instantiate.
+			pool<RTLIL::IdString> names;
+			for (auto module : misses)
+				add_with_children(names, module);
+
+			work = new RTLIL::Design;
+			for (auto module : design->modules())
+				if (names.count(module->name))
+					work->add(module->clone());
+
+			log_header(design, "Executing `%s' on %d modules.\n", command.c_str(), GetSize(work->modules()));
+			log_push();
+			Pass::call(work, command);
+			log_pop();
+
+			for (auto module : misses)
+				write_cache(module, work, input_names);
+		}
+
+		for (auto module : misses)
+			replace_module(module, work, input_names, true);
+
+		for (auto module : hits) {
+			RTLIL::Design *cached = new RTLIL::Design;
+			Frontend::frontend_call(cached, nullptr, cache_file(module), "rtlil");
+			replace_module(module, cached, input_names, false);
+			delete cached;
+		}
+
+		delete work;
+	}
+};
+
+struct IncrementalPass : public Pass {
+	IncrementalPass() : Pass("incremental", "run a command on modules that are not in a cache") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    incremental [options] -dir <cachedir> <command>\n");
+		log("\n");
+		log("Run the specified command (which may be a sequence of commands separated by\n");
+		log("semicolons) only on the modules whose result is not already in the cache\n");
+		log("directory, and take the results for all other modules from the cache. The\n");
+		log("results of the command are added to the cache.\n");
+		log("\n");
+		log("The cache is keyed on the RTLIL of each module and all modules it instantiates,\n");
+		log("the command and the Yosys version. Names of auto-generated ($-prefixed) wires,\n");
+		log("cells, etc. are not part of the key, but the names of modules and ports are.\n");
+		log("The command is run on a separate design that contains the modules that are not\n");
+		log("in the cache and the modules they instantiate, so it should treat the modules\n");
+		log("independently, e.g. it must not select a new top module. Blackbox modules are\n");
+		log("kept as they are.\n");
+		log("\n");
+		log("    -dir <cachedir>\n");
+		log("        Directory for the cached results. It is created if necessary.\n");
+		log("\n");
+		log("    -ignore-src\n");
+		log("        Ignore \"src\" attributes when comparing modules, so that a module is\n");
+		log("        found in the cache even if it moved in the source file. The \"src\"\n");
+		log("        attributes of results taken from the cache may then be outdated.\n");
+		log("\n");
+		log("Example:\n");
+		log("\n");
+		log("    read_verilog design.v\n");
+		log("    hierarchy -check -top top\n");
+		log("    incremental -dir .yosys_cache \"proc; opt; techmap; opt; abc; opt_clean\"\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		IncrementalWorker worker(design);
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-dir" && argidx+1 < args.size()) {
+				worker.cache_dir = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-ignore-src") {
+				worker.ignore_src = true;
+				continue;
+			}
+			break;
+		}
+
+		if (worker.cache_dir.empty())
+			log_cmd_error("Missing -dir option.\n");
+		if (argidx >= args.size())
+			log_cmd_error("Missing command.\n");
+
+		for (; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (GetSize(arg) >= 2 && arg.front() == '"' && arg.back() == '"')
+				arg = arg.substr(1, GetSize(arg) - 2);
+			worker.command += (worker.command.empty() ? "" : " ") + arg;
+		}
+
+		log_header(design, "Executing INCREMENTAL pass (cache in `%s').\n", worker.cache_dir.c_str());
+
+		if (!check_file_exists(worker.cache_dir)) {
+#if defined(_WIN32)
+			_mkdir(worker.cache_dir.c_str());
+#else
+			mkdir(worker.cache_dir.c_str(), 0777);
+#endif
+			if (!check_file_exists(worker.cache_dir))
+				log_cmd_error("Can't create cache directory `%s'.\n", worker.cache_dir.c_str());
+		}
+
+		worker.run();
+	}
+} IncrementalPass;
+
+PRIVATE_NAMESPACE_END
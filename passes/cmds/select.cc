@@ -54,6 +54,174 @@ static bool match_ids(RTLIL::IdString id, const std::string &pattern)
 	return false;
 }
 
+// The names of one kind of object of a module, for matching them against
+// patterns with match_ids().
+struct NameIndex
+{
+	// The names, in the iteration order of the module
+	std::vector<RTLIL::IdString> names;
+	// Positions in names, sorted by name. This is only built when the names
+	// are searched a second time; for a single search a scan is faster.
+	std::vector<int> sorted;
+	// Positions of the auto-generated names, by the part after their last
+	// '$' (e.g. "$42" for "$and$foo.v:3$42"). Built together with sorted.
+	dict<std::string, std::vector<int>> dollar_suffixes;
+	int searches = 0;
+
+	// Calls callback(i) for all names[i] matching pattern, in increasing
+	// order of i.
+	template<typename F>
+	void match(const std::string &pattern, F callback)
+	{
+		// Everything match_ids() accepts starts with the literal prefix of
+		// the pattern, possibly after a backslash. The exception are the
+		// patterns starting with '$', which can also be equal to the last
+		// part of an auto-generated name.
+		std::string prefix = pattern.substr(0, pattern.find_first_of("\\?*["));
+		if (prefix.empty() || searches++ == 0) {
+			for (int i = 0; i < GetSize(names); i++)
+				if (match_ids(names[i], pattern))
+					callback(i);
+			return;
+		}
+
+		if (GetSize(sorted) != GetSize(names)) {
+			sorted.resize(GetSize(names));
+			for (int i = 0; i < GetSize(names); i++)
+				sorted[i] = i;
+			std::sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+				return strcmp(names[a].c_str(), names[b].c_str()) < 0;
+			});
+			dollar_suffixes.clear();
+			for (int i = 0; i < GetSize(names); i++) {
+				const char *id_c = names[i].c_str();
+				const char *q = strrchr(id_c, '$');
+				if (*id_c == '$' && q != id_c)
+					dollar_suffixes[q].push_back(i);
+			}
+		}
+
+		std::vector<int> candidates;
+		for (auto &p : {prefix, "\\" + prefix}) {
+			auto it = std::lower_bound(sorted.begin(), sorted.end(), p, [&](int i, const std::string &str) {
+				return strcmp(names[i].c_str(), str.c_str()) < 0;
+			});
+			for (; it != sorted.end() && strncmp(names[*it].c_str(), p.c_str(), p.size()) == 0; ++it)
+				candidates.push_back(*it);
+		}
+		if (prefix[0] == '$') {
+			auto it = dollar_suffixes.find(pattern);
+			if (it != dollar_suffixes.end())
+				candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+		}
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+		for (int i : candidates)
+			if (match_ids(names[i], pattern))
+				callback(i);
+	}
+};
+
+// The objects of a module with name and connectivity indexes. All selection
+// expressions evaluated by the same command share these. The design does
+// not change while a command evaluates its selection arguments, so the
+// indexes are simply discarded at the start of the next command.
+struct ModuleIndex
+{
+	std::vector<RTLIL::Wire*> wires;
+	std::vector<RTLIL::Cell*> cells;
+	NameIndex wire_names, cell_names, cell_types, memory_names, process_names;
+
+	// Connectivity, only set up for the %x, %ci and %co operators
+	bool has_connectivity = false;
+	dict<RTLIL::IdString, int> wire_ids, cell_ids;
+	// For each cell the connected wires, and for each wire the connected
+	// cells, with the port names. There is one entry per chunk.
+	std::vector<std::vector<std::pair<int, RTLIL::IdString>>> cell_wires, wire_cells;
+	// For each wire the wires connected to it by module connections, with
+	// the wire on the left hand side (conn_lhs) or right hand side (conn_rhs)
+	std::vector<std::vector<int>> conn_lhs, conn_rhs;
+
+	ModuleIndex(RTLIL::Module *module)
+	{
+		for (auto wire : module->wires()) {
+			wires.push_back(wire);
+			wire_names.names.push_back(wire->name);
+		}
+		for (auto cell : module->cells()) {
+			cells.push_back(cell);
+			cell_names.names.push_back(cell->name);
+			cell_types.names.push_back(cell->type);
+		}
+		for (auto &it : module->memories)
+			memory_names.names.push_back(it.first);
+		for (auto &it : module->processes)
+			process_names.names.push_back(it.first);
+	}
+
+	void setup_connectivity(RTLIL::Module *module)
+	{
+		if (has_connectivity)
+			return;
+		has_connectivity = true;
+
+		for (int i = 0; i < GetSize(wires); i++)
+			wire_ids[wires[i]->name] = i;
+		for (int i = 0; i < GetSize(cells); i++)
+			cell_ids[cells[i]->name] = i;
+
+		cell_wires.resize(GetSize(cells));
+		wire_cells.resize(GetSize(wires));
+		for (int i = 0; i < GetSize(cells); i++)
+			for (auto &conn : cells[i]->connections())
+				for (auto &chunk : conn.second.chunks())
+					if (chunk.wire != nullptr) {
+						int w = wire_ids.at(chunk.wire->name);
+						cell_wires[i].push_back(std::make_pair(w, conn.first));
+						wire_cells[w].push_back(std::make_pair(i, conn.first));
+					}
+
+		conn_lhs.resize(GetSize(wires));
+		conn_rhs.resize(GetSize(wires));
+		for (auto &conn : module->connections())
+			for (int i = 0; i < GetSize(conn.first); i++) {
+				RTLIL::SigBit lhs_bit = conn.first[i], rhs_bit = conn.second[i];
+				if (lhs_bit.wire == nullptr || rhs_bit.wire == nullptr)
+					continue;
+				int l = wire_ids.at(lhs_bit.wire->name), r = wire_ids.at(rhs_bit.wire->name);
+				conn_lhs[r].push_back(l);
+				conn_rhs[l].push_back(r);
+			}
+	}
+};
+
+struct SelectIndex
+{
+	std::map<RTLIL::Module*, ModuleIndex> modules;
+
+	ModuleIndex &get(RTLIL::Module *module)
+	{
+		auto it = modules.find(module);
+		if (it == modules.end())
+			it = modules.emplace(module, ModuleIndex(module)).first;
+		return it->second;
+	}
+
+	void clear()
+	{
+		modules.clear();
+	}
+};
+
+static SelectIndex select_index;
+
+// Scope of one command evaluating selection arguments
+struct SelectIndexScope
+{
+	SelectIndexScope() { select_index.clear(); }
+	~SelectIndexScope() { select_index.clear(); }
+};
+
 static bool match_attr_val(const RTLIL::Const &value, const std::string &pattern, char match_op)
 {
 	if (match_op == 0)
@@ -431,73 +599,136 @@ static int parse_comma_list(std::set<RTLIL::IdString> &tokens, const std::string
 	}
 }
 
-static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::vector<expand_rule_t> &rules, std::set<RTLIL::IdString> &limits, int max_objects, char mode, CellTypes &ct, bool eval_only)
+static bool expand_port_match(const std::vector<expand_rule_t> &rules, RTLIL::Cell *cell, RTLIL::IdString port, bool eval_only)
 {
-	int sel_objects = 0;
-	bool is_input, is_output;
+	if (eval_only && !yosys_celltypes.cell_evaluable(cell->type))
+		return false;
+
+	char last_mode = '-';
+	for (auto &rule : rules) {
+		last_mode = rule.mode;
+		if (rule.cell_types.size() > 0 && rule.cell_types.count(cell->type) == 0)
+			continue;
+		if (rule.port_names.size() > 0 && rule.port_names.count(port) == 0)
+			continue;
+		return rule.mode == '+';
+	}
+	return last_mode != '+';
+}
+
+// Each level adds the cells connected to the selected wires and the wires
+// connected to the selected cells. This is a breadth-first search: a level
+// only looks at the neighbours of the objects added by the previous level.
+// A negative rem_objects means no limit.
+static void select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, const std::vector<expand_rule_t> &rules, const std::set<RTLIL::IdString> &limits, int levels, int &rem_objects, char mode, CellTypes &ct, bool eval_only)
+{
+	struct module_state_t {
+		RTLIL::Module *module;
+		ModuleIndex *index;
+		std::vector<bool> wire_selected, cell_selected;
+		std::vector<int> wire_frontier, cell_frontier;
+		std::vector<RTLIL::IdString> added;
+	};
+	std::vector<module_state_t> states;
+
 	for (auto mod : design->modules())
 	{
 		if (lhs.selected_whole_module(mod->name) || !lhs.selected_module(mod->name))
 			continue;
 
-		std::set<RTLIL::Wire*> selected_wires;
-		auto selected_members = lhs.selected_members[mod->name];
+		states.emplace_back();
+		module_state_t &state = states.back();
+		state.module = mod;
+		state.index = &select_index.get(mod);
+		state.index->setup_connectivity(mod);
+
+		auto &index = *state.index;
+		auto &members = lhs.selected_members.at(mod->name);
+		state.wire_selected.resize(GetSize(index.wires));
+		state.cell_selected.resize(GetSize(index.cells));
+		for (int i = 0; i < GetSize(index.wires); i++)
+			if (members.count(index.wires[i]->name)) {
+				state.wire_selected[i] = true;
+				state.wire_frontier.push_back(i);
+			}
+		for (int i = 0; i < GetSize(index.cells); i++)
+			if (members.count(index.cells[i]->name)) {
+				state.cell_selected[i] = true;
+				state.cell_frontier.push_back(i);
+			}
+	}
 
-		for (auto wire : mod->wires())
-			if (lhs.selected_member(mod->name, wire->name) && limits.count(wire->name) == 0)
-				selected_wires.insert(wire);
+	while (levels-- > 0 && rem_objects != 0)
+	{
+		int num_objects = 0;
 
-		for (auto &conn : mod->connections())
+		for (auto &state : states)
 		{
-			std::vector<RTLIL::SigBit> conn_lhs = conn.first.to_sigbit_vector();
-			std::vector<RTLIL::SigBit> conn_rhs = conn.second.to_sigbit_vector();
-
-			for (size_t i = 0; i < conn_lhs.size(); i++) {
-				if (conn_lhs[i].wire == nullptr || conn_rhs[i].wire == nullptr)
+			auto &index = *state.index;
+			std::vector<int> new_wires, new_cells;
+
+			auto add_wire = [&](int w) {
+				if (rem_objects == 0 || state.wire_selected[w])
+					return;
+				state.wire_selected[w] = true;
+				state.added.push_back(index.wires[w]->name);
+				new_wires.push_back(w);
+				num_objects++, rem_objects--;
+			};
+			auto add_cell = [&](int c) {
+				if (rem_objects == 0 || state.cell_selected[c])
+					return;
+				state.cell_selected[c] = true;
+				state.added.push_back(index.cells[c]->name);
+				new_cells.push_back(c);
+				num_objects++, rem_objects--;
+			};
+
+			for (int w : state.wire_frontier)
+			{
+				if (limits.count(index.wires[w]->name))
 					continue;
-				if (mode != 'i' && selected_wires.count(conn_rhs[i].wire) && selected_members.count(conn_lhs[i].wire->name) == 0)
-					lhs.selected_members[mod->name].insert(conn_lhs[i].wire->name), sel_objects++, max_objects--;
-				if (mode != 'o' && selected_wires.count(conn_lhs[i].wire) && selected_members.count(conn_rhs[i].wire->name) == 0)
-					lhs.selected_members[mod->name].insert(conn_rhs[i].wire->name), sel_objects++, max_objects--;
+				if (mode != 'i')
+					for (int w2 : index.conn_lhs[w])
+						add_wire(w2);
+				if (mode != 'o')
+					for (int w2 : index.conn_rhs[w])
+						add_wire(w2);
+				for (auto &it : index.wire_cells[w]) {
+					RTLIL::Cell *cell = index.cells[it.first];
+					if (state.cell_selected[it.first] || !expand_port_match(rules, cell, it.second, eval_only))
+						continue;
+					if (mode == 'x' || (mode == 'i' && ct.cell_output(cell->type, it.second)) || (mode == 'o' && ct.cell_input(cell->type, it.second)))
+						add_cell(it.first);
+				}
 			}
-		}
 
-		for (auto cell : mod->cells())
-		for (auto &conn : cell->connections())
-		{
-			char last_mode = '-';
-			if (eval_only && !yosys_celltypes.cell_evaluable(cell->type))
-				goto exclude_match;
-			for (auto &rule : rules) {
-				last_mode = rule.mode;
-				if (rule.cell_types.size() > 0 && rule.cell_types.count(cell->type) == 0)
-					continue;
-				if (rule.port_names.size() > 0 && rule.port_names.count(conn.first) == 0)
+			for (int c : state.cell_frontier)
+			{
+				RTLIL::Cell *cell = index.cells[c];
+				if (limits.count(cell->name))
 					continue;
-				if (rule.mode == '+')
-					goto include_match;
-				else
-					goto exclude_match;
-			}
-			if (last_mode == '+')
-				goto exclude_match;
-		include_match:
-			is_input = mode == 'x' || ct.cell_input(cell->type, conn.first);
-			is_output = mode == 'x' || ct.cell_output(cell->type, conn.first);
-			for (auto &chunk : conn.second.chunks())
-				if (chunk.wire != nullptr) {
-					if (max_objects != 0 && selected_wires.count(chunk.wire) > 0 && selected_members.count(cell->name) == 0)
-						if (mode == 'x' || (mode == 'i' && is_output) || (mode == 'o' && is_input))
-							lhs.selected_members[mod->name].insert(cell->name), sel_objects++, max_objects--;
-					if (max_objects != 0 && selected_members.count(cell->name) > 0 && limits.count(cell->name) == 0 && selected_members.count(chunk.wire->name) == 0)
-						if (mode == 'x' || (mode == 'i' && is_input) || (mode == 'o' && is_output))
-							lhs.selected_members[mod->name].insert(chunk.wire->name), sel_objects++, max_objects--;
+				for (auto &it : index.cell_wires[c]) {
+					if (state.wire_selected[it.first] || !expand_port_match(rules, cell, it.second, eval_only))
+						continue;
+					if (mode == 'x' || (mode == 'i' && ct.cell_input(cell->type, it.second)) || (mode == 'o' && ct.cell_output(cell->type, it.second)))
+						add_wire(it.first);
 				}
-		exclude_match:;
+			}
+
+			state.wire_frontier.swap(new_wires);
+			state.cell_frontier.swap(new_cells);
 		}
+
+		if (num_objects == 0)
+			break;
 	}
 
-	return sel_objects;
+	for (auto &state : states) {
+		auto &members = lhs.selected_members[state.module->name];
+		for (auto name : state.added)
+			members.insert(name);
+	}
 }
 
 static void select_op_expand(RTLIL::Design *design, const std::string &arg, char mode, bool eval_only)
@@ -593,12 +824,7 @@ static void select_op_expand(RTLIL::Design *design, const std::string &arg, char
 	}
 #endif
 
-	while (levels-- > 0 && rem_objects != 0) {
-		int num_objects = select_op_expand(design, work_stack.back(), rules, limits, rem_objects, mode, ct, eval_only);
-		if (num_objects == 0)
-			break;
-		rem_objects -= num_objects;
-	}
+	select_op_expand(design, work_stack.back(), rules, limits, levels, rem_objects, mode, ct, eval_only);
 
 	if (rem_objects == 0)
 		log_warning("reached configured limit at `%s'.\n", arg.c_str());
@@ -829,24 +1055,31 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 		}
 
 		if (arg_memb.compare(0, 2, "w:") == 0) {
-			for (auto wire : mod->wires())
-				if (match_ids(wire->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
+			auto &index = select_index.get(mod);
+			index.wire_names.match(arg_memb.substr(2), [&](int i) {
+				sel.selected_members[mod->name].insert(index.wires[i]->name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "i:") == 0) {
-			for (auto wire : mod->wires())
-				if (wire->port_input && match_ids(wire->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
+			auto &index = select_index.get(mod);
+			index.wire_names.match(arg_memb.substr(2), [&](int i) {
+				if (index.wires[i]->port_input)
+					sel.selected_members[mod->name].insert(index.wires[i]->name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "o:") == 0) {
-			for (auto wire : mod->wires())
-				if (wire->port_output && match_ids(wire->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
+			auto &index = select_index.get(mod);
+			index.wire_names.match(arg_memb.substr(2), [&](int i) {
+				if (index.wires[i]->port_output)
+					sel.selected_members[mod->name].insert(index.wires[i]->name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "x:") == 0) {
-			for (auto wire : mod->wires())
-				if ((wire->port_input || wire->port_output) && match_ids(wire->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
+			auto &index = select_index.get(mod);
+			index.wire_names.match(arg_memb.substr(2), [&](int i) {
+				if (index.wires[i]->port_input || index.wires[i]->port_output)
+					sel.selected_members[mod->name].insert(index.wires[i]->name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "s:") == 0) {
 			size_t delim = arg_memb.substr(2).find(':');
@@ -866,24 +1099,28 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 			}
 		} else
 		if (arg_memb.compare(0, 2, "m:") == 0) {
-			for (auto &it : mod->memories)
-				if (match_ids(it.first, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(it.first);
+			auto &index = select_index.get(mod);
+			index.memory_names.match(arg_memb.substr(2), [&](int i) {
+				sel.selected_members[mod->name].insert(index.memory_names.names[i]);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "c:") == 0) {
-			for (auto cell : mod->cells())
-				if (match_ids(cell->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(cell->name);
+			auto &index = select_index.get(mod);
+			index.cell_names.match(arg_memb.substr(2), [&](int i) {
+				sel.selected_members[mod->name].insert(index.cells[i]->name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "t:") == 0) {
-			for (auto cell : mod->cells())
-				if (match_ids(cell->type, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(cell->name);
+			auto &index = select_index.get(mod);
+			index.cell_types.match(arg_memb.substr(2), [&](int i) {
+				sel.selected_members[mod->name].insert(index.cells[i]->name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "p:") == 0) {
-			for (auto &it : mod->processes)
-				if (match_ids(it.first, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(it.first);
+			auto &index = select_index.get(mod);
+			index.process_names.match(arg_memb.substr(2), [&](int i) {
+				sel.selected_members[mod->name].insert(index.process_names.names[i]);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "a:") == 0) {
 			for (auto wire : mod->wires())
@@ -907,26 +1144,12 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 			std::string orig_arg_memb = arg_memb;
 			if (arg_memb.compare(0, 2, "n:") == 0)
 				arg_memb = arg_memb.substr(2);
-			for (auto wire : mod->wires())
-				if (match_ids(wire->name, arg_memb)) {
-					sel.selected_members[mod->name].insert(wire->name);
+			auto &index = select_index.get(mod);
+			for (auto names : {&index.wire_names, &index.memory_names, &index.cell_names, &index.process_names})
+				names->match(arg_memb, [&](int i) {
+					sel.selected_members[mod->name].insert(names->names[i]);
 					arg_memb_found[orig_arg_memb] = true;
-				}
-			for (auto &it : mod->memories)
-				if (match_ids(it.first, arg_memb)) {
-					sel.selected_members[mod->name].insert(it.first);
-					arg_memb_found[orig_arg_memb] = true;
-				}
-			for (auto cell : mod->cells())
-				if (match_ids(cell->name, arg_memb)) {
-					sel.selected_members[mod->name].insert(cell->name);
-					arg_memb_found[orig_arg_memb] = true;
-				}
-			for (auto &it : mod->processes)
-				if (match_ids(it.first, arg_memb)) {
-					sel.selected_members[mod->name].insert(it.first);
-					arg_memb_found[orig_arg_memb] = true;
-				}
+				});
 		}
 	}
 
@@ -976,6 +1199,7 @@ YOSYS_NAMESPACE_BEGIN
 void handle_extra_select_args(Pass *pass, const vector<string> &args, size_t argidx, size_t args_size, RTLIL::Design *design)
 {
 	work_stack.clear();
+	SelectIndexScope index_scope;
 	for (; argidx < args_size; argidx++) {
 		if (args[argidx].compare(0, 1, "-") == 0) {
 			if (pass != nullptr)
@@ -999,6 +1223,7 @@ void handle_extra_select_args(Pass *pass, const vector<string> &args, size_t arg
 RTLIL::Selection eval_select_args(const vector<string> &args, RTLIL::Design *design)
 {
 	work_stack.clear();
+	SelectIndexScope index_scope;
 	for (auto &arg : args)
 		select_stmt(design, arg);
 	while (work_stack.size() > 1) {
@@ -1014,6 +1239,7 @@ RTLIL::Selection eval_select_args(const vector<string> &args, RTLIL::Design *des
 void eval_select_op(vector<RTLIL::Selection> &work, const string &op, RTLIL::Design *design)
 {
 	work_stack.swap(work);
+	SelectIndexScope index_scope;
 	select_stmt(design, op);
 	work_stack.swap(work);
 }
@@ -1177,6 +1403,13 @@ struct SelectPass : public Pass {
 		log("        all objects with a name matching the given pattern\n");
 		log("        (i.e. 'n:' is optional as it is the default matching rule)\n");
 		log("\n");
+		log("Patterns with a literal prefix (e.g. 'w:data_*') are looked up in a sorted\n");
+		log("index of the names of a module. The index is only built when a command\n");
+		log("matches a second pattern against the same module, and it is discarded at\n");
+		log("the end of the command. A command with a single pattern, like\n");
+		log("'select w:data_*', scans all names as before; only commands with several\n");
+		log("patterns, like 'select w:data_* w:addr_*', benefit from the index.\n");
+		log("\n");
 		log("    @<name>\n");
 		log("        push the selection saved prior with 'select -set <name> ...'\n");
 		log("\n");
@@ -1270,6 +1503,7 @@ struct SelectPass : public Pass {
 		std::string set_name, unset_name, sel_str;
 
 		work_stack.clear();
+		SelectIndexScope index_scope;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
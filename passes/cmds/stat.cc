@@ -324,15 +324,10 @@ statdata_t hierarchy_worker(std::map<RTLIL::IdString, statdata_t> &mod_stat, RTL
 
 void read_liberty_cellarea(dict<IdString, double> &cell_area, string liberty_file)
 {
-	std::ifstream f;
-	f.open(liberty_file.c_str());
 	yosys_input_files.insert(liberty_file);
-	if (f.fail())
-		log_cmd_error("Can't open liberty file `%s': %s\n", liberty_file.c_str(), strerror(errno));
-	LibertyParser libparser(f);
-	f.close();
+	LibertyAst *liberty = LibertyParser::load(liberty_file, LibertyParser::timing_groups());
 
-	for (auto cell : libparser.ast->children)
+	for (auto cell : liberty->children)
 	{
 		if (cell->id != "cell" || cell->args.size() != 1)
 			continue;
@@ -439,10 +439,15 @@ void check_cell_connections(const RTLIL::Module &module, RTLIL::Cell &cell, RTLI
 	}
 }
 
+// Expand (derive, load or check) the cell types used by a module. Returns
+// true if anything changed. Modules that are completely resolved (all cell
+// types are known and nothing is waiting for other modules to appear) are
+// added to done_modules, and will not be visited again.
 bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check, bool flag_simcheck, bool flag_smtcheck,
-		   std::vector<std::string> &libdirs)
+		   std::vector<std::string> &libdirs, pool<RTLIL::Module*> &done_modules)
 {
 	bool did_something = false;
+	bool pending = false;
 	std::map<RTLIL::Cell*, std::pair<int, int>> array_cells;
 	std::string filename;
 
@@ -463,6 +468,9 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 	{
 		if_expander.start_cell();
 
+		if (cell->has_attribute(ID::reprocess_after))
+			pending = true;
+
 		if (cell->type.begins_with("$array:")) {
 			int pos[3];
 			basic_cell_type(cell->type.str(), pos);
@@ -486,6 +494,8 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 			// the thing we just loaded).
 			if (mod)
 				did_something = true;
+			else if (cell->type[0] != '$')
+				pending = true;
 
 			continue;
 		}
@@ -561,8 +571,12 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 
 	// Now that modules have been derived, we may want to reprocess this
 	// module given the additional available context.
-	if (module->reprocess_if_necessary(design))
+	if (module->reprocess_if_necessary(design)) {
+		// The module was replaced, so the modules instantiating it have
+		// to be checked again.
+		done_modules.clear();
 		return true;
+	}
 
 	for (auto &it : array_cells)
 	{
@@ -596,6 +610,8 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 		}
 	}
 
+	if (!did_something && !pending)
+		done_modules.insert(module);
 	return did_something;
 }
 
@@ -1033,6 +1049,11 @@ struct HierarchyPass : public Pass {
 					mod->attributes.erase(ID::initial_top);
 		}
 
+		// Modules that do not need to be expanded or checked again. This is
+		// cleared whenever modules are removed, as a new module may get the
+		// address of a removed one.
+		pool<RTLIL::Module*> done_modules;
+
 		bool did_something = true;
 		while (did_something)
 		{
@@ -1048,7 +1069,9 @@ struct HierarchyPass : public Pass {
 			}
 
 			for (auto module : used_modules) {
-				if (expand_module(design, module, flag_check, flag_simcheck, flag_smtcheck, libdirs))
+				if (done_modules.count(module))
+					continue;
+				if (expand_module(design, module, flag_check, flag_simcheck, flag_smtcheck, libdirs, done_modules))
 					did_something = true;
 			}
 
@@ -1073,6 +1096,8 @@ struct HierarchyPass : public Pass {
 			for(size_t i=0; i<modules_to_delete.size(); i++) {
 				design->remove(modules_to_delete[i]);
 			}
+			if (!modules_to_delete.empty())
+				done_modules.clear();
 		}
 
 
@@ -129,6 +129,15 @@ struct MemConfig {
 
 typedef std::vector<MemConfig> MemConfigs;
 
+// The outcome of mapping a memory, as stored in the decision cache.
+struct MappingDecision {
+	// Index of the chosen config, or -1 for FF mapping.
+	int idx;
+	MemConfig cfg;
+	// Canonical signal index of each used shared clock, or -1 if not used or constant.
+	std::vector<int> clk_index;
+};
+
 struct MapWorker {
 	Module *module;
 	ModWalker modwalker;
@@ -184,6 +193,11 @@ struct MemMapping {
 	dict<std::pair<int, int>, bool> wr_excludes_rd_cache;
 	dict<std::pair<int, int>, bool> wr_excludes_srst_cache;
 
+	// Canonical numbering of the non-constant bits seen by the mapping decision, used
+	// for the decision cache.  Index 0 is for raw signals, index 1 for sigmap_xmux-ed ones.
+	std::vector<SigBit> sig_bits[2];
+	dict<SigBit, int> sig_index[2];
+
 	MemMapping(MapWorker &worker, Mem &mem, const Library &lib, const PassOptions &opts) : worker(worker), qcsat(worker.modwalker), mem(mem), lib(lib), opts(opts) {
 		determine_style();
 		logic_ok = determine_logic_ok();
@@ -191,6 +205,9 @@ struct MemMapping {
 			logic_cost = mem.width * mem.size * opts.logic_cost_rom;
 		else
 			logic_cost = mem.width * mem.size * opts.logic_cost_ram;
+	}
+
+	void find_configs() {
 		if (kind == RamKind::Logic)
 			return;
 		for (int i = 0; i < GetSize(lib.rams); i++) {
@@ -228,6 +245,15 @@ struct MemMapping {
 		dump_configs(1);
 	}
 
+	// The mapping decision is a pure function of the signature if it was reached
+	// without asking the SAT solver anything about the enable logic.
+	bool decision_is_structural() {
+		return wr_en_cache.empty() && wr_implies_rd_cache.empty() && wr_excludes_rd_cache.empty() && wr_excludes_srst_cache.empty();
+	}
+
+	void sig_key(std::string &key, int space, const SigSpec &sig);
+	std::string signature();
+
 	bool addr_compatible(int wpidx, int rpidx) {
 		auto &wport = mem.wr_ports[wpidx];
 		auto &rport = mem.rd_ports[rpidx];
@@ -425,6 +451,72 @@ void MemMapping::dump_config(MemConfig &cfg) {
 	}
 }
 
+void MemMapping::sig_key(std::string &key, int space, const SigSpec &sig) {
+	key += stringf("[%d:", GetSize(sig));
+	for (auto bit: sig) {
+		if (bit.wire == nullptr) {
+			key += "01xz-m"[bit.data];
+			continue;
+		}
+		auto it = sig_index[space].find(bit);
+		int idx;
+		if (it == sig_index[space].end()) {
+			idx = GetSize(sig_bits[space]);
+			sig_index[space][bit] = idx;
+			sig_bits[space].push_back(bit);
+		} else {
+			idx = it->second;
+		}
+		key += stringf("%d,", idx);
+	}
+	key += "]";
+}
+
+// Computes a key that captures everything the mapping decision looks at, with
+// signals replaced by their canonical numbering.  Two memories with the same
+// signature that need no SAT queries get the same configs.
+std::string MemMapping::signature() {
+	std::string key = stringf("%d %d %d %d %d;", mem.width, mem.size, mem.start_offset, GetSize(mem.wr_ports), GetSize(mem.rd_ports));
+	for (auto &it: mem.attributes) {
+		if (it.first == ID::src)
+			continue;
+		key += stringf("%s=%s;", it.first.c_str(), log_const(it.second));
+	}
+	bool has_nonx = false;
+	bool has_one = false;
+	for (auto &init: mem.inits) {
+		if (init.data.is_fully_undef())
+			continue;
+		has_nonx = true;
+		for (auto bit: init.data)
+			if (bit == State::S1)
+				has_one = true;
+	}
+	key += stringf("init %d %d;", has_nonx, has_one);
+	for (auto &port: mem.wr_ports) {
+		key += stringf("wr %d %d %d", port.wide_log2, port.clk_enable, port.clk_polarity);
+		sig_key(key, 0, port.clk);
+		sig_key(key, 0, port.en);
+		sig_key(key, 1, worker.sigmap_xmux(port.addr));
+		for (auto bit: port.priority_mask)
+			key += bit ? '1' : '0';
+		key += ";";
+	}
+	for (auto &port: mem.rd_ports) {
+		key += stringf("rd %d %d %d %d", port.wide_log2, port.clk_enable, port.clk_polarity, port.ce_over_srst);
+		sig_key(key, 0, port.clk);
+		sig_key(key, 0, port.en);
+		sig_key(key, 0, port.arst);
+		sig_key(key, 0, port.srst);
+		sig_key(key, 1, worker.sigmap_xmux(port.addr));
+		key += stringf("%s %s %s ", log_const(port.arst_value), log_const(port.srst_value), log_const(port.init_value));
+		for (int i = 0; i < GetSize(mem.wr_ports); i++)
+			key += port.transparency_mask[i] ? (port.collision_x_mask[i] ? '3' : '1') : (port.collision_x_mask[i] ? '2' : '0');
+		key += ";";
+	}
+	return key;
+}
+
 // Go through memory attributes to determine user-requested mapping style.
 void MemMapping::determine_style() {
 	kind = RamKind::Auto;
@@ -2064,12 +2156,34 @@ struct MemoryLibMapPass : public Pass {
 
 		Library lib = parse_library(lib_files, defines);
 
+		// Mapping decisions for memories that were already handled, keyed by
+		// MemMapping::signature.  Designs tend to contain many copies of the same
+		// memory, and the geometry search is the expensive part of the pass.
+		dict<std::string, MappingDecision> decision_cache;
+
 		for (auto module : design->selected_modules()) {
 			MapWorker worker(module);
 			auto mems = Mem::get_selected_memories(module);
 			for (auto &mem : mems)
 			{
 				MemMapping map(worker, mem, lib, opts);
+				std::string key = map.signature();
+				auto it = decision_cache.find(key);
+				if (it != decision_cache.end()) {
+					auto &decision = it->second;
+					log_debug("Memory %s.%s has the same signature as an already mapped memory.\n", log_id(module->name), log_id(mem.memid));
+					if (decision.idx == -1) {
+						log("using FF mapping for memory %s.%s\n", log_id(module->name), log_id(mem.memid));
+					} else {
+						MemConfig cfg = decision.cfg;
+						for (int i = 0; i < GetSize(cfg.shared_clocks); i++)
+							if (decision.clk_index[i] != -1)
+								cfg.shared_clocks[i].clk = map.sig_bits[0][decision.clk_index[i]];
+						map.emit(cfg);
+					}
+					continue;
+				}
+				map.find_configs();
 				int idx = -1;
 				int best = map.logic_cost;
 				if (!map.logic_ok) {
@@ -2084,6 +2198,15 @@ struct MemoryLibMapPass : public Pass {
 						best = map.cfgs[i].cost;
 					}
 				}
+				if (map.decision_is_structural()) {
+					auto &decision = decision_cache[key];
+					decision.idx = idx;
+					if (idx != -1) {
+						decision.cfg = map.cfgs[idx];
+						for (auto &ccfg: decision.cfg.shared_clocks)
+							decision.clk_index.push_back(ccfg.used && ccfg.clk.wire ? map.sig_index[0].at(ccfg.clk) : -1);
+					}
+				}
 				if (idx == -1) {
 					log("using FF mapping for memory %s.%s\n", log_id(module->name), log_id(mem.memid));
 				} else {
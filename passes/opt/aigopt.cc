@@ -0,0 +1,1218 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+#include "kernel/satgen.h"
+#include "kernel/threading.h"
+
+#include <queue>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+// An and-inverter graph. Node 0 is the constant false node, nodes 1 to
+// num_inputs are the inputs and all other nodes are two-input AND gates.
+// Signals are literals: twice the node index, plus one if the signal is
+// inverted. The fanins of a gate always have a smaller index than the gate
+// itself, so the node order is a topological order. Structurally identical
+// gates are only created once.
+//
+// The optimizations below don't use any RTLIL objects, so that they can run
+// on several modules in parallel.
+struct AigGraph
+{
+	int num_inputs;
+	std::vector<int> fanin0, fanin1;
+	std::vector<int> outputs;
+	dict<std::pair<int, int>, int> strash;
+
+	AigGraph(int num_inputs = 0) : num_inputs(num_inputs), fanin0(num_inputs + 1, -1), fanin1(num_inputs + 1, -1) { }
+
+	int size() const { return GetSize(fanin0); }
+	int num_ands() const { return size() - num_inputs - 1; }
+	bool is_and(int node) const { return node > num_inputs; }
+
+	int mk_and(int a, int b)
+	{
+		if (a > b)
+			std::swap(a, b);
+		if (a == 0 || (a ^ b) == 1)
+			return 0;
+		if (a == 1 || a == b)
+			return b;
+
+		auto key = std::make_pair(a, b);
+		auto it = strash.find(key);
+		if (it != strash.end())
+			return 2 * it->second;
+
+		int node = size();
+		fanin0.push_back(a);
+		fanin1.push_back(b);
+		strash[key] = node;
+		return 2 * node;
+	}
+
+	int mk_or(int a, int b)
+	{
+		return mk_and(a ^ 1, b ^ 1) ^ 1;
+	}
+
+	static int map_lit(const std::vector<int> &map, int lit)
+	{
+		return map[lit >> 1] ^ (lit & 1);
+	}
+
+	// A copy of the graph without the gates that don't drive any output.
+	AigGraph cleanup() const
+	{
+		std::vector<bool> used(size());
+		for (int lit : outputs)
+			used[lit >> 1] = true;
+		for (int node = size() - 1; node > num_inputs; node--)
+			if (used[node]) {
+				used[fanin0[node] >> 1] = true;
+				used[fanin1[node] >> 1] = true;
+			}
+
+		AigGraph copy(num_inputs);
+		std::vector<int> map(size());
+		for (int node = 0; node <= num_inputs; node++)
+			map[node] = 2 * node;
+		for (int node = num_inputs + 1; node < size(); node++)
+			if (used[node])
+				map[node] = copy.mk_and(map_lit(map, fanin0[node]), map_lit(map, fanin1[node]));
+		for (int lit : outputs)
+			copy.outputs.push_back(map_lit(map, lit));
+		return copy;
+	}
+
+	// The number of references to each node from gates and outputs.
+	std::vector<int> fanout_counts() const
+	{
+		std::vector<int> refs(size());
+		for (int node = num_inputs + 1; node < size(); node++) {
+			refs[fanin0[node] >> 1]++;
+			refs[fanin1[node] >> 1]++;
+		}
+		for (int lit : outputs)
+			refs[lit >> 1]++;
+		return refs;
+	}
+
+	int depth() const
+	{
+		std::vector<int> level(size());
+		for (int node = num_inputs + 1; node < size(); node++)
+			level[node] = std::max(level[fanin0[node] >> 1], level[fanin1[node] >> 1]) + 1;
+		int result = 0;
+		for (int lit : outputs)
+			result = std::max(result, level[lit >> 1]);
+		return result;
+	}
+};
+
+// Collapses trees of non-inverted single-fanout AND gates into multi-input
+// AND gates and rebuilds them as trees of minimal depth, combining the two
+// signals with the lowest level first.
+AigGraph aig_balance(const AigGraph &g)
+{
+	std::vector<int> refs = g.fanout_counts();
+	std::vector<bool> root(g.size());
+	for (int lit : g.outputs)
+		root[lit >> 1] = true;
+	for (int node = g.num_inputs + 1; node < g.size(); node++) {
+		if (refs[node] > 1)
+			root[node] = true;
+		if (g.fanin0[node] & 1)
+			root[g.fanin0[node] >> 1] = true;
+		if (g.fanin1[node] & 1)
+			root[g.fanin1[node] >> 1] = true;
+	}
+
+	AigGraph result(g.num_inputs);
+	std::vector<int> level(result.size());
+	std::vector<int> map(g.size());
+	for (int node = 0; node <= g.num_inputs; node++)
+		map[node] = 2 * node;
+
+	std::vector<int> stack, leaves;
+	typedef std::pair<int, int> level_lit_t;
+	for (int node = g.num_inputs + 1; node < g.size(); node++)
+	{
+		if (!root[node] || refs[node] == 0)
+			continue;
+
+		leaves.clear();
+		stack.push_back(g.fanin0[node]);
+		stack.push_back(g.fanin1[node]);
+		while (!stack.empty()) {
+			int lit = stack.back();
+			stack.pop_back();
+			if (!(lit & 1) && g.is_and(lit >> 1) && !root[lit >> 1]) {
+				stack.push_back(g.fanin0[lit >> 1]);
+				stack.push_back(g.fanin1[lit >> 1]);
+			} else
+				leaves.push_back(AigGraph::map_lit(map, lit));
+		}
+
+		std::sort(leaves.begin(), leaves.end());
+		leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+
+		std::priority_queue<level_lit_t, std::vector<level_lit_t>, std::greater<level_lit_t>> queue;
+		for (int lit : leaves)
+			queue.push(level_lit_t(level[lit >> 1], lit));
+
+		while (GetSize(queue) > 1) {
+			int a = queue.top().second;
+			queue.pop();
+			int b = queue.top().second;
+			queue.pop();
+			int lit = result.mk_and(a, b);
+			if ((lit >> 1) >= GetSize(level))
+				level.push_back(std::max(level[a >> 1], level[b >> 1]) + 1);
+			queue.push(level_lit_t(level[lit >> 1], lit));
+		}
+		map[node] = queue.top().second;
+	}
+
+	for (int lit : g.outputs)
+		result.outputs.push_back(AigGraph::map_lit(map, lit));
+	return result.cleanup();
+}
+
+// Truth tables of functions of up to 6 variables.
+const uint64_t truth_vars[6] = {
+	0xaaaaaaaaaaaaaaaaull, 0xccccccccccccccccull, 0xf0f0f0f0f0f0f0f0ull,
+	0xff00ff00ff00ff00ull, 0xffff0000ffff0000ull, 0xffffffff00000000ull
+};
+
+uint64_t truth_cofactor0(uint64_t truth, int var)
+{
+	truth &= ~truth_vars[var];
+	return truth | (truth << (1 << var));
+}
+
+uint64_t truth_cofactor1(uint64_t truth, int var)
+{
+	truth &= truth_vars[var];
+	return truth | (truth >> (1 << var));
+}
+
+// A product term, with one bit per variable in pos and neg.
+struct AigCube
+{
+	int pos = 0, neg = 0;
+};
+
+// Irredundant sum of products (Minato-Morreale) of a function with onset
+// lower and care set upper, using the variables below var. Returns the
+// function of the cover.
+uint64_t truth_isop(uint64_t lower, uint64_t upper, int var, std::vector<AigCube> &cover)
+{
+	if (lower == 0)
+		return 0;
+	if (upper == ~uint64_t(0)) {
+		cover.push_back(AigCube());
+		return ~uint64_t(0);
+	}
+
+	var--;
+	while (truth_cofactor0(lower, var) == truth_cofactor1(lower, var) && truth_cofactor0(upper, var) == truth_cofactor1(upper, var))
+		var--;
+
+	uint64_t lower0 = truth_cofactor0(lower, var), lower1 = truth_cofactor1(lower, var);
+	uint64_t upper0 = truth_cofactor0(upper, var), upper1 = truth_cofactor1(upper, var);
+
+	int begin0 = GetSize(cover);
+	uint64_t res0 = truth_isop(lower0 & ~upper1, upper0, var, cover);
+	int begin1 = GetSize(cover);
+	uint64_t res1 = truth_isop(lower1 & ~upper0, upper1, var, cover);
+	int begin2 = GetSize(cover);
+	uint64_t res2 = truth_isop((lower0 & ~res0) | (lower1 & ~res1), upper0 & upper1, var, cover);
+
+	for (int i = begin0; i < begin1; i++)
+		cover[i].neg |= 1 << var;
+	for (int i = begin1; i < begin2; i++)
+		cover[i].pos |= 1 << var;
+
+	return (res0 & ~truth_vars[var]) | (res1 & truth_vars[var]) | res2;
+}
+
+// Counts the gates an AIG construction would create, without sharing.
+struct AigCounter
+{
+	int next_node = 1 << 20;
+	int count = 0;
+
+	int mk_and(int a, int b)
+	{
+		if (a > b)
+			std::swap(a, b);
+		if (a == 0 || (a ^ b) == 1)
+			return 0;
+		if (a == 1 || a == b)
+			return b;
+		count++;
+		return 2 * next_node++;
+	}
+
+	int mk_or(int a, int b)
+	{
+		return mk_and(a ^ 1, b ^ 1) ^ 1;
+	}
+};
+
+// Builds an algebraically factored form of a cover: the literal that occurs
+// in most cubes is factored out, recursively.
+template<typename Builder>
+int build_factored(Builder &builder, const std::vector<AigCube> &cover, const int *var_lits)
+{
+	if (cover.empty())
+		return 0;
+
+	int counts[12] = {};
+	for (auto &cube : cover)
+		for (int var = 0; var < 6; var++) {
+			if (cube.pos & (1 << var))
+				counts[2 * var]++;
+			if (cube.neg & (1 << var))
+				counts[2 * var + 1]++;
+		}
+
+	int best = 0;
+	for (int i = 1; i < 12; i++)
+		if (counts[i] > counts[best])
+			best = i;
+
+	if (counts[best] <= 1 || GetSize(cover) == 1) {
+		int sum = 0;
+		for (auto &cube : cover) {
+			int product = 1;
+			for (int var = 0; var < 6; var++) {
+				if (cube.pos & (1 << var))
+					product = builder.mk_and(product, var_lits[var]);
+				if (cube.neg & (1 << var))
+					product = builder.mk_and(product, var_lits[var] ^ 1);
+			}
+			sum = builder.mk_or(sum, product);
+		}
+		return sum;
+	}
+
+	int var = best / 2;
+	bool neg = best % 2;
+	std::vector<AigCube> quotient, remainder;
+	for (auto &cube : cover) {
+		if ((neg ? cube.neg : cube.pos) & (1 << var)) {
+			AigCube q = cube;
+			(neg ? q.neg : q.pos) &= ~(1 << var);
+			quotient.push_back(q);
+		} else
+			remainder.push_back(cube);
+	}
+
+	int lit = var_lits[var] ^ (neg ? 1 : 0);
+	int q = build_factored(builder, quotient, var_lits);
+	int r = build_factored(builder, remainder, var_lits);
+	return builder.mk_or(builder.mk_and(lit, q), r);
+}
+
+// Replaces the logic cones of nodes by smaller implementations derived from
+// the truth table of the node over a cut. With enumerate_cuts set, all cuts
+// of up to cut_size leaves are enumerated (up to a limit per node) and the
+// best one is used ("rewrite"). Otherwise a single reconvergence-driven cut
+// is computed for each node ("refactor").
+//
+// Accepted replacements are recorded on the nodes of the original graph and
+// only turned into a new graph at the end. The reference counts, which are
+// used to compute the number of gates that a replacement frees, always
+// describe the current structure, where replaced nodes have the leaves of
+// their replacement as fanins.
+struct AigResynth
+{
+	static const int max_cuts = 8;
+	static const int max_cone = 200;
+
+	struct Cut
+	{
+		int size = 0;
+		int leaves[6];
+	};
+
+	struct Replacement
+	{
+		std::vector<int> leaves;
+		std::vector<AigCube> cover;
+		bool inverted = false;
+		uint64_t truth = 0;
+		int cost = 0;
+	};
+
+	const AigGraph &g;
+	int cut_size;
+	bool enumerate_cuts;
+
+	std::vector<int> refs;
+	std::vector<int> repl;
+	std::vector<Replacement> replacements;
+	std::vector<std::vector<Cut>> cuts;
+
+	std::vector<uint64_t> sim;
+	std::vector<int> stamp;
+	int current_stamp = 0;
+	std::vector<int> stack;
+
+	AigResynth(const AigGraph &g, int cut_size, bool enumerate_cuts) : g(g), cut_size(cut_size), enumerate_cuts(enumerate_cuts)
+	{
+		refs = g.fanout_counts();
+		repl.resize(g.size(), -1);
+		sim.resize(g.size());
+		stamp.resize(g.size());
+		if (enumerate_cuts)
+			cuts.resize(g.size());
+	}
+
+	template<typename F> void for_fanins(int node, F f) const
+	{
+		if (repl[node] >= 0) {
+			for (int leaf : replacements[repl[node]].leaves)
+				f(leaf);
+		} else {
+			f(g.fanin0[node] >> 1);
+			f(g.fanin1[node] >> 1);
+		}
+	}
+
+	int node_cost(int node) const
+	{
+		return repl[node] >= 0 ? replacements[repl[node]].cost : 1;
+	}
+
+	int deref(int node)
+	{
+		int count = node_cost(node);
+		for_fanins(node, [&](int fanin) {
+			if (g.is_and(fanin) && --refs[fanin] == 0)
+				count += deref(fanin);
+		});
+		return count;
+	}
+
+	int ref(int node)
+	{
+		int count = node_cost(node);
+		for_fanins(node, [&](int fanin) {
+			if (g.is_and(fanin) && refs[fanin]++ == 0)
+				count += ref(fanin);
+		});
+		return count;
+	}
+
+	// The number of gates that would be freed by implementing the node
+	// directly in terms of the leaves.
+	int mffc_size(int node, const std::vector<int> &leaves)
+	{
+		for (int leaf : leaves)
+			refs[leaf]++;
+		int count = deref(node);
+		ref(node);
+		for (int leaf : leaves)
+			refs[leaf]--;
+		return count;
+	}
+
+	uint64_t eval_node(int node) const
+	{
+		if (repl[node] < 0) {
+			int a = g.fanin0[node], b = g.fanin1[node];
+			uint64_t va = sim[a >> 1] ^ ((a & 1) ? ~uint64_t(0) : 0);
+			uint64_t vb = sim[b >> 1] ^ ((b & 1) ? ~uint64_t(0) : 0);
+			return va & vb;
+		}
+
+		const Replacement &r = replacements[repl[node]];
+		int num_leaves = GetSize(r.leaves);
+		uint64_t result = 0;
+		for (int minterm = 0; minterm < (1 << num_leaves); minterm++) {
+			if (!((r.truth >> minterm) & 1))
+				continue;
+			uint64_t product = ~uint64_t(0);
+			for (int i = 0; i < num_leaves; i++)
+				product &= ((minterm >> i) & 1) ? sim[r.leaves[i]] : ~sim[r.leaves[i]];
+			result |= product;
+		}
+		return result;
+	}
+
+	// Computes the truth table of the node in terms of the leaves. Fails if
+	// the leaves are not a cut of the node in the current structure or if
+	// the cone is too large.
+	bool cut_truth(int node, const std::vector<int> &leaves, uint64_t &truth)
+	{
+		current_stamp++;
+		for (int i = 0; i < GetSize(leaves); i++) {
+			stamp[leaves[i]] = current_stamp;
+			sim[leaves[i]] = truth_vars[i];
+		}
+
+		int cone_size = 0;
+		stack.clear();
+		stack.push_back(node);
+		while (!stack.empty())
+		{
+			int n = stack.back();
+			if (stamp[n] == current_stamp) {
+				stack.pop_back();
+				continue;
+			}
+			if (!g.is_and(n))
+				return false;
+
+			bool ready = true;
+			for_fanins(n, [&](int fanin) {
+				if (stamp[fanin] != current_stamp) {
+					stack.push_back(fanin);
+					ready = false;
+				}
+			});
+			if (!ready)
+				continue;
+
+			stack.pop_back();
+			sim[n] = eval_node(n);
+			stamp[n] = current_stamp;
+			if (++cone_size > max_cone)
+				return false;
+		}
+
+		truth = sim[node];
+		return true;
+	}
+
+	// Implementation of a truth table as factored sum of products of either
+	// polarity, whichever is smaller, using only the leaves in its support.
+	Replacement synthesize(uint64_t truth, const std::vector<int> &leaves)
+	{
+		int num_vars = GetSize(leaves);
+		int var_lits[6];
+		for (int i = 0; i < 6; i++)
+			var_lits[i] = 2 * (i + 1);
+
+		Replacement best;
+		for (int inverted = 0; inverted < 2; inverted++)
+		{
+			std::vector<AigCube> cover;
+			uint64_t func = inverted ? ~truth : truth;
+			truth_isop(func, func, num_vars, cover);
+
+			AigCounter counter;
+			build_factored(counter, cover, var_lits);
+			if (inverted && counter.count >= best.cost)
+				continue;
+
+			best.cover = cover;
+			best.inverted = inverted;
+			best.cost = counter.count;
+		}
+
+		int support = 0;
+		for (auto &cube : best.cover)
+			support |= cube.pos | cube.neg;
+
+		int var_map[6];
+		for (int var = 0; var < num_vars; var++)
+			if (support & (1 << var)) {
+				var_map[var] = GetSize(best.leaves);
+				best.leaves.push_back(leaves[var]);
+			}
+		for (auto &cube : best.cover) {
+			AigCube mapped;
+			for (int var = 0; var < num_vars; var++) {
+				if (cube.pos & (1 << var))
+					mapped.pos |= 1 << var_map[var];
+				if (cube.neg & (1 << var))
+					mapped.neg |= 1 << var_map[var];
+			}
+			cube = mapped;
+		}
+
+		best.truth = 0;
+		for (auto &cube : best.cover) {
+			uint64_t product = ~uint64_t(0);
+			for (int var = 0; var < 6; var++) {
+				if (cube.pos & (1 << var))
+					product &= truth_vars[var];
+				if (cube.neg & (1 << var))
+					product &= ~truth_vars[var];
+			}
+			best.truth |= product;
+		}
+		if (best.inverted)
+			best.truth = ~best.truth;
+		return best;
+	}
+
+	void merge_cuts(int node)
+	{
+		std::vector<Cut> &result = cuts[node];
+		result.clear();
+
+		int fanin0 = g.fanin0[node] >> 1, fanin1 = g.fanin1[node] >> 1;
+		Cut trivial0, trivial1;
+		trivial0.size = trivial1.size = 1;
+		trivial0.leaves[0] = fanin0;
+		trivial1.leaves[0] = fanin1;
+
+		std::vector<Cut> cuts0 = cuts[fanin0], cuts1 = cuts[fanin1];
+		cuts0.push_back(trivial0);
+		cuts1.push_back(trivial1);
+
+		for (auto &c0 : cuts0)
+		for (auto &c1 : cuts1)
+		{
+			Cut cut;
+			int i = 0, j = 0;
+			while (i < c0.size || j < c1.size) {
+				int leaf;
+				if (j == c1.size || (i < c0.size && c0.leaves[i] < c1.leaves[j]))
+					leaf = c0.leaves[i++];
+				else if (i == c0.size || c1.leaves[j] < c0.leaves[i])
+					leaf = c1.leaves[j++];
+				else
+					leaf = c0.leaves[i++], j++;
+				if (cut.size == cut_size)
+					goto next_pair;
+				cut.leaves[cut.size++] = leaf;
+			}
+
+			for (int k = 0; k < cut.size; k++)
+				if (g.is_and(cut.leaves[k]) && refs[cut.leaves[k]] == 0)
+					goto next_pair;
+
+			for (auto &other : result)
+				if (std::includes(cut.leaves, cut.leaves + cut.size, other.leaves, other.leaves + other.size))
+					goto next_pair;
+			for (int k = 0; k < GetSize(result); k++)
+				if (std::includes(result[k].leaves, result[k].leaves + result[k].size, cut.leaves, cut.leaves + cut.size))
+					result.erase(result.begin() + k--);
+			result.push_back(cut);
+		next_pair:;
+		}
+
+		std::stable_sort(result.begin(), result.end(), [](const Cut &a, const Cut &b) { return a.size < b.size; });
+		if (GetSize(result) > max_cuts)
+			result.resize(max_cuts);
+	}
+
+	void reconvergent_cut(int node, std::vector<int> &leaves)
+	{
+		current_stamp++;
+		stamp[node] = current_stamp;
+		leaves.clear();
+		for_fanins(node, [&](int fanin) {
+			if (stamp[fanin] != current_stamp) {
+				stamp[fanin] = current_stamp;
+				leaves.push_back(fanin);
+			}
+		});
+
+		while (1)
+		{
+			int best = -1, best_cost = 0;
+			for (int i = 0; i < GetSize(leaves); i++) {
+				if (!g.is_and(leaves[i]))
+					continue;
+				int cost = -1;
+				for_fanins(leaves[i], [&](int fanin) {
+					if (stamp[fanin] != current_stamp)
+						cost++;
+				});
+				if (best < 0 || cost < best_cost)
+					best = i, best_cost = cost;
+			}
+			if (best < 0 || GetSize(leaves) + best_cost > cut_size)
+				break;
+
+			int expand = leaves[best];
+			leaves.erase(leaves.begin() + best);
+			for_fanins(expand, [&](int fanin) {
+				if (stamp[fanin] != current_stamp) {
+					stamp[fanin] = current_stamp;
+					leaves.push_back(fanin);
+				}
+			});
+		}
+
+		std::sort(leaves.begin(), leaves.end());
+	}
+
+	void try_cut(int node, const std::vector<int> &leaves, int &best_gain, Replacement &best, std::vector<int> &best_cut)
+	{
+		uint64_t truth;
+		if (!cut_truth(node, leaves, truth))
+			return;
+
+		Replacement candidate = synthesize(truth, leaves);
+		int gain = mffc_size(node, leaves) - candidate.cost;
+		if (gain > best_gain) {
+			best_gain = gain;
+			best = candidate;
+			best_cut = leaves;
+		}
+	}
+
+	void replace(int node, const Replacement &r, const std::vector<int> &cut)
+	{
+		for (int leaf : cut)
+			refs[leaf]++;
+		deref(node);
+
+		repl[node] = GetSize(replacements);
+		replacements.push_back(r);
+
+		for (int leaf : cut)
+			if (std::find(r.leaves.begin(), r.leaves.end(), leaf) == r.leaves.end())
+				if (--refs[leaf] == 0 && g.is_and(leaf))
+					deref(leaf);
+	}
+
+	int run()
+	{
+		int num_replaced = 0;
+		std::vector<int> leaves, best_cut;
+
+		for (int node = g.num_inputs + 1; node < g.size(); node++)
+		{
+			if (refs[node] == 0)
+				continue;
+
+			int best_gain = 0;
+			Replacement best;
+
+			if (enumerate_cuts) {
+				merge_cuts(node);
+				for (auto &cut : cuts[node]) {
+					leaves.assign(cut.leaves, cut.leaves + cut.size);
+					try_cut(node, leaves, best_gain, best, best_cut);
+				}
+			} else {
+				reconvergent_cut(node, leaves);
+				try_cut(node, leaves, best_gain, best, best_cut);
+			}
+
+			if (best_gain <= 0)
+				continue;
+
+			replace(node, best, best_cut);
+			num_replaced++;
+
+			if (enumerate_cuts) {
+				Cut cut;
+				for (int leaf : replacements.back().leaves)
+					cut.leaves[cut.size++] = leaf;
+				cuts[node].assign(1, cut);
+			}
+		}
+
+		return num_replaced;
+	}
+
+	AigGraph build() const
+	{
+		AigGraph result(g.num_inputs);
+		std::vector<int> map(g.size());
+		for (int node = 0; node <= g.num_inputs; node++)
+			map[node] = 2 * node;
+
+		for (int node = g.num_inputs + 1; node < g.size(); node++)
+		{
+			if (refs[node] == 0)
+				continue;
+			if (repl[node] < 0) {
+				map[node] = result.mk_and(AigGraph::map_lit(map, g.fanin0[node]), AigGraph::map_lit(map, g.fanin1[node]));
+				continue;
+			}
+			const Replacement &r = replacements[repl[node]];
+			int var_lits[6];
+			for (int i = 0; i < GetSize(r.leaves); i++)
+				var_lits[i] = map[r.leaves[i]];
+			map[node] = build_factored(result, r.cover, var_lits) ^ (r.inverted ? 1 : 0);
+		}
+
+		for (int lit : g.outputs)
+			result.outputs.push_back(AigGraph::map_lit(map, lit));
+		return result.cleanup();
+	}
+};
+
+AigGraph aig_rewrite(const AigGraph &g)
+{
+	AigResynth worker(g, 4, true);
+	worker.run();
+	return worker.build();
+}
+
+AigGraph aig_refactor(const AigGraph &g)
+{
+	AigResynth worker(g, 6, false);
+	worker.run();
+	return worker.build();
+}
+
+// Merges functionally equivalent nodes (up to inversion). Candidates are
+// found by 64-bit parallel random simulation and proven with a SAT solver.
+// Counterexamples are collected and simulated as additional patterns, which
+// splits the candidate classes. Each SAT call is limited to max_conflicts
+// conflicts (0 = no limit).
+AigGraph aig_fraig(const AigGraph &g, int max_conflicts)
+{
+	std::vector<std::vector<uint64_t>> words;
+	uint64_t rng_state = 0x2545f4914f6cdd1dull;
+	auto rng = [&]() {
+		rng_state ^= rng_state << 13;
+		rng_state ^= rng_state >> 7;
+		rng_state ^= rng_state << 17;
+		return rng_state;
+	};
+
+	auto simulate = [&](std::vector<uint64_t> &word) {
+		for (int node = g.num_inputs + 1; node < g.size(); node++) {
+			int a = g.fanin0[node], b = g.fanin1[node];
+			uint64_t va = word[a >> 1] ^ ((a & 1) ? ~uint64_t(0) : 0);
+			uint64_t vb = word[b >> 1] ^ ((b & 1) ? ~uint64_t(0) : 0);
+			word[node] = va & vb;
+		}
+	};
+
+	auto random_word = [&]() {
+		std::vector<uint64_t> word(g.size());
+		for (int node = 1; node <= g.num_inputs; node++)
+			word[node] = rng();
+		return word;
+	};
+
+	for (int i = 0; i < 4; i++) {
+		words.push_back(random_word());
+		simulate(words.back());
+	}
+
+	// Signatures are normalized so that the first pattern is zero.
+	auto phase = [&](int node) { return words[0][node] & 1; };
+	auto signature_hash = [&](int node) {
+		uint64_t mask = phase(node) ? ~uint64_t(0) : 0;
+		unsigned int h = mkhash_init;
+		for (auto &word : words) {
+			uint64_t w = word[node] ^ mask;
+			h = mkhash(mkhash(h, uint32_t(w)), uint32_t(w >> 32));
+		}
+		return int64_t(h);
+	};
+	auto same_signature = [&](int a, int b) {
+		uint64_t mask = (phase(a) != phase(b)) ? ~uint64_t(0) : 0;
+		for (auto &word : words)
+			if (word[a] != (word[b] ^ mask))
+				return false;
+		return true;
+	};
+
+	std::vector<int> representatives;
+	dict<int64_t, std::vector<int>> classes;
+	for (int node = 0; node <= g.num_inputs; node++) {
+		representatives.push_back(node);
+		classes[signature_hash(node)].push_back(node);
+	}
+
+	// One solver is shared by all candidates, so every node is encoded at
+	// most once. A candidate pair that runs out of conflicts is treated as
+	// not equivalent.
+	ezSatPtr ez;
+	ez->setSolverConflictBudget(max_conflicts);
+	std::vector<int> ez_node(g.size());
+	ez_node[0] = ez->CONST_FALSE;
+	for (int node = 1; node <= g.num_inputs; node++)
+		ez_node[node] = ez->frozen_literal();
+	auto ez_lit = [&](int lit) {
+		return (lit & 1) ? ez->NOT(ez_node[lit >> 1]) : ez_node[lit >> 1];
+	};
+
+	std::vector<uint64_t> pending = random_word();
+	int num_pending = 0;
+
+	// Inputs in the fan-in of the nodes given to the solver so far. Only
+	// these are read back from a counterexample, the other inputs keep
+	// their random bits in the pending pattern.
+	std::vector<bool> in_solver(g.size());
+	std::vector<int> stack, solver_inputs, model_expr;
+	std::vector<bool> model_values;
+
+	AigGraph result(g.num_inputs);
+	std::vector<int> map(g.size());
+	for (int node = 0; node <= g.num_inputs; node++)
+		map[node] = 2 * node;
+
+	for (int node = g.num_inputs + 1; node < g.size(); node++)
+	{
+		map[node] = result.mk_and(AigGraph::map_lit(map, g.fanin0[node]), AigGraph::map_lit(map, g.fanin1[node]));
+		ez_node[node] = ez->AND(ez_lit(g.fanin0[node]), ez_lit(g.fanin1[node]));
+
+		int candidate = -1;
+		auto it = classes.find(signature_hash(node));
+		if (it != classes.end())
+			for (int other : it->second)
+				if (same_signature(node, other)) {
+					candidate = other;
+					break;
+				}
+
+		if (candidate >= 0)
+		{
+			bool inverted = phase(node) != phase(candidate);
+			int ez_other = inverted ? ez->NOT(ez_node[candidate]) : ez_node[candidate];
+
+			// Only the part of the cones that is new to the solver is visited
+			stack.assign({node, candidate});
+			while (!stack.empty()) {
+				int n = stack.back();
+				stack.pop_back();
+				if (in_solver[n])
+					continue;
+				in_solver[n] = true;
+				if (g.is_and(n)) {
+					stack.push_back(g.fanin0[n] >> 1);
+					stack.push_back(g.fanin1[n] >> 1);
+				} else if (n > 0) {
+					solver_inputs.push_back(n);
+					model_expr.push_back(ez_node[n]);
+				}
+			}
+
+			if (!ez->solve(model_expr, model_values, ez->XOR(ez_node[node], ez_other))) {
+				if (!ez->getSolverTimoutStatus()) {
+					map[node] = map[candidate] ^ (inverted ? 1 : 0);
+					ez_node[node] = ez_other;
+					continue;
+				}
+			} else {
+				for (int i = 0; i < GetSize(solver_inputs); i++) {
+					uint64_t bit = uint64_t(1) << num_pending;
+					if (model_values[i])
+						pending[solver_inputs[i]] |= bit;
+					else
+						pending[solver_inputs[i]] &= ~bit;
+				}
+
+				if (++num_pending == 64) {
+					simulate(pending);
+					words.push_back(pending);
+					pending = random_word();
+					num_pending = 0;
+
+					classes.clear();
+					for (int other : representatives)
+						classes[signature_hash(other)].push_back(other);
+				}
+			}
+		}
+
+		representatives.push_back(node);
+		classes[signature_hash(node)].push_back(node);
+	}
+
+	for (int lit : g.outputs)
+		result.outputs.push_back(AigGraph::map_lit(map, lit));
+	return result.cleanup();
+}
+
+struct AigoptModuleWorker
+{
+	Module *module;
+	SigMap sigmap;
+	std::vector<Cell*> cells;
+	std::vector<SigBit> input_bits, output_bits;
+	AigGraph graph;
+	int depth_before = 0, ands_before = 0, nots_before = 0;
+	bool has_loop = false;
+
+	AigoptModuleWorker(Module *module) : module(module), sigmap(module) { }
+
+	void import()
+	{
+		dict<SigBit, Cell*> driver;
+		for (auto cell : module->selected_cells()) {
+			if (!cell->type.in(ID($_AND_), ID($_NOT_)) || cell->has_keep_attr())
+				continue;
+			cells.push_back(cell);
+			driver[sigmap(cell->getPort(ID::Y).as_bit())] = cell;
+			if (cell->type == ID($_AND_))
+				ands_before++;
+			else
+				nots_before++;
+		}
+
+		pool<SigBit> used_outside;
+		pool<Cell*> cell_set(cells.begin(), cells.end());
+		for (auto cell : module->cells()) {
+			if (cell_set.count(cell))
+				continue;
+			for (auto &conn : cell->connections())
+				for (auto bit : sigmap(conn.second))
+					used_outside.insert(bit);
+		}
+		for (auto wire : module->wires())
+			if (wire->port_output || wire->get_bool_attribute(ID::keep))
+				for (auto bit : sigmap(wire))
+					used_outside.insert(bit);
+
+		for (auto cell : cells) {
+			SigBit bit = sigmap(cell->getPort(ID::Y).as_bit());
+			if (used_outside.count(bit))
+				output_bits.push_back(bit);
+		}
+
+		// Find the inputs and a topological order of the cells without
+		// recursion, the logic cones can be very deep.
+		dict<SigBit, int> state;
+		dict<SigBit, int> input_index;
+		std::vector<Cell*> order;
+		std::vector<std::pair<SigBit, bool>> stack;
+		for (auto bit : output_bits)
+			stack.push_back(std::make_pair(bit, false));
+		while (!stack.empty())
+		{
+			SigBit bit = stack.back().first;
+			bool finish = stack.back().second;
+			stack.pop_back();
+
+			auto it = driver.find(bit);
+			if (it == driver.end()) {
+				if ((bit.wire != nullptr || bit.data == State::Sx || bit.data == State::Sz) && !input_index.count(bit)) {
+					input_index[bit] = GetSize(input_bits);
+					input_bits.push_back(bit);
+				}
+				continue;
+			}
+
+			int &st = state[bit];
+			if (finish) {
+				st = 2;
+				order.push_back(it->second);
+				continue;
+			}
+			if (st == 2)
+				continue;
+			if (st == 1) {
+				has_loop = true;
+				return;
+			}
+			st = 1;
+			stack.push_back(std::make_pair(bit, true));
+			for (auto port : {ID::A, ID::B})
+				if (it->second->hasPort(port))
+					stack.push_back(std::make_pair(sigmap(it->second->getPort(port).as_bit()), false));
+		}
+
+		graph = AigGraph(GetSize(input_bits));
+		dict<SigBit, int> lits;
+		auto lit = [&](SigBit bit) {
+			if (bit == State::S0)
+				return 0;
+			if (bit == State::S1)
+				return 1;
+			auto it = lits.find(bit);
+			if (it != lits.end())
+				return it->second;
+			return 2 * (input_index.at(bit) + 1);
+		};
+
+		for (auto cell : order) {
+			SigBit y = sigmap(cell->getPort(ID::Y).as_bit());
+			SigBit a = sigmap(cell->getPort(ID::A).as_bit());
+			if (cell->type == ID($_NOT_))
+				lits[y] = lit(a) ^ 1;
+			else
+				lits[y] = graph.mk_and(lit(a), lit(sigmap(cell->getPort(ID::B).as_bit())));
+		}
+
+		for (auto bit : output_bits)
+			graph.outputs.push_back(lits.at(bit));
+		graph = graph.cleanup();
+		depth_before = graph.depth();
+	}
+
+	void optimize(const std::vector<std::string> &steps, int max_conflicts)
+	{
+		for (auto &step : steps) {
+			if (step == "strash")
+				graph = graph.cleanup();
+			else if (step == "balance")
+				graph = aig_balance(graph);
+			else if (step == "rewrite")
+				graph = aig_rewrite(graph);
+			else if (step == "refactor")
+				graph = aig_refactor(graph);
+			else if (step == "fraig")
+				graph = aig_fraig(graph, max_conflicts);
+		}
+	}
+
+	void write_back()
+	{
+		for (auto cell : cells)
+			module->remove(cell);
+
+		std::vector<SigBit> node_bits(graph.size()), inverted_bits(graph.size());
+		node_bits[0] = State::S0;
+		inverted_bits[0] = State::S1;
+		for (int node = 1; node <= graph.num_inputs; node++)
+			node_bits[node] = input_bits[node - 1];
+
+		int nots_after = 0;
+		auto lit_bit = [&](int lit) {
+			int node = lit >> 1;
+			if (!(lit & 1))
+				return node_bits[node];
+			if (inverted_bits[node] == SigBit()) {
+				inverted_bits[node] = module->addWire(NEW_ID);
+				module->addNotGate(NEW_ID, node_bits[node], inverted_bits[node]);
+				nots_after++;
+			}
+			return inverted_bits[node];
+		};
+
+		for (int node = graph.num_inputs + 1; node < graph.size(); node++) {
+			node_bits[node] = module->addWire(NEW_ID);
+			module->addAndGate(NEW_ID, lit_bit(graph.fanin0[node]), lit_bit(graph.fanin1[node]), node_bits[node]);
+		}
+
+		for (int i = 0; i < GetSize(output_bits); i++)
+			module->connect(output_bits[i], lit_bit(graph.outputs[i]));
+
+		log("  %s: %d inputs, %d outputs, $_AND_ %d -> %d, $_NOT_ %d -> %d, depth %d -> %d\n", log_id(module),
+				GetSize(input_bits), GetSize(output_bits), ands_before, graph.num_ands(), nots_before, nots_after,
+				depth_before, graph.depth());
+	}
+};
+
+struct AigoptPass : public Pass {
+	AigoptPass() : Pass("aigopt", "optimize and-inverter graphs") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    aigopt [options] [selection]\n");
+		log("\n");
+		log("This pass optimizes the combinational logic made of $_AND_ and $_NOT_ cells in\n");
+		log("the selected modules, without calling an external tool. The logic is turned\n");
+		log("into a structurally hashed and-inverter graph (AIG), optimized, and written\n");
+		log("back as $_AND_ and $_NOT_ cells. Run 'aigmap' first to convert other logic.\n");
+		log("\n");
+		log("Signals that are used by other cells, module outputs and wires with the keep\n");
+		log("attribute are preserved. The names of all other internal signals are lost.\n");
+		log("Cells with the keep attribute are not optimized. The modules are optimized\n");
+		log("in parallel, using up to YOSYS_MAX_THREADS threads.\n");
+		log("\n");
+		log("    -steps <step>[,<step>...]\n");
+		log("        The optimization steps to run, in this order. The default is\n");
+		log("        'balance,rewrite,refactor,balance,rewrite'. The available steps are:\n");
+		log("\n");
+		log("        strash    structural hashing and removal of unused gates only\n");
+		log("        balance   rebuild trees of AND gates with minimal depth\n");
+		log("        rewrite   resynthesize the cones of all cuts with up to 4 inputs\n");
+		log("                  and keep the smallest result\n");
+		log("        refactor  resynthesize the cone of one reconvergence-driven cut\n");
+		log("                  with up to 6 inputs per node\n");
+		log("        fraig     merge functionally equivalent signals, found by random\n");
+		log("                  simulation and proven with a SAT solver\n");
+		log("\n");
+		log("    -fraig\n");
+		log("        Run 'fraig' after the other steps.\n");
+		log("\n");
+		log("    -conflicts <num>\n");
+		log("        Limit each SAT call of the 'fraig' step to this many conflicts. Signals\n");
+		log("        that can not be proven equivalent within the limit are kept apart.\n");
+		log("        The default is 1000, 0 means no limit.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		std::vector<std::string> steps = {"balance", "rewrite", "refactor", "balance", "rewrite"};
+		bool fraig = false;
+		int max_conflicts = 1000;
+
+		log_header(design, "Executing AIGOPT pass (optimize and-inverter graphs).\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-steps" && argidx+1 < args.size()) {
+				steps = split_tokens(args[++argidx], ",");
+				for (auto &step : steps)
+					if (step != "strash" && step != "balance" && step != "rewrite" && step != "refactor" && step != "fraig")
+						log_cmd_error("Unknown optimization step `%s'.\n", step.c_str());
+				continue;
+			}
+			if (args[argidx] == "-fraig") {
+				fraig = true;
+				continue;
+			}
+			if (args[argidx] == "-conflicts" && argidx+1 < args.size()) {
+				const std::string &arg = args[++argidx];
+				char *endptr;
+				long value = strtol(arg.c_str(), &endptr, 10);
+				if (arg.empty() || *endptr != 0 || value < 0 || value > INT_MAX)
+					log_cmd_error("Invalid conflict limit `%s', expected a number >= 0.\n", arg.c_str());
+				max_conflicts = value;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		if (fraig)
+			steps.push_back("fraig");
+
+		std::vector<AigoptModuleWorker*> workers;
+		for (auto module : design->selected_modules()) {
+			if (module->has_processes_warn())
+				continue;
+			AigoptModuleWorker *worker = new AigoptModuleWorker(module);
+			worker->import();
+			if (worker->has_loop)
+				log_warning("Module %s contains a combinational loop of $_AND_/$_NOT_ cells, skipping.\n", log_id(module));
+			else if (!worker->cells.empty()) {
+				workers.push_back(worker);
+				continue;
+			}
+			delete worker;
+		}
+
+		parallel_for(GetSize(workers), [&](int i) {
+			workers[i]->optimize(steps, max_conflicts);
+		});
+
+		for (auto worker : workers) {
+			worker->write_back();
+			delete worker;
+		}
+	}
+} AigoptPass;
+
+PRIVATE_NAMESPACE_END
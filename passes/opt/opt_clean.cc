@@ -22,6 +22,7 @@
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
 #include "kernel/ffinit.h"
+#include "kernel/profile.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
@@ -90,7 +91,8 @@ struct keep_cache_t
 };
 
 keep_cache_t keep_cache;
-CellTypes ct_reg, ct_all;
+CellTypes ct_reg;
+const CellTypeTable *ct_all;
 int count_rm_cells, count_rm_wires;
 
 void rmunused_module_cells(Module *module, bool verbose)
@@ -126,13 +128,13 @@ void rmunused_module_cells(Module *module, bool verbose)
 	for (auto &it : module->cells_) {
 		Cell *cell = it.second;
 		for (auto &it2 : cell->connections()) {
-			if (ct_all.cell_known(cell->type) && !ct_all.cell_output(cell->type, it2.first))
+			if (ct_all->cell_known(cell->type) && !ct_all->cell_output(cell->type, it2.first))
 				continue;
 			for (auto raw_bit : it2.second) {
 				if (raw_bit.wire == nullptr)
 					continue;
 				auto bit = sigmap(raw_bit);
-				if (bit.wire == nullptr && ct_all.cell_known(cell->type))
+				if (bit.wire == nullptr && ct_all->cell_known(cell->type))
 					driver_driver_logs[raw_sigmap(raw_bit)].push_back(stringf("Driver-driver conflict "
 							"for %s between cell %s.%s and constant %s in %s: Resolved using constant.",
 							log_signal(raw_bit), log_id(cell), log_id(it2.first), log_signal(bit), log_id(module)));
@@ -163,7 +165,7 @@ void rmunused_module_cells(Module *module, bool verbose)
 		pool<IdString> mems;
 		for (auto cell : queue) {
 			for (auto &it : cell->connections())
-				if (!ct_all.cell_known(cell->type) || ct_all.cell_input(cell->type, it.first))
+				if (!ct_all->cell_known(cell->type) || ct_all->cell_input(cell->type, it.first))
 					for (auto bit : sigmap(it.second))
 						bits.insert(bit);
 
@@ -212,7 +214,7 @@ void rmunused_module_cells(Module *module, bool verbose)
 	for (auto &it : module->cells_) {
 		Cell *cell = it.second;
 		for (auto &it2 : cell->connections()) {
-			if (ct_all.cell_known(cell->type) && !ct_all.cell_input(cell->type, it2.first))
+			if (ct_all->cell_known(cell->type) && !ct_all->cell_input(cell->type, it2.first))
 				continue;
 			for (auto raw_bit : raw_sigmap(it2.second))
 				used_raw_bits.insert(raw_bit);
@@ -305,9 +307,9 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 	pool<RTLIL::Wire*> direct_wires;
 	for (auto &it : module->cells_) {
 		RTLIL::Cell *cell = it.second;
-		if (ct_all.cell_known(cell->type))
+		if (ct_all->cell_known(cell->type))
 			for (auto &it2 : cell->connections())
-				if (ct_all.cell_output(cell->type, it2.first))
+				if (ct_all->cell_output(cell->type, it2.first))
 					direct_sigs.insert(assign_map(it2.second));
 	}
 	for (auto &it : module->wires_) {
@@ -335,7 +337,7 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 			assign_map.apply(it2.second);
 			raw_used_signals.add(it2.second);
 			used_signals.add(it2.second);
-			if (!ct_all.cell_output(cell->type, it2.first))
+			if (!ct_all->cell_output(cell->type, it2.first))
 				used_signals_nodrivers.add(it2.second);
 		}
 	}
@@ -636,7 +638,7 @@ struct OptCleanPass : public Pass {
 		ct_reg.setup_internals_anyinit();
 		ct_reg.setup_stdcells_mem();
 
-		ct_all.setup(design);
+		ct_all = &design->cell_types();
 
 		count_rm_cells = 0;
 		count_rm_wires = 0;
@@ -644,6 +646,7 @@ struct OptCleanPass : public Pass {
 		for (auto module : design->selected_whole_modules_warn()) {
 			if (module->has_processes_warn())
 				continue;
+			ProfileScope profile(module);
 			rmunused_module(module, purge_mode, true, true);
 		}
 
@@ -656,7 +659,7 @@ struct OptCleanPass : public Pass {
 
 		keep_cache.reset();
 		ct_reg.clear();
-		ct_all.clear();
+		ct_all = nullptr;
 		log_pop();
 	}
 } OptCleanPass;
@@ -698,7 +701,7 @@ struct CleanPass : public Pass {
 		ct_reg.setup_internals_anyinit();
 		ct_reg.setup_stdcells_mem();
 
-		ct_all.setup(design);
+		ct_all = &design->cell_types();
 
 		count_rm_cells = 0;
 		count_rm_wires = 0;
@@ -719,7 +722,7 @@ struct CleanPass : public Pass {
 
 		keep_cache.reset();
 		ct_reg.clear();
-		ct_all.clear();
+		ct_all = nullptr;
 	}
 } CleanPass;
 
@@ -26,6 +26,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/ffinit.h"
 #include "kernel/ff.h"
+#include "kernel/profile.h"
 #include "passes/techmap/simplemap.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -918,6 +919,7 @@ struct OptDffPass : public Pass {
 
 		bool did_something = false;
 		for (auto mod : design->selected_modules()) {
+			ProfileScope profile(mod);
 			OptDffWorker worker(opt, mod);
 			if (worker.run())
 				did_something = true;
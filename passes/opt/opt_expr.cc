@@ -22,6 +22,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/utils.h"
 #include "kernel/log.h"
+#include "kernel/profile.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <algorithm>
@@ -2119,6 +2120,7 @@ struct OptExprPass : public Pass {
 		CellTypes ct(design);
 		for (auto module : design->selected_modules())
 		{
+			ProfileScope profile(module);
 			log("Optimizing module %s.\n", log_id(module));
 
 			if (undriven) {
@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
 #include "kernel/modtools.h"
+#include "kernel/truthtable.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -44,27 +45,22 @@ struct OptLutWorker
 
 	int eliminated_count = 0, combined_count = 0;
 
-	bool evaluate_lut(RTLIL::Cell *lut, dict<SigBit, bool> inputs)
+	// The function of the LUT in terms of num_vars variables, given the
+	// functions of (some of) its input signals. Other inputs are constant.
+	TruthTable lut_function(RTLIL::Cell *lut, const dict<SigBit, TruthTable> &inputs, int num_vars)
 	{
 		SigSpec lut_input = sigmap(lut->getPort(ID::A));
-		int lut_width = lut->getParam(ID::WIDTH).as_int();
-		Const lut_table = lut->getParam(ID::LUT);
-		int lut_index = 0;
+		std::vector<TruthTable> input_funcs;
 
-		for (int i = 0; i < lut_width; i++)
+		for (auto &bit : lut_input)
 		{
-			SigBit input = sigmap(lut_input[i]);
-			if (inputs.count(input))
-			{
-				lut_index |= inputs[input] << i;
-			}
+			if (inputs.count(bit))
+				input_funcs.push_back(inputs.at(bit));
 			else
-			{
-				lut_index |= SigSpec(lut_input[i]).as_bool() << i;
-			}
+				input_funcs.push_back(TruthTable(num_vars, SigSpec(bit).as_bool()));
 		}
 
-		return lut_table.extract(lut_index).as_bool();
+		return TruthTable::from_lut(lut->getParam(ID::LUT), input_funcs, num_vars);
 	}
 
 	void show_stats_by_arity()
@@ -220,32 +216,19 @@ struct OptLutWorker
 					lut_inputs.push_back(sigmap(bit));
 			}
 
-			bool const0_match = true;
-			bool const1_match = true;
-			vector<bool> input_matches;
-			for (size_t i = 0; i < lut_inputs.size(); i++)
-				input_matches.push_back(true);
+			pool<SigBit> unique_inputs(lut_inputs.begin(), lut_inputs.end());
+			dict<SigBit, TruthTable> input_funcs;
+			int num_vars = 0;
+			for (auto &bit : unique_inputs)
+				input_funcs[bit] = TruthTable::var(GetSize(unique_inputs), num_vars++);
 
-			for (int eval = 0; eval < 1 << lut_inputs.size(); eval++)
-			{
-				dict<SigBit, bool> eval_inputs;
-				for (size_t i = 0; i < lut_inputs.size(); i++)
-					eval_inputs[lut_inputs[i]] = (eval >> i) & 1;
-				bool value = evaluate_lut(lut, eval_inputs);
-				if (value != 0)
-					const0_match = false;
-				if (value != 1)
-					const1_match = false;
-				for (size_t i = 0; i < lut_inputs.size(); i++)
-				{
-					if (value != eval_inputs[lut_inputs[i]])
-						input_matches[i] = false;
-				}
-			}
+			TruthTable func = lut_function(lut, input_funcs, num_vars);
+			bool const0_match = func.is_const0();
+			bool const1_match = func.is_const1();
 
 			int input_match = -1;
 			for (size_t i = 0; i < lut_inputs.size(); i++)
-				if (input_matches[i])
+				if (func == input_funcs.at(lut_inputs[i]))
 					input_match = i;
 
 			if (const0_match || const1_match || input_match != -1)
@@ -476,17 +459,13 @@ struct OptLutWorker
 					}
 					log_assert(lutR_unique.size() == 0);
 
-					RTLIL::Const lutM_new_table(State::Sx, 1 << lutM_width);
-					for (int eval = 0; eval < 1 << lutM_width; eval++)
+					dict<SigBit, TruthTable> input_funcs;
+					for (size_t i = 0; i < lutM_new_inputs.size(); i++)
 					{
-						dict<SigBit, bool> eval_inputs;
-						for (size_t i = 0; i < lutM_new_inputs.size(); i++)
-						{
-							eval_inputs[lutM_new_inputs[i]] = (eval >> i) & 1;
-						}
-						eval_inputs[lutA_output] = evaluate_lut(lutA, eval_inputs);
-						lutM_new_table[eval] = (RTLIL::State) evaluate_lut(lutB, eval_inputs);
+						input_funcs[lutM_new_inputs[i]] = TruthTable::var(lutM_width, i);
 					}
+					input_funcs[lutA_output] = lut_function(lutA, input_funcs, lutM_width);
+					RTLIL::Const lutM_new_table = lut_function(lutB, input_funcs, lutM_width).to_const();
 
 					log_debug("  Cell A truth table: %s.\n", lutA->getParam(ID::LUT).as_string().c_str());
 					log_debug("  Cell B truth table: %s.\n", lutB->getParam(ID::LUT).as_string().c_str());
@@ -74,6 +74,9 @@ struct PeepoptPass : public Pass {
 
 		for (auto module : design->selected_modules())
 		{
+			// Shared by all iterations, so that the module is only indexed
+			// once and later iterations just apply the changes.
+			pmgen_index index(module);
 			did_something = true;
 
 			while (did_something)
@@ -82,7 +85,7 @@ struct PeepoptPass : public Pass {
 				initbits.clear();
 				rminitbits.clear();
 
-				peepopt_pm pm(module);
+				peepopt_pm pm(index);
 
 				for (auto w : module->wires()) {
 					auto it = w->attributes.find(ID::init);
@@ -358,9 +358,116 @@ with open(outfile, "w") as f:
         print("YOSYS_NAMESPACE_BEGIN", file=f)
         print("", file=f)
 
-    print("struct {}_pm {{".format(prefix), file=f)
+    print("#ifndef PMGEN_INDEX_DEFINED", file=f)
+    print("#define PMGEN_INDEX_DEFINED", file=f)
+    print("// Module-wide index (sigmap and the users of each signal bit) that can be", file=f)
+    print("// shared by several pattern matchers. Changes to the module are recorded", file=f)
+    print("// through the Monitor interface and applied by update(), which the matchers", file=f)
+    print("// call in setup(), so that each matcher sees the module as it was when it was", file=f)
+    print("// set up, without indexing the whole module again.", file=f)
+    print("struct pmgen_index : public RTLIL::Monitor {", file=f)
+    print("  struct change_t {", file=f)
+    print("    Cell *cell;  // nullptr for a module level connection of sig to old_sig", file=f)
+    print("    SigSpec old_sig, sig;", file=f)
+    print("  };", file=f)
+    print("", file=f)
     print("  Module *module;", file=f)
     print("  SigMap sigmap;", file=f)
+    print("  dict<SigBit, dict<Cell*, int>> sigusers;", file=f)
+    print("  vector<change_t> changes;", file=f)
+    print("  bool monitoring, reload;", file=f)
+    print("", file=f)
+    print("  pmgen_index(Module *module, bool monitoring = true) : module(module), monitoring(monitoring), reload(true) {", file=f)
+    print("    if (monitoring)", file=f)
+    print("      module->monitors.insert(this);", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  pmgen_index(const pmgen_index&) = delete;", file=f)
+    print("", file=f)
+    print("  ~pmgen_index() {", file=f)
+    print("    if (monitoring)", file=f)
+    print("      module->monitors.erase(this);", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  void add_users(const SigSpec &sig, Cell *cell, int delta) {", file=f)
+    print("    for (auto bit : sigmap(sig)) {", file=f)
+    print("      if (bit.wire == nullptr) continue;", file=f)
+    print("      auto &users = sigusers[bit];", file=f)
+    print("      if ((users[cell] += delta) == 0)", file=f)
+    print("        users.erase(cell);", file=f)
+    print("    }", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  void add_connection(const SigSpec &lhs, const SigSpec &rhs) {", file=f)
+    print("    vector<SigBit> old_lhs = sigmap(lhs).to_sigbit_vector();", file=f)
+    print("    vector<SigBit> old_rhs = sigmap(rhs).to_sigbit_vector();", file=f)
+    print("    sigmap.add(lhs, rhs);", file=f)
+    print("    for (int i = 0; i < GetSize(lhs); i++) {", file=f)
+    print("      SigBit bit = sigmap(lhs[i]);", file=f)
+    print("      for (auto &old_bit : {old_lhs[i], old_rhs[i]}) {", file=f)
+    print("        auto it = sigusers.find(old_bit);", file=f)
+    print("        if (old_bit == bit || it == sigusers.end()) continue;", file=f)
+    print("        dict<Cell*, int> users = std::move(it->second);", file=f)
+    print("        sigusers.erase(it);", file=f)
+    print("        if (bit.wire != nullptr)", file=f)
+    print("          for (auto &user : users)", file=f)
+    print("            sigusers[bit][user.first] += user.second;", file=f)
+    print("      }", file=f)
+    print("    }", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  void update() {", file=f)
+    print("    if (reload) {", file=f)
+    print("      reload = false;", file=f)
+    print("      changes.clear();", file=f)
+    print("      sigmap.set(module);", file=f)
+    print("      sigusers.clear();", file=f)
+    print("      for (auto port : module->ports)", file=f)
+    print("        add_users(module->wire(port), nullptr, 1);", file=f)
+    print("      for (auto cell : module->cells())", file=f)
+    print("        for (auto &conn : cell->connections())", file=f)
+    print("          add_users(conn.second, cell, 1);", file=f)
+    print("      return;", file=f)
+    print("    }", file=f)
+    print("    for (auto &change : changes) {", file=f)
+    print("      if (change.cell == nullptr) {", file=f)
+    print("        add_connection(change.old_sig, change.sig);", file=f)
+    print("        continue;", file=f)
+    print("      }", file=f)
+    print("      add_users(change.old_sig, change.cell, -1);", file=f)
+    print("      add_users(change.sig, change.cell, 1);", file=f)
+    print("    }", file=f)
+    print("    changes.clear();", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  void notify_connect(Cell *cell, const IdString&, const SigSpec &old_sig, const SigSpec &sig) override {", file=f)
+    print("    if (!reload)", file=f)
+    print("      changes.push_back(change_t{cell, old_sig, sig});", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  void notify_connect(Module*, const SigSig &sigsig) override {", file=f)
+    print("    if (!reload)", file=f)
+    print("      changes.push_back(change_t{nullptr, sigsig.first, sigsig.second});", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  void notify_connect(Module*, const vector<SigSig>&) override {", file=f)
+    print("    reload = true;", file=f)
+    print("    changes.clear();", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  void notify_blackout(Module*) override {", file=f)
+    print("    reload = true;", file=f)
+    print("    changes.clear();", file=f)
+    print("  }", file=f)
+    print("};", file=f)
+    print("#endif", file=f)
+    print("", file=f)
+
+    print("struct {}_pm {{".format(prefix), file=f)
+    print("  Module *module;", file=f)
+    print("  std::unique_ptr<pmgen_index> own_index;", file=f)
+    print("  pmgen_index *index;", file=f)
+    print("  SigMap &sigmap;", file=f)
     print("  std::function<void()> on_accept;", file=f)
     print("  bool setup_done;", file=f)
     print("  bool generate_mode;", file=f)
@@ -393,7 +500,7 @@ with open(outfile, "w") as f:
             print("  typedef std::tuple<{}> index_{}_key_type;".format(", ".join(index_types), index), file=f)
             print("  typedef std::tuple<{}> index_{}_value_type;".format(", ".join(value_types), index), file=f)
             print("  dict<index_{}_key_type, vector<index_{}_value_type>> index_{};".format(index, index, index), file=f)
-    print("  dict<SigBit, pool<Cell*>> sigusers;", file=f)
+    print("  dict<SigBit, pool<Cell*>> sigusers;  // in addition to index->sigusers", file=f)
     print("  pool<Cell*> blacklist_cells;", file=f)
     print("  pool<Cell*> autoremove_cells;", file=f)
     print("  dict<Cell*,int> rollback_cache;", file=f)
@@ -474,24 +581,51 @@ with open(outfile, "w") as f:
 
     print("  int nusers(const SigSpec &sig) {", file=f)
     print("    pool<Cell*> users;", file=f)
-    print("    for (auto bit : sigmap(sig))", file=f)
-    print("      for (auto user : sigusers[bit])", file=f)
-    print("        users.insert(user);", file=f)
+    print("    for (auto bit : sigmap(sig)) {", file=f)
+    print("      auto it = index->sigusers.find(bit);", file=f)
+    print("      if (it != index->sigusers.end())", file=f)
+    print("        for (auto &user : it->second)", file=f)
+    print("          users.insert(user.first);", file=f)
+    print("      auto extra_it = sigusers.find(bit);", file=f)
+    print("      if (extra_it != sigusers.end())", file=f)
+    print("        for (auto user : extra_it->second)", file=f)
+    print("          users.insert(user);", file=f)
+    print("    }", file=f)
     print("    return GetSize(users);", file=f)
     print("  }", file=f)
     print("", file=f)
 
     print("  {}_pm(Module *module, const vector<Cell*> &cells) :".format(prefix), file=f)
-    print("      module(module), sigmap(module), setup_done(false), generate_mode(false), rngseed(12345678) {", file=f)
+    print("      module(module), own_index(new pmgen_index(module, false)), index(own_index.get()), sigmap(index->sigmap),", file=f)
+    print("      setup_done(false), generate_mode(false), rngseed(12345678) {", file=f)
     print("    setup(cells);", file=f)
     print("  }", file=f)
     print("", file=f)
 
     print("  {}_pm(Module *module) :".format(prefix), file=f)
-    print("      module(module), sigmap(module), setup_done(false), generate_mode(false), rngseed(12345678) {", file=f)
+    print("      module(module), own_index(new pmgen_index(module, false)), index(own_index.get()), sigmap(index->sigmap),", file=f)
+    print("      setup_done(false), generate_mode(false), rngseed(12345678) {", file=f)
+    print("    index->update();", file=f)
+    print("  }", file=f)
+    print("", file=f)
+
+    print("  {}_pm(pmgen_index &shared_index, const vector<Cell*> &cells) :".format(prefix), file=f)
+    print("      module(shared_index.module), index(&shared_index), sigmap(index->sigmap),", file=f)
+    print("      setup_done(false), generate_mode(false), rngseed(12345678) {", file=f)
+    print("    setup(cells);", file=f)
     print("  }", file=f)
     print("", file=f)
 
+    print("  {}_pm(pmgen_index &shared_index) :".format(prefix), file=f)
+    print("      module(shared_index.module), index(&shared_index), sigmap(index->sigmap),", file=f)
+    print("      setup_done(false), generate_mode(false), rngseed(12345678) {", file=f)
+    print("    index->update();", file=f)
+    print("  }", file=f)
+    print("", file=f)
+
+    print("  {}_pm({}_pm &&) = default;".format(prefix, prefix), file=f)
+    print("", file=f)
+
     print("  void setup(const vector<Cell*> &cells) {", file=f)
     for current_pattern in sorted(patterns.keys()):
         for s, t in sorted(udata_types[current_pattern].items()):
@@ -502,11 +636,7 @@ with open(outfile, "w") as f:
     current_pattern = None
     print("    log_assert(!setup_done);", file=f)
     print("    setup_done = true;", file=f)
-    print("    for (auto port : module->ports)", file=f)
-    print("      add_siguser(module->wire(port), nullptr);", file=f)
-    print("    for (auto cell : module->cells())", file=f)
-    print("      for (auto &conn : cell->connections())", file=f)
-    print("        add_siguser(conn.second, cell);", file=f)
+    print("    index->update();", file=f)
     print("    for (auto cell : cells) {", file=f)
 
     for index in range(len(blocks)):
@@ -308,7 +308,7 @@ void xilinx_dsp_pack(xilinx_dsp_pm &pm)
 	if (st.postAdd) {
 		log("  postadder %s (%s)\n", log_id(st.postAdd), log_id(st.postAdd->type));
 
-		SigSpec &opmode = cell->connections_.at(ID(OPMODE));
+		SigSpec opmode = cell->getPort(ID(OPMODE));
 		if (st.postAddMux) {
 			log_assert(st.ffP);
 			opmode[4] = st.postAddMux->getPort(ID::S);
@@ -320,6 +320,7 @@ void xilinx_dsp_pack(xilinx_dsp_pm &pm)
 			opmode[4] = State::S1;
 		opmode[6] = State::S0;
 		opmode[5] = State::S1;
+		cell->setPort(ID(OPMODE), opmode);
 
 		if (opmode[4] != State::S0) {
 			if (st.postAddMuxAB == ID::A)
@@ -437,13 +438,17 @@ void xilinx_dsp_pack(xilinx_dsp_pm &pm)
 		if (st.ffM) {
 			SigSpec M; // unused
 			f(M, st.ffM, ID(CEM), ID(RSTM));
-			st.ffM->connections_.at(ID::Q).replace(st.sigM, pm.module->addWire(NEW_ID, GetSize(st.sigM)));
+			SigSpec Q = st.ffM->getPort(ID::Q);
+			Q.replace(st.sigM, pm.module->addWire(NEW_ID, GetSize(st.sigM)));
+			st.ffM->setPort(ID::Q, Q);
 			cell->setParam(ID(MREG), State::S1);
 		}
 		if (st.ffP) {
 			SigSpec P; // unused
 			f(P, st.ffP, ID(CEP), ID(RSTP));
-			st.ffP->connections_.at(ID::Q).replace(st.sigP, pm.module->addWire(NEW_ID, GetSize(st.sigP)));
+			SigSpec Q = st.ffP->getPort(ID::Q);
+			Q.replace(st.sigP, pm.module->addWire(NEW_ID, GetSize(st.sigP)));
+			st.ffP->setPort(ID::Q, Q);
 			cell->setParam(ID(PREG), State::S1);
 		}
 
@@ -502,7 +507,7 @@ void xilinx_dsp48a_pack(xilinx_dsp48a_pm &pm)
 	log_debug("ffP:        %s\n", log_id(st.ffP, "--"));
 
 	Cell *cell = st.dsp;
-	SigSpec &opmode = cell->connections_.at(ID(OPMODE));
+	SigSpec opmode = cell->getPort(ID(OPMODE));
 
 	if (st.preAdd) {
 		log("  preadder %s (%s)\n", log_id(st.preAdd), log_id(st.preAdd->type));
@@ -546,6 +551,7 @@ void xilinx_dsp48a_pack(xilinx_dsp48a_pm &pm)
 
 		pm.autoremove(st.postAdd);
 	}
+	cell->setPort(ID(OPMODE), opmode);
 
 	if (st.clock != SigBit())
 	{
@@ -620,13 +626,17 @@ void xilinx_dsp48a_pack(xilinx_dsp48a_pm &pm)
 		if (st.ffM) {
 			SigSpec M; // unused
 			f(M, st.ffM, ID(CEM), ID(RSTM));
-			st.ffM->connections_.at(ID::Q).replace(st.sigM, pm.module->addWire(NEW_ID, GetSize(st.sigM)));
+			SigSpec Q = st.ffM->getPort(ID::Q);
+			Q.replace(st.sigM, pm.module->addWire(NEW_ID, GetSize(st.sigM)));
+			st.ffM->setPort(ID::Q, Q);
 			cell->setParam(ID(MREG), State::S1);
 		}
 		if (st.ffP) {
 			SigSpec P; // unused
 			f(P, st.ffP, ID(CEP), ID(RSTP));
-			st.ffP->connections_.at(ID::Q).replace(st.sigP, pm.module->addWire(NEW_ID, GetSize(st.sigP)));
+			SigSpec Q = st.ffP->getPort(ID::Q);
+			Q.replace(st.sigP, pm.module->addWire(NEW_ID, GetSize(st.sigP)));
+			st.ffP->setPort(ID::Q, Q);
 			cell->setParam(ID(PREG), State::S1);
 		}
 
@@ -801,13 +811,18 @@ struct XilinxDspPass : public Pass {
 			if (family == "xc7")
 				xilinx_simd_pack(module, module->selected_cells());
 
+			// All matchers below share one index of the module, which is
+			//   kept up to date through the RTLIL::Monitor interface
+			//   instead of being rebuilt for every matcher
+			pmgen_index index(module);
+
 			// Match for all features ([ABDMP][12]?REG, pre-adder,
 			// post-adder, pattern detector, etc.) except for CREG
 			if (family == "xc7") {
-				xilinx_dsp_pm pm(module, module->selected_cells());
+				xilinx_dsp_pm pm(index, module->selected_cells());
 				pm.run_xilinx_dsp_pack(xilinx_dsp_pack);
 			} else if (family == "xc6s" || family == "xc3sda") {
-				xilinx_dsp48a_pm pm(module, module->selected_cells());
+				xilinx_dsp48a_pm pm(index, module->selected_cells());
 				pm.run_xilinx_dsp48a_pack(xilinx_dsp48a_pack);
 			}
 			// Separating out CREG packing is necessary since there
@@ -819,14 +834,14 @@ struct XilinxDspPass : public Pass {
 			//   PREG of an upstream DSP that had not been visited
 			//   yet
 			{
-				xilinx_dsp_CREG_pm pm(module, module->selected_cells());
+				xilinx_dsp_CREG_pm pm(index, module->selected_cells());
 				pm.run_xilinx_dsp_packC(xilinx_dsp_packC);
 			}
 			// Lastly, identify and utilise PCOUT -> PCIN,
 			//   ACOUT -> ACIN, and BCOUT-> BCIN dedicated cascade
 			//   chains
 			{
-				xilinx_dsp_cascade_pm pm(module, module->selected_cells());
+				xilinx_dsp_cascade_pm pm(index, module->selected_cells());
 				pm.run_xilinx_dsp_cascade();
 			}
 		}
@@ -32,7 +32,7 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-bool inv_mode;
+bool inv_mode, sim_mode;
 int verbose_level, reduce_counter, reduce_stop_at;
 typedef std::map<RTLIL::SigBit, std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>>> drivers_t;
 std::string dump_prefix;
@@ -241,6 +241,82 @@ struct PerformReduction
 	std::vector<int> out_depth;
 	int cone_size;
 
+	// Bit-parallel random simulation of the cone (64 patterns per word). Two
+	// signals with different simulation values can not be equivalent, so the
+	// buckets are split by their simulation signature before any SAT queries
+	// are made. Only fine-grained gates are simulated. An empty vector in
+	// sim_values marks a signal that can't be simulated (unsupported driver
+	// or constant undef), and such cones fall back to pure SAT shattering.
+	static const int sim_words = 4;
+	dict<RTLIL::SigBit, std::vector<uint64_t>> sim_values;
+	uint64_t sim_rng_state = 88172645463325252ULL;
+
+	uint64_t sim_rng()
+	{
+		sim_rng_state ^= sim_rng_state << 13;
+		sim_rng_state ^= sim_rng_state >> 7;
+		sim_rng_state ^= sim_rng_state << 17;
+		return sim_rng_state;
+	}
+
+	const std::vector<uint64_t> &simulate(RTLIL::SigBit bit)
+	{
+		auto it = sim_values.find(bit);
+		if (it != sim_values.end())
+			return it->second;
+
+		std::vector<uint64_t> value;
+
+		if (bit.wire == NULL) {
+			if (bit == RTLIL::State::S0 || bit == RTLIL::State::S1)
+				value.resize(sim_words, bit == RTLIL::State::S1 ? ~uint64_t(0) : 0);
+		} else if (drivers.count(bit) == 0) {
+			for (int i = 0; i < sim_words; i++)
+				value.push_back(sim_rng());
+		} else {
+			RTLIL::Cell *cell = drivers.at(bit).first;
+			if (cell->type.in(ID($_BUF_), ID($_NOT_), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_),
+					ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_), ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_)))
+			{
+				std::vector<std::vector<uint64_t>> inputs;
+				for (auto port : {ID::A, ID::B, ID::C, ID::D, ID::S}) {
+					if (!cell->hasPort(port))
+						continue;
+					inputs.push_back(simulate(sigmap(cell->getPort(port)).as_bit()));
+					if (inputs.back().empty())
+						goto done;
+				}
+
+				value.resize(sim_words);
+				for (int i = 0; i < sim_words; i++) {
+					uint64_t a = inputs[0][i];
+					uint64_t b = inputs.size() > 1 ? inputs[1][i] : 0;
+					uint64_t c = inputs.size() > 2 ? inputs[2][i] : 0;
+					uint64_t d = inputs.size() > 3 ? inputs[3][i] : 0;
+					if (cell->type == ID($_BUF_))    value[i] = a;
+					if (cell->type == ID($_NOT_))    value[i] = ~a;
+					if (cell->type == ID($_AND_))    value[i] = a & b;
+					if (cell->type == ID($_NAND_))   value[i] = ~(a & b);
+					if (cell->type == ID($_OR_))     value[i] = a | b;
+					if (cell->type == ID($_NOR_))    value[i] = ~(a | b);
+					if (cell->type == ID($_XOR_))    value[i] = a ^ b;
+					if (cell->type == ID($_XNOR_))   value[i] = ~(a ^ b);
+					if (cell->type == ID($_ANDNOT_)) value[i] = a & ~b;
+					if (cell->type == ID($_ORNOT_))  value[i] = a | ~b;
+					if (cell->type == ID($_MUX_))    value[i] = (a & ~c) | (b & c);
+					if (cell->type == ID($_NMUX_))   value[i] = ~((a & ~c) | (b & c));
+					if (cell->type == ID($_AOI3_))   value[i] = ~((a & b) | c);
+					if (cell->type == ID($_OAI3_))   value[i] = ~((a | b) & c);
+					if (cell->type == ID($_AOI4_))   value[i] = ~((a & b) | (c & d));
+					if (cell->type == ID($_OAI4_))   value[i] = ~((a | b) & (c | d));
+				}
+			}
+		}
+
+	done:
+		return sim_values[bit] = value;
+	}
+
 	int register_cone_worker(std::set<RTLIL::Cell*> &celldone, std::map<RTLIL::SigBit, int> &sigdepth, RTLIL::SigBit out)
 	{
 		if (out.wire == NULL)
@@ -494,9 +570,37 @@ struct PerformReduction
 		for (size_t i = 0; i < sat_out.size(); i++)
 			bucket.push_back(i);
 
+		std::vector<std::vector<int>> sim_buckets;
+		if (sim_mode)
+		{
+			std::map<std::vector<uint64_t>, int> sim_bucket_idx;
+			for (int idx : bucket) {
+				std::vector<uint64_t> signature = simulate(out_bits[idx]);
+				if (signature.empty()) {
+					sim_buckets.clear();
+					break;
+				}
+				if (out_inverted[idx])
+					for (auto &word : signature)
+						word = ~word;
+				auto it = sim_bucket_idx.find(signature);
+				if (it == sim_bucket_idx.end()) {
+					sim_bucket_idx[signature] = GetSize(sim_buckets);
+					sim_buckets.push_back(std::vector<int>());
+					sim_buckets.back().push_back(idx);
+				} else
+					sim_buckets[it->second].push_back(idx);
+			}
+			if (verbose_level >= 1 && !sim_buckets.empty())
+				log("  Simulation split bucket with %d signals into %d candidate classes.\n", GetSize(bucket), GetSize(sim_buckets));
+		}
+		if (sim_buckets.empty())
+			sim_buckets.push_back(bucket);
+
 		std::vector<std::set<int>> results_buf;
 		std::map<int, int> results_map;
-		analyze(results_buf, results_map, bucket, stringf("[%2d%%] %d ", perc, cone_size), "");
+		for (auto &sim_bucket : sim_buckets)
+			analyze(results_buf, results_map, sim_bucket, stringf("[%2d%%] %d ", perc, cone_size), "");
 
 		for (auto &r : results_buf)
 		{
@@ -777,6 +881,10 @@ struct FreducePass : public Pass {
 		log("    -inv\n");
 		log("        enable explicit handling of inverted signals\n");
 		log("\n");
+		log("    -nosim\n");
+		log("        do not use random simulation to split candidate classes of gate-level\n");
+		log("        signals before running SAT queries\n");
+		log("\n");
 		log("    -stop <n>\n");
 		log("        stop after <n> reduction operations. this is mostly used for\n");
 		log("        debugging the freduce command itself.\n");
@@ -798,6 +906,7 @@ struct FreducePass : public Pass {
 		reduce_stop_at = 0;
 		verbose_level = 0;
 		inv_mode = false;
+		sim_mode = true;
 		dump_prefix = std::string();
 
 		log_header(design, "Executing FREDUCE pass (perform functional reduction).\n");
@@ -816,6 +925,10 @@ struct FreducePass : public Pass {
 				inv_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-nosim") {
+				sim_mode = false;
+				continue;
+			}
 			if (args[argidx] == "-stop" && argidx+1 < args.size()) {
 				reduce_stop_at = atoi(args[++argidx].c_str());
 				continue;
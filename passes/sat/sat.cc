@@ -27,6 +27,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/satgen.h"
+#include "kernel/threading.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <algorithm>
@@ -1019,6 +1020,12 @@ struct SatPass : public Pass {
 		log("        -maxsteps <N>\". Use -initsteps if you just want to set a\n");
 		log("        minimal induction length.\n");
 		log("\n");
+		log("    -tempinduct-parallel\n");
+		log("        Solve the base case and the induction step of each induction length\n");
+		log("        concurrently in separate threads. The result is the same as without\n");
+		log("        this option, but a verdict is usually reached faster. Can not be\n");
+		log("        combined with -timeout.\n");
+		log("\n");
 		log("    -prove <signal> <value>\n");
 		log("        Attempt to proof that <signal> is always <value>.\n");
 		log("\n");
@@ -1074,6 +1081,7 @@ struct SatPass : public Pass {
 		bool show_regs = false, show_public = false, show_all = false;
 		bool ignore_unknown_cells = false, falsify = false, tempinduct_def = false, set_init_def = false;
 		bool tempinduct_baseonly = false, tempinduct_inductonly = false, set_assumes = false;
+		bool tempinduct_parallel = false;
 		int tempinduct_skip = 0, stepsize = 1;
 		std::string vcd_file_name, json_file_name, cnf_file_name;
 
@@ -1186,6 +1194,11 @@ struct SatPass : public Pass {
 				tempinduct_inductonly = true;
 				continue;
 			}
+			if (args[argidx] == "-tempinduct-parallel") {
+				tempinduct = true;
+				tempinduct_parallel = true;
+				continue;
+			}
 			if (args[argidx] == "-tempinduct-skip" && argidx+1 < args.size()) {
 				tempinduct_skip = atoi(args[++argidx].c_str());
 				continue;
@@ -1328,6 +1341,9 @@ struct SatPass : public Pass {
 		if (prove_skip && tempinduct)
 			log_cmd_error("Options -prove-skip and -tempinduct don't work with each other. Use -seq instead of -prove-skip.\n");
 
+		if (tempinduct_parallel && timeout > 0)
+			log_cmd_error("Options -tempinduct-parallel and -timeout don't work with each other.\n");
+
 		if (prove_skip >= seq_len && prove_skip > 0)
 			log_cmd_error("The value of -prove-skip must be smaller than the one of -seq.\n");
 
@@ -1438,10 +1454,31 @@ struct SatPass : public Pass {
 
 				// phase 1: proving base case
 
+				bool basecase_pending = false, basecase_failed = false;
+				int basecase_property = 0;
+				AsyncTask basecase_task;
+
+				auto check_basecase = [&]() {
+					basecase_task.wait();
+					basecase_pending = false;
+					if (basecase_failed) {
+						log("SAT temporal induction proof finished - model found for base case: FAIL!\n");
+						print_proof_failed();
+						basecase.print_model();
+						if(!vcd_file_name.empty())
+							basecase.dump_model_to_vcd(vcd_file_name);
+						if(!json_file_name.empty())
+							basecase.dump_model_to_json(json_file_name);
+					} else if (!basecase.gotTimeout) {
+						log("Base case for induction length %d proven.\n", inductlen);
+						basecase.ez->assume(basecase_property);
+					}
+				};
+
 				if (!tempinduct_inductonly)
 				{
 					basecase.setup(seq_len + inductlen, seq_len + inductlen == 1);
-					int property = basecase.setup_proof(seq_len + inductlen);
+					basecase_property = basecase.setup_proof(seq_len + inductlen);
 					basecase.generate_model();
 
 					if (inductlen > 1)
@@ -1453,21 +1490,18 @@ struct SatPass : public Pass {
 								inductlen, basecase.ez->numCnfVariables(), basecase.ez->numCnfClauses());
 						log_flush();
 
-						if (basecase.solve(basecase.ez->NOT(property))) {
-							log("SAT temporal induction proof finished - model found for base case: FAIL!\n");
-							print_proof_failed();
-							basecase.print_model();
-							if(!vcd_file_name.empty())
-								basecase.dump_model_to_vcd(vcd_file_name);
-							if(!json_file_name.empty())
-								basecase.dump_model_to_json(json_file_name);
-							goto tip_failed;
-						}
-
-						if (basecase.gotTimeout)
-							goto timeout;
-
-						log("Base case for induction length %d proven.\n", inductlen);
+						// With -tempinduct-parallel the base case is solved in the background
+						// while the induction step is set up and solved on this thread. Its
+						// result is still evaluated first, so that the verdict matches the
+						// sequential proof.
+						int assumption = basecase.ez->NOT(basecase_property);
+						basecase_pending = true;
+						if (tempinduct_parallel)
+							basecase_task.start([&basecase, &basecase_failed, assumption]() {
+								basecase_failed = basecase.solve(assumption);
+							});
+						else
+							basecase_failed = basecase.solve(assumption);
 					}
 					else
 					{
@@ -1475,8 +1509,16 @@ struct SatPass : public Pass {
 								inductlen, tempinduct_skip);
 						log("\n[base case %d] Problem size so far: %d variables and %d clauses.\n",
 								inductlen, basecase.ez->numCnfVariables(), basecase.ez->numCnfClauses());
+						basecase.ez->assume(basecase_property);
+					}
+
+					if (basecase_pending && !tempinduct_parallel) {
+						check_basecase();
+						if (basecase_failed)
+							goto tip_failed;
+						if (basecase.gotTimeout)
+							goto timeout;
 					}
-					basecase.ez->assume(property);
 				}
 
 				// phase 2: proving induction step
@@ -1525,7 +1567,15 @@ struct SatPass : public Pass {
 								inductlen, inductstep.ez->numCnfVariables(), inductstep.ez->numCnfClauses());
 						log_flush();
 
-						if (!inductstep.solve(inductstep.ez->NOT(property))) {
+						bool inductstep_failed = inductstep.solve(inductstep.ez->NOT(property));
+
+						if (basecase_pending) {
+							check_basecase();
+							if (basecase_failed)
+								goto tip_failed;
+						}
+
+						if (!inductstep_failed) {
 							if (inductstep.gotTimeout)
 								goto timeout;
 							log("Induction step proven: SUCCESS!\n");
@@ -1538,6 +1588,12 @@ struct SatPass : public Pass {
 						inductstep.print_model();
 					}
 				}
+
+				if (basecase_pending) {
+					check_basecase();
+					if (basecase_failed)
+						goto tip_failed;
+				}
 			}
 
 			if (tempinduct_baseonly) {
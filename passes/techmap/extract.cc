@@ -20,6 +20,7 @@
 #include "kernel/register.h"
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
 #include "libs/subcircuit/subcircuit.h"
 #include <algorithm>
 #include <stdlib.h>
@@ -36,18 +37,28 @@ public:
 	std::set<std::pair<RTLIL::IdString, RTLIL::IdString>> ignored_parameters;
 	std::set<RTLIL::IdString> cell_attr, wire_attr;
 
+	// The (unified) parameters of the cells in the graphs, their attributes
+	// listed in cell_attr, and the attributes listed in wire_attr of the
+	// wires connected to them. userCompareNodes() runs on several threads at
+	// once. It must not create or copy IdStrings, and must not make lookups
+	// in the dicts of the design either, because even a const lookup may
+	// rehash a hashlib dict. So everything it needs is copied into these
+	// std::maps before solving, and they are only read while solving.
+	std::map<RTLIL::Cell*, std::map<RTLIL::IdString, RTLIL::Const>> cell_params, cell_attrs;
+	std::map<RTLIL::Wire*, std::map<RTLIL::IdString, RTLIL::Const>> wire_attrs;
+	const std::map<RTLIL::IdString, RTLIL::Const> no_attrs;
+
 	SubCircuitSolver() : ignore_parameters(false)
 	{
 	}
 
-	bool compareAttributes(const std::set<RTLIL::IdString> &attr, const dict<RTLIL::IdString, RTLIL::Const> &needleAttr, const dict<RTLIL::IdString, RTLIL::Const> &haystackAttr)
+	std::map<RTLIL::IdString, RTLIL::Const> selectAttributes(const std::set<RTLIL::IdString> &attr, const dict<RTLIL::IdString, RTLIL::Const> &attributes)
 	{
-		for (auto &it : attr) {
-			size_t nc = needleAttr.count(it), hc = haystackAttr.count(it);
-			if (nc != hc || (nc > 0 && needleAttr.at(it) != haystackAttr.at(it)))
-				return false;
-		}
-		return true;
+		std::map<RTLIL::IdString, RTLIL::Const> result;
+		for (auto &it : attr)
+			if (attributes.count(it))
+				result[it] = attributes.at(it);
+		return result;
 	}
 
 	RTLIL::Const unified_param(RTLIL::IdString cell_type, RTLIL::IdString param, RTLIL::Const value)
@@ -92,6 +103,23 @@ public:
 		return value;
 	}
 
+	void add_cell_data(RTLIL::Cell *cell)
+	{
+		std::map<RTLIL::IdString, RTLIL::Const> &params = cell_params[cell];
+		for (auto &it : cell->parameters)
+			if (!ignored_parameters.count(std::pair<RTLIL::IdString, RTLIL::IdString>(cell->type, it.first)))
+				params[it.first] = unified_param(cell->type, it.first, it.second);
+
+		if (cell_attr.size() > 0)
+			cell_attrs[cell] = selectAttributes(cell_attr, cell->attributes);
+
+		if (wire_attr.size() > 0)
+			for (auto &conn : cell->connections())
+				for (auto &chunk : conn.second.chunks())
+					if (chunk.wire != nullptr && wire_attrs.count(chunk.wire) == 0)
+						wire_attrs[chunk.wire] = selectAttributes(wire_attr, chunk.wire->attributes);
+	}
+
 	virtual bool userCompareNodes(const std::string &, const std::string &, void *needleUserData,
 			const std::string &, const std::string &, void *haystackUserData, const std::map<std::string, std::string> &portMapping)
 	{
@@ -103,36 +131,29 @@ public:
 			return true;
 		}
 
-		if (!ignore_parameters) {
-			std::map<RTLIL::IdString, RTLIL::Const> needle_param, haystack_param;
-			for (auto &it : needleCell->parameters)
-				if (!ignored_parameters.count(std::pair<RTLIL::IdString, RTLIL::IdString>(needleCell->type, it.first)))
-					needle_param[it.first] = unified_param(needleCell->type, it.first, it.second);
-			for (auto &it : haystackCell->parameters)
-				if (!ignored_parameters.count(std::pair<RTLIL::IdString, RTLIL::IdString>(haystackCell->type, it.first)))
-					haystack_param[it.first] = unified_param(haystackCell->type, it.first, it.second);
-			if (needle_param != haystack_param)
-				return false;
-		}
+		if (!ignore_parameters && cell_params.at(needleCell) != cell_params.at(haystackCell))
+			return false;
 
-		if (cell_attr.size() > 0 && !compareAttributes(cell_attr, needleCell->attributes, haystackCell->attributes))
+		if (cell_attr.size() > 0 && cell_attrs.at(needleCell) != cell_attrs.at(haystackCell))
 			return false;
 
 		if (wire_attr.size() > 0)
 		{
 			RTLIL::Wire *lastNeedleWire = nullptr;
 			RTLIL::Wire *lastHaystackWire = nullptr;
-			dict<RTLIL::IdString, RTLIL::Const> emptyAttr;
 
 			for (auto &conn : needleCell->connections())
 			{
-				RTLIL::SigSpec needleSig = conn.second;
-				RTLIL::SigSpec haystackSig = haystackCell->getPort(portMapping.at(conn.first.str()));
+				const std::string &haystackPort = portMapping.at(conn.first.str());
+				RTLIL::SigSpec needleSig = conn.second, haystackSig;
+				for (auto &haystackConn : haystackCell->connections())
+					if (haystackConn.first == haystackPort)
+						haystackSig = haystackConn.second;
 
 				for (int i = 0; i < min(needleSig.size(), haystackSig.size()); i++) {
 					RTLIL::Wire *needleWire = needleSig[i].wire, *haystackWire = haystackSig[i].wire;
 					if (needleWire != lastNeedleWire || haystackWire != lastHaystackWire)
-						if (!compareAttributes(wire_attr, needleWire ? needleWire->attributes : emptyAttr, haystackWire ? haystackWire->attributes : emptyAttr))
+						if ((needleWire ? wire_attrs.at(needleWire) : no_attrs) != (haystackWire ? wire_attrs.at(haystackWire) : no_attrs))
 							return false;
 					lastNeedleWire = needleWire, lastHaystackWire = haystackWire;
 				}
@@ -632,6 +653,8 @@ struct ExtractPass : public Pass {
 					solver.addGraph(graph_name, mod_graph);
 					needle_map[graph_name] = module;
 					needle_list.push_back(module);
+					for (auto cell : module->cells())
+						solver.add_cell_data(cell);
 				}
 			}
 
@@ -642,6 +665,8 @@ struct ExtractPass : public Pass {
 			if (module2graph(mod_graph, module, constports, design, mine_mode ? mine_max_fanout : -1, mine_mode ? &mine_split : nullptr)) {
 				solver.addGraph(graph_name, mod_graph);
 				haystack_map[graph_name] = module;
+				for (auto cell : module->cells())
+					solver.add_cell_data(cell);
 			}
 		}
 
@@ -652,11 +677,20 @@ struct ExtractPass : public Pass {
 
 			std::sort(needle_list.begin(), needle_list.end(), compareSortNeedleList);
 
+			// The haystacks are searched in parallel, the results are in the
+			// same order as when solving for each needle and haystack in turn.
+			std::vector<std::string> needle_ids, haystack_ids;
 			for (auto needle : needle_list)
-			for (auto &haystack_it : haystack_map) {
-				log("Solving for %s in %s.\n", ("needle_" + RTLIL::unescape_id(needle->name)).c_str(), haystack_it.first.c_str());
-				solver.solve(results, "needle_" + RTLIL::unescape_id(needle->name), haystack_it.first, false);
-			}
+				needle_ids.push_back("needle_" + RTLIL::unescape_id(needle->name));
+			for (auto &haystack_it : haystack_map)
+				haystack_ids.push_back(haystack_it.first);
+
+			for (auto &needle_id : needle_ids)
+			for (auto &haystack_id : haystack_ids)
+				log("Solving for %s in %s.\n", needle_id.c_str(), haystack_id.c_str());
+
+			solver.setMaxThreads(yosys_max_threads());
+			solver.solve(results, needle_ids, haystack_ids, false);
 			log("Found %d matches.\n", GetSize(results));
 
 			if (results.size() > 0)
@@ -51,7 +51,7 @@ struct ExtractFaWorker
 {
 	const ExtractFaConfig &config;
 	Module *module;
-	ConstEval ce;
+	ConstEvalBatch ce;
 	SigMap &sigmap;
 
 	dict<SigBit, Cell*> driver;
@@ -153,6 +153,16 @@ struct ExtractFaWorker
 		}
 	}
 
+	bool eval_func(SigBit root, SigSpec leaves, int &func)
+	{
+		SigSpec undef;
+		std::vector<TruthTable> tables;
+		if (!ce.compile(leaves, root, undef) || !ce.eval_tables(tables))
+			return false;
+		func = tables[0].words[0] & ((1 << tables[0].num_bits()) - 1);
+		return true;
+	}
+
 	void check_partition(SigBit root, pool<SigBit> &leaves)
 	{
 		if (config.enable_ha && GetSize(leaves) == 2)
@@ -162,28 +172,9 @@ struct ExtractFaWorker
 			SigBit A = SigSpec(leaves)[0];
 			SigBit B = SigSpec(leaves)[1];
 
-			int func = 0;
-			for (int i = 0; i < 4; i++)
-			{
-				bool a_value = (i & 1) != 0;
-				bool b_value = (i & 2) != 0;
-
-				ce.push();
-				ce.set(A, a_value ? State::S1 : State::S0);
-				ce.set(B, b_value ? State::S1 : State::S0);
-
-				SigSpec sig = root;
-
-				if (!ce.eval(sig)) {
-					ce.pop();
-					return;
-				}
-
-				if (sig == State::S1)
-					func |= 1 << i;
-
-				ce.pop();
-			}
+			int func;
+			if (!eval_func(root, {B, A}, func))
+				return;
 
 			// log("%04d %s %s -> %s\n", bindec(func), log_signal(A), log_signal(B), log_signal(root));
 
@@ -202,30 +193,9 @@ struct ExtractFaWorker
 			SigBit B = SigSpec(leaves)[1];
 			SigBit C = SigSpec(leaves)[2];
 
-			int func = 0;
-			for (int i = 0; i < 8; i++)
-			{
-				bool a_value = (i & 1) != 0;
-				bool b_value = (i & 2) != 0;
-				bool c_value = (i & 4) != 0;
-
-				ce.push();
-				ce.set(A, a_value ? State::S1 : State::S0);
-				ce.set(B, b_value ? State::S1 : State::S0);
-				ce.set(C, c_value ? State::S1 : State::S0);
-
-				SigSpec sig = root;
-
-				if (!ce.eval(sig)) {
-					ce.pop();
-					return;
-				}
-
-				if (sig == State::S1)
-					func |= 1 << i;
-
-				ce.pop();
-			}
+			int func;
+			if (!eval_func(root, {C, B, A}, func))
+				return;
 
 			// log("%08d %s %s %s -> %s\n", bindec(func), log_signal(A), log_signal(B), log_signal(C), log_signal(root));
 
@@ -28,38 +28,56 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-IdString concat_name(RTLIL::Cell *cell, IdString object_name)
+// Per-instance data that is the same for all objects copied from the template,
+// computed once per flattened cell instead of once per object.
+struct FlattenCellInfo
 {
-	if (object_name[0] == '\\')
-		return stringf("%s.%s", cell->name.c_str(), object_name.c_str() + 1);
-	else {
-		std::string object_name_str = object_name.str();
-		if (object_name_str.substr(0, 8) == "$flatten")
-			object_name_str.erase(0, 8);
-		return stringf("$flatten%s.%s", cell->name.c_str(), object_name_str.c_str());
+	RTLIL::Cell *cell;
+	std::string public_prefix, private_prefix;
+	std::string hdlname_prefix;
+	pool<string> src;
+
+	FlattenCellInfo(RTLIL::Cell *cell) : cell(cell)
+	{
+		public_prefix = cell->name.str() + ".";
+		private_prefix = "$flatten" + public_prefix;
+		hdlname_prefix = cell->name.str().substr(1);
+		src = cell->get_strpool_attribute(ID::src);
 	}
-}
+
+	// Name of a template object in the parent: "<cell>.<name>" for public
+	// names, "$flatten<cell>.<name>" for private names.
+	IdString concat_name(IdString object_name) const
+	{
+		const char *str = object_name.c_str();
+		if (str[0] == '\\')
+			return public_prefix + (str + 1);
+		if (strncmp(str, "$flatten", 8) == 0)
+			str += 8;
+		return private_prefix + str;
+	}
+};
 
 template<class T>
-IdString map_name(RTLIL::Cell *cell, T *object)
+IdString map_name(const FlattenCellInfo &info, T *object)
 {
-	return cell->module->uniquify(concat_name(cell, object->name));
+	return info.cell->module->uniquify(info.concat_name(object->name));
 }
 
 template<class T>
-void map_attributes(RTLIL::Cell *cell, T *object, IdString orig_object_name)
+void map_attributes(const FlattenCellInfo &info, T *object, IdString orig_object_name)
 {
 	if (object->has_attribute(ID::src))
-		object->add_strpool_attribute(ID::src, cell->get_strpool_attribute(ID::src));
+		object->add_strpool_attribute(ID::src, info.src);
 
 	// Preserve original names via the hdlname attribute, but only for objects with a fully public name.
-	if (cell->name[0] == '\\' && (object->has_attribute(ID::hdlname) || orig_object_name[0] == '\\')) {
+	if (info.cell->name[0] == '\\' && (object->has_attribute(ID::hdlname) || orig_object_name[0] == '\\')) {
 		std::vector<std::string> hierarchy;
 		if (object->has_attribute(ID::hdlname))
 			hierarchy = object->get_hdlname_attribute();
 		else
-			hierarchy.push_back(orig_object_name.str().substr(1));
-		hierarchy.insert(hierarchy.begin(), cell->name.str().substr(1));
+			hierarchy.push_back(orig_object_name.c_str() + 1);
+		hierarchy.insert(hierarchy.begin(), info.hdlname_prefix);
 		object->set_hdlname_attribute(hierarchy);
 	}
 }
@@ -77,27 +95,57 @@ struct FlattenWorker
 {
 	bool ignore_wb = false;
 
+	// Information about a template module that is used for each of its
+	// instances. Templates are not modified while they are being instantiated.
+	struct TemplateInfo
+	{
+		dict<IdString, IdString> positional_ports;
+		pool<SigBit> driven;
+	};
+	dict<RTLIL::Module*, TemplateInfo> template_cache;
+
+	const TemplateInfo &template_info(RTLIL::Module *tpl)
+	{
+		auto it = template_cache.find(tpl);
+		if (it != template_cache.end())
+			return it->second;
+
+		TemplateInfo &info = template_cache[tpl];
+		for (auto tpl_wire : tpl->wires())
+			if (tpl_wire->port_id > 0)
+				info.positional_ports.emplace(stringf("$%d", tpl_wire->port_id), tpl_wire->name);
+		for (auto tpl_cell : tpl->cells())
+			for (auto &tpl_conn : tpl_cell->connections())
+				if (tpl_cell->output(tpl_conn.first))
+					for (auto bit : tpl_conn.second)
+						info.driven.insert(bit);
+		for (auto &tpl_conn : tpl->connections())
+			for (auto bit : tpl_conn.first)
+				info.driven.insert(bit);
+		return info;
+	}
+
 	void flatten_cell(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, SigMap &sigmap, std::vector<RTLIL::Cell*> &new_cells)
 	{
 		// Copy the contents of the flattened cell
 
+		FlattenCellInfo cell_info(cell);
+		const TemplateInfo &tpl_info = template_info(tpl);
+
 		dict<IdString, IdString> memory_map;
 		for (auto &tpl_memory_it : tpl->memories) {
-			RTLIL::Memory *new_memory = module->addMemory(map_name(cell, tpl_memory_it.second), tpl_memory_it.second);
-			map_attributes(cell, new_memory, tpl_memory_it.second->name);
+			RTLIL::Memory *new_memory = module->addMemory(map_name(cell_info, tpl_memory_it.second), tpl_memory_it.second);
+			map_attributes(cell_info, new_memory, tpl_memory_it.second->name);
 			memory_map[tpl_memory_it.first] = new_memory->name;
 			design->select(module, new_memory);
 		}
 
 		dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
-		dict<IdString, IdString> positional_ports;
+		wire_map.reserve(GetSize(tpl->wires_));
 		for (auto tpl_wire : tpl->wires()) {
-			if (tpl_wire->port_id > 0)
-				positional_ports.emplace(stringf("$%d", tpl_wire->port_id), tpl_wire->name);
-
 			RTLIL::Wire *new_wire = nullptr;
 			if (tpl_wire->name[0] == '\\') {
-				RTLIL::Wire *hier_wire = module->wire(concat_name(cell, tpl_wire->name));
+				RTLIL::Wire *hier_wire = module->wire(cell_info.concat_name(tpl_wire->name));
 				if (hier_wire != nullptr && hier_wire->get_bool_attribute(ID::hierconn)) {
 					hier_wire->attributes.erase(ID::hierconn);
 					if (GetSize(hier_wire) < GetSize(tpl_wire)) {
@@ -109,19 +157,19 @@ struct FlattenWorker
 				}
 			}
 			if (new_wire == nullptr) {
-				new_wire = module->addWire(map_name(cell, tpl_wire), tpl_wire);
+				new_wire = module->addWire(map_name(cell_info, tpl_wire), tpl_wire);
 				new_wire->port_input = new_wire->port_output = false;
 				new_wire->port_id = false;
 			}
 
-			map_attributes(cell, new_wire, tpl_wire->name);
+			map_attributes(cell_info, new_wire, tpl_wire->name);
 			wire_map[tpl_wire] = new_wire;
 			design->select(module, new_wire);
 		}
 
 		for (auto &tpl_proc_it : tpl->processes) {
-			RTLIL::Process *new_proc = module->addProcess(map_name(cell, tpl_proc_it.second), tpl_proc_it.second);
-			map_attributes(cell, new_proc, tpl_proc_it.second->name);
+			RTLIL::Process *new_proc = module->addProcess(map_name(cell_info, tpl_proc_it.second), tpl_proc_it.second);
+			map_attributes(cell_info, new_proc, tpl_proc_it.second->name);
 			for (auto new_proc_sync : new_proc->syncs)
 				for (auto &memwr_action : new_proc_sync->mem_write_actions)
 					memwr_action.memid = memory_map.at(memwr_action.memid).str();
@@ -131,14 +179,14 @@ struct FlattenWorker
 		}
 
 		for (auto tpl_cell : tpl->cells()) {
-			RTLIL::Cell *new_cell = module->addCell(map_name(cell, tpl_cell), tpl_cell);
-			map_attributes(cell, new_cell, tpl_cell->name);
+			RTLIL::Cell *new_cell = module->addCell(map_name(cell_info, tpl_cell), tpl_cell);
+			map_attributes(cell_info, new_cell, tpl_cell->name);
 			if (new_cell->has_memid()) {
 				IdString memid = new_cell->getParam(ID::MEMID).decode_string();
 				new_cell->setParam(ID::MEMID, Const(memory_map.at(memid).str()));
 			} else if (new_cell->is_mem_cell()) {
 				IdString memid = new_cell->getParam(ID::MEMID).decode_string();
-				new_cell->setParam(ID::MEMID, Const(concat_name(cell, memid).str()));
+				new_cell->setParam(ID::MEMID, Const(cell_info.concat_name(memid).str()));
 			}
 			auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
 			new_cell->rewrite_sigspecs(rewriter);
@@ -155,21 +203,11 @@ struct FlattenWorker
 
 		// Attach port connections of the flattened cell
 
-		pool<SigBit> tpl_driven;
-		for (auto tpl_cell : tpl->cells())
-			for (auto &tpl_conn : tpl_cell->connections())
-				if (tpl_cell->output(tpl_conn.first))
-					for (auto bit : tpl_conn.second)
-						tpl_driven.insert(bit);
-		for (auto &tpl_conn : tpl->connections())
-			for (auto bit : tpl_conn.first)
-				tpl_driven.insert(bit);
-
 		for (auto &port_it : cell->connections())
 		{
 			IdString port_name = port_it.first;
-			if (positional_ports.count(port_name) > 0)
-				port_name = positional_ports.at(port_name);
+			if (tpl_info.positional_ports.count(port_name) > 0)
+				port_name = tpl_info.positional_ports.at(port_name);
 			if (tpl->wire(port_name) == nullptr || tpl->wire(port_name)->port_id == 0) {
 				if (port_name.begins_with("$"))
 					log_error("Can't map port `%s' of cell `%s' to template `%s'!\n",
@@ -194,7 +232,7 @@ struct FlattenWorker
 			} else {
 				SigSpec sig_tpl = tpl_wire, sig_mod = port_it.second;
 				for (int i = 0; i < GetSize(sig_tpl) && i < GetSize(sig_mod); i++) {
-					if (tpl_driven.count(sig_tpl[i])) {
+					if (tpl_info.driven.count(sig_tpl[i])) {
 						new_conn.first.append(sig_mod[i]);
 						new_conn.second.append(sig_tpl[i]);
 					} else {
@@ -99,6 +99,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/modtools.h"
 #include "kernel/consteval.h"
+#include "kernel/threading.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -443,6 +444,271 @@ struct FlowGraph
 	}
 };
 
+// A dense copy of the gate graph, used for labeling. Node labels are
+// computed level by level; all nodes in a level depend only on the labels
+// of lower levels, so their cuts can be computed concurrently.
+struct DenseGateGraph
+{
+	vector<vector<int>> fanins, fanouts;
+	vector<bool> is_input;
+	vector<int> labels;
+};
+
+struct NodeCut
+{
+	int flow, label;
+	vector<int> gates, inputs;
+};
+
+// Computes the maximum flow and the minimum height cut of a node, as
+// FlowGraph does, but on the dense graph. The flow network is built in
+// arrays that are reused for every node handled by the same worker.
+//
+// The cone is traversed, and the gates and inputs of the cut are listed, in
+// the same order in which FlowGraph and its pools would visit them. The
+// area recovery heuristics break ties by iteration order, so this keeps
+// their results identical.
+struct CutFinder
+{
+	const DenseGateGraph &graph;
+	int order;
+
+	// Global node -> local flow network node. Local node 0 is the source,
+	// local node 1 is the sink, including all nodes collapsed into it.
+	int stamp = 0;
+	vector<int> node_stamp, node_local;
+	vector<int> cone, collapsed, worklist;
+
+	vector<int> edge_from, edge_to, edge_flow;
+	vector<vector<int>> out_edges, in_edges;
+	vector<int> node_flow;
+
+	// Search states are 2 * local + is_bottom.
+	vector<int> state_visit, state_parent, state_edge, queue;
+	int visit = 0;
+
+	CutFinder(const DenseGateGraph &graph, int order) : graph(graph), order(order)
+	{
+		node_stamp.resize(GetSize(graph.fanins));
+		node_local.resize(GetSize(graph.fanins));
+	}
+
+	void add_edge(int from, int to)
+	{
+		int edge = GetSize(edge_from);
+		edge_from.push_back(from);
+		edge_to.push_back(to);
+		edge_flow.push_back(0);
+		out_edges[from].push_back(edge);
+		in_edges[to].push_back(edge);
+	}
+
+	void build_network(int sink, int p)
+	{
+		// node_stamp is stamp while a node is on the worklist, stamp + 1
+		// once it was visited, and stamp + 2 once it was collapsed into
+		// the sink.
+		stamp += 3;
+		cone.clear();
+		collapsed.clear();
+		worklist.clear();
+		worklist.push_back(sink);
+		node_stamp[sink] = stamp;
+		while (!worklist.empty())
+		{
+			int node = worklist.back();
+			worklist.pop_back();
+			if (node_stamp[node] != stamp + 2)
+				node_stamp[node] = stamp + 1;
+			cone.push_back(node);
+			for (int node_pred : graph.fanins[node])
+			{
+				if (node_stamp[node_pred] < stamp && graph.labels[node_pred] != p) {
+					node_stamp[node_pred] = stamp;
+					worklist.push_back(node_pred);
+				}
+				if (node_stamp[node_pred] < stamp && graph.labels[node_pred] == p) {
+					node_stamp[node_pred] = stamp + 2;
+					collapsed.push_back(node_pred);
+					worklist.push_back(node_pred);
+				}
+			}
+		}
+
+		int num_local = 2;
+		for (int node : cone)
+			node_local[node] = (node == sink || node_stamp[node] == stamp + 2) ? 1 : num_local++;
+
+		edge_from.clear();
+		edge_to.clear();
+		edge_flow.clear();
+		if (GetSize(out_edges) < num_local) {
+			out_edges.resize(num_local);
+			in_edges.resize(num_local);
+		}
+		for (int i = 0; i < num_local; i++) {
+			out_edges[i].clear();
+			in_edges[i].clear();
+		}
+		node_flow.assign(num_local, 0);
+		if (GetSize(state_visit) < 2 * num_local) {
+			state_visit.resize(2 * num_local, 0);
+			state_parent.resize(2 * num_local);
+			state_edge.resize(2 * num_local);
+		}
+
+		for (int node : cone)
+		{
+			int local = node_local[node];
+			if (graph.is_input[node])
+				add_edge(0, local);
+			for (int node_pred : graph.fanins[node]) {
+				int local_pred = node_local[node_pred];
+				if (local_pred != local)
+					add_edge(local_pred, local);
+			}
+		}
+	}
+
+	// Every node except the source and sink has capacity 1 in the flow
+	// network. Augmenting paths are searched backwards from the sink, since
+	// the region of the cone close to the sink is usually much smaller than
+	// the region close to the source.
+	bool find_augmenting_path()
+	{
+		visit++;
+		queue.clear();
+		int source_bottom = 2 * 0 + 1, sink_top = 2 * 1 + 0;
+		state_visit[sink_top] = visit;
+		queue.push_back(sink_top);
+
+		// Here, state_parent is the next state on the path towards the sink.
+		auto enqueue = [&](int state, int next, int edge) {
+			if (state_visit[state] == visit)
+				return;
+			state_visit[state] = visit;
+			state_parent[state] = next;
+			state_edge[state] = edge;
+			queue.push_back(state);
+		};
+
+		for (int i = 0; i < GetSize(queue) && state_visit[source_bottom] != visit; i++)
+		{
+			int state = queue[i], local = state >> 1;
+			if (!(state & 1)) // top
+			{
+				if (node_flow[local] > 0)
+					enqueue(state | 1, state, -1);
+				for (int edge : in_edges[local])
+					enqueue(2 * edge_from[edge] + 1, state, edge);
+			}
+			else // bottom
+			{
+				if (local != 0 && node_flow[local] == 0)
+					enqueue(state & ~1, state, -1);
+				for (int edge : out_edges[local])
+					if (edge_flow[edge] > 0)
+						enqueue(2 * edge_to[edge], state, edge);
+			}
+		}
+
+		if (state_visit[source_bottom] != visit)
+			return false;
+
+		for (int state = source_bottom; state != sink_top; state = state_parent[state])
+		{
+			int edge = state_edge[state];
+			if (edge == -1)
+				node_flow[state >> 1] = (state & 1) ? 0 : 1;
+			else if (state & 1)
+				edge_flow[edge]++;
+			else
+				edge_flow[edge]--;
+		}
+		return true;
+	}
+
+	// Marks the states reachable from the source in the residual network,
+	// i.e. the source side of the minimum cut closest to the source.
+	void find_source_side()
+	{
+		visit++;
+		queue.clear();
+		int source_bottom = 2 * 0 + 1;
+		state_visit[source_bottom] = visit;
+		queue.push_back(source_bottom);
+
+		auto enqueue = [&](int state) {
+			if (state_visit[state] == visit)
+				return;
+			state_visit[state] = visit;
+			queue.push_back(state);
+		};
+
+		for (int i = 0; i < GetSize(queue); i++)
+		{
+			int state = queue[i], local = state >> 1;
+			if (!(state & 1)) // top
+			{
+				if (node_flow[local] == 0)
+					enqueue(state | 1);
+				for (int edge : in_edges[local])
+					if (edge_flow[edge] > 0)
+						enqueue(2 * edge_from[edge] + 1);
+			}
+			else // bottom
+			{
+				if (local != 0 && node_flow[local] > 0)
+					enqueue(state & ~1);
+				for (int edge : out_edges[local])
+					enqueue(2 * edge_to[edge]);
+			}
+		}
+	}
+
+	void find_cut(int sink, NodeCut &result)
+	{
+		int p = 1;
+		for (int node_pred : graph.fanins[sink])
+			p = max(p, graph.labels[node_pred]);
+
+		build_network(sink, p);
+		result.flow = 0;
+		while (result.flow <= order && find_augmenting_path())
+			result.flow++;
+		result.label = result.flow <= order ? p : p + 1;
+
+		result.gates.clear();
+		result.inputs.clear();
+		if (result.flow > order)
+		{
+			result.gates.push_back(sink);
+			result.inputs = graph.fanins[sink];
+			return;
+		}
+
+		find_source_side();
+		auto in_x = [&](int node) {
+			int local = node_local[node];
+			return local != 1 && state_visit[2 * local] == visit;
+		};
+		for (int i = GetSize(cone) - 1; i > 0; i--)
+			if (node_local[cone[i]] != 1 && !in_x(cone[i]))
+				result.gates.push_back(cone[i]);
+		result.gates.push_back(sink);
+		for (int i = GetSize(collapsed) - 1; i >= 0; i--)
+			result.gates.push_back(collapsed[i]);
+
+		stamp += 3;
+		for (int i = GetSize(result.gates) - 1; i >= 0; i--)
+			for (int node_pred : graph.fanins[result.gates[i]])
+				if (node_stamp[node_pred] != stamp && in_x(node_pred)) {
+					node_stamp[node_pred] = stamp;
+					result.inputs.push_back(node_pred);
+				}
+	}
+};
+
 struct FlowmapWorker
 {
 	int order;
@@ -668,28 +934,104 @@ struct FlowmapWorker
 
 	void label_nodes()
 	{
-		for (auto node : nodes)
+		vector<RTLIL::SigBit> node_list(nodes.begin(), nodes.end());
+		dict<RTLIL::SigBit, int> node_ids;
+		for (int i = 0; i < GetSize(node_list); i++)
+			node_ids[node_list[i]] = i;
+
+		DenseGateGraph graph;
+		graph.fanins.resize(GetSize(node_list));
+		graph.fanouts.resize(GetSize(node_list));
+		graph.is_input.resize(GetSize(node_list));
+		graph.labels.resize(GetSize(node_list), -1);
+		for (int i = 0; i < GetSize(node_list); i++)
+		{
+			auto node = node_list[i];
 			labels[node] = -1;
-		for (auto input : inputs)
+			if (inputs[node])
+			{
+				graph.is_input[i] = true;
+				if (node.wire->attributes.count(ID($flowmap_level)))
+					graph.labels[i] = node.wire->attributes[ID($flowmap_level)].as_int();
+				else
+					graph.labels[i] = 0;
+				labels[node] = graph.labels[i];
+			}
+			if (edges_bw.count(node))
+				for (auto node_pred : edges_bw.at(node))
+					graph.fanins[i].push_back(node_ids.at(node_pred));
+			if (edges_fw.count(node))
+				for (auto node_succ : edges_fw.at(node))
+					graph.fanouts[i].push_back(node_ids.at(node_succ));
+		}
+
+		// Group the gates into topological levels. Gates on a combinational
+		// loop never become ready and stay unlabeled.
+		vector<vector<int>> levels;
+		vector<int> pending(GetSize(node_list)), ready;
+		auto release = [&](int node, vector<int> &next_ready) {
+			for (int node_succ : graph.fanouts[node])
+				if (--pending[node_succ] == 0)
+					next_ready.push_back(node_succ);
+		};
+		for (int i = 0; i < GetSize(node_list); i++)
 		{
-			if (input.wire->attributes.count(ID($flowmap_level)))
-				labels[input] = input.wire->attributes[ID($flowmap_level)].as_int();
-			else
-				labels[input] = 0;
+			pending[i] = GetSize(graph.fanins[i]);
+			if (!graph.is_input[i] && pending[i] == 0)
+				ready.push_back(i);
+		}
+		for (int i = 0; i < GetSize(node_list); i++)
+			if (graph.is_input[i])
+				release(i, ready);
+		while (!ready.empty())
+		{
+			vector<int> next_ready;
+			for (int node : ready)
+				release(node, next_ready);
+			levels.push_back(std::move(ready));
+			ready.swap(next_ready);
+		}
+
+		int max_threads = debug ? 1 : yosys_max_threads();
+		vector<CutFinder> finders;
+		finders.reserve(max_threads);
+		for (int i = 0; i < max_threads; i++)
+			finders.emplace_back(graph, order);
+
+		vector<NodeCut> cuts(GetSize(node_list));
+		for (auto &level : levels)
+		{
+			int num_workers = min(max_threads, GetSize(level));
+			parallel_for(num_workers, [&](int worker) {
+				for (int i = worker; i < GetSize(level); i += num_workers)
+					finders[worker].find_cut(level[i], cuts[level[i]]);
+			}, num_workers);
+
+			// The labels of this level are only published once the whole
+			// level is done; no worker reads them.
+			for (int node : level)
+				graph.labels[node] = cuts[node].label;
 		}
 
-		pool<RTLIL::SigBit> worklist = nodes;
+		// Record the cuts in the order of the original worklist algorithm,
+		// which processes a node as soon as all its inputs are labeled.
+		vector<int> worklist;
+		vector<bool> in_worklist(GetSize(node_list), true), done = graph.is_input;
+		for (int i = GetSize(node_list) - 1; i >= 0; i--)
+			worklist.push_back(i);
 		int debug_num = 0;
 		while (!worklist.empty())
 		{
-			auto sink = worklist.pop();
-			if (labels[sink] != -1)
+			int node = worklist.back();
+			worklist.pop_back();
+			in_worklist[node] = false;
+			if (done[node])
 				continue;
 
 			bool inputs_have_labels = true;
-			for (auto sink_input : edges_bw[sink])
+			for (int node_pred : graph.fanins[node])
 			{
-				if (labels[sink_input] == -1)
+				if (!done[node_pred])
 				{
 					inputs_have_labels = false;
 					break;
@@ -697,53 +1039,41 @@ struct FlowmapWorker
 			}
 			if (!inputs_have_labels)
 				continue;
+			done[node] = true;
 
-			if (debug)
-			{
-				debug_num++;
-				log("Examining subgraph %d rooted in %s.\n", debug_num, log_signal(sink));
-			}
-
-			pool<RTLIL::SigBit> subgraph = find_subgraph(sink);
+			auto sink = node_list[node];
+			auto &cut = cuts[node];
+			labels[sink] = cut.label;
 
-			int p = 1;
-			for (auto subgraph_node : subgraph)
-				p = max(p, labels[subgraph_node]);
-
-			FlowGraph flow_graph = build_flow_graph(sink, p);
-			int flow = flow_graph.maximum_flow(order);
-			pool<RTLIL::SigBit> x, xi;
-			if (flow <= order)
-			{
-				labels[sink] = p;
-				auto cut = flow_graph.edge_cut();
-				x = cut.first;
-				xi = cut.second;
-			}
-			else
-			{
-				labels[sink] = p + 1;
-				x = subgraph;
-				x.erase(sink);
-				xi.insert(sink);
-			}
-			lut_gates[sink] = xi;
-
-			pool<RTLIL::SigBit> k;
-			for (auto xi_node : xi)
-			{
-				for (auto xi_node_pred : edges_bw[xi_node])
-					if (x[xi_node_pred])
-						k.insert(xi_node_pred);
-			}
+			pool<RTLIL::SigBit> xi, k;
+			for (int gate : cut.gates)
+				xi.insert(node_list[gate]);
+			for (int input : cut.inputs)
+				k.insert(node_list[input]);
 			log_assert((int)k.size() <= order);
+			lut_gates[sink] = xi;
 			lut_edges_bw[sink] = k;
 			for (auto k_node : k)
 				lut_edges_fw[k_node].insert(sink);
 
 			if (debug)
 			{
-				log("  Maximum flow: %d. Assigned label %d.\n", flow, labels[sink]);
+				debug_num++;
+				log("Examining subgraph %d rooted in %s.\n", debug_num, log_signal(sink));
+
+				pool<RTLIL::SigBit> subgraph = find_subgraph(sink);
+				int p = 1;
+				for (auto subgraph_node : subgraph)
+					if (subgraph_node != sink)
+						p = max(p, labels[subgraph_node]);
+				FlowGraph flow_graph = build_flow_graph(sink, p);
+				flow_graph.maximum_flow(order);
+				pool<RTLIL::SigBit> x;
+				for (auto subgraph_node : subgraph)
+					if (!xi[subgraph_node])
+						x.insert(subgraph_node);
+
+				log("  Maximum flow: %d. Assigned label %d.\n", cut.flow, labels[sink]);
 				dump_dot_graph(stringf("flowmap-%d-sub.dot", debug_num), GraphMode::Cut, subgraph, {}, {}, {x, xi});
 				log("  Dumped subgraph to `flowmap-%d-sub.dot`.\n", debug_num);
 				flow_graph.dump_dot_graph(stringf("flowmap-%d-flow.dot", debug_num));
@@ -757,9 +1087,14 @@ struct FlowmapWorker
 					log(" %s", log_signal(xi_node));
 				log(".\n");
 			}
+			cut = NodeCut();
 
-			for (auto sink_succ : edges_fw[sink])
-				worklist.insert(sink_succ);
+			for (int node_succ : graph.fanouts[node])
+				if (!in_worklist[node_succ])
+				{
+					in_worklist[node_succ] = true;
+					worklist.push_back(node_succ);
+				}
 		}
 
 		if (debug)
@@ -1020,7 +1355,8 @@ struct FlowmapWorker
 		{
 			pool<RTLIL::SigBit> invalidated = invalidate_lut_critical_outputs(lut_critical_outputs, worklist);
 			compute_lut_critical_outputs(lut_critical_outputs, invalidated);
-			check_lut_critical_outputs(lut_critical_outputs);
+			if (debug_relax)
+				check_lut_critical_outputs(lut_critical_outputs);
 		}
 		else
 			compute_lut_critical_outputs(lut_critical_outputs);
@@ -1345,6 +1681,7 @@ struct FlowmapWorker
 		ConstEval ce(module);
 		for (auto input_node : inputs)
 			ce.stop(input_node);
+		ConstEvalBatch ce_batch(module);
 
 		pool<RTLIL::SigBit> mapped_nodes;
 		for (auto node : lut_nodes)
@@ -1383,7 +1720,12 @@ struct FlowmapWorker
 			vector<RTLIL::SigBit> input_nodes(lut_edges_bw[node].begin(), lut_edges_bw[node].end());
 			RTLIL::Const lut_table(State::Sx, max(1 << input_nodes.size(), 1 << minlut));
 			unsigned const mask = 1 << input_nodes.size();
-			for (unsigned i = 0; i < mask; i++)
+			std::vector<TruthTable> tables;
+			RTLIL::SigSpec undef;
+			bool batch_ok = ce_batch.compile(input_nodes, node, undef) && ce_batch.eval_tables(tables);
+			for (unsigned i = 0; batch_ok && i < mask; i++)
+				lut_table[i] = tables[0].get(i) ? State::S1 : State::S0;
+			for (unsigned i = 0; !batch_ok && i < mask; i++)
 			{
 				ce.push();
 				for (size_t n = 0; n < input_nodes.size(); n++)
@@ -25,6 +25,9 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <map>
+#include <memory>
+#include <sys/stat.h>
 
 #ifndef FILTERLIB
 #include "kernel/log.h"
@@ -83,26 +86,36 @@ void LibertyAst::dump(FILE *f, std::string indent, std::string path, bool path_o
 		fprintf(f, " ;\n");
 }
 
+bool LibertyParser::fill_buffer()
+{
+	if (buffer.empty())
+		buffer.resize(1 << 16);
+	f.read(buffer.data(), buffer.size());
+	buffer_pos = 0;
+	buffer_len = f.gcount();
+	return buffer_len > 0;
+}
+
 int LibertyParser::lexer(std::string &str)
 {
 	int c;
 
 	// eat whitespace
 	do {
-		c = f.get();
+		c = get_char();
 	} while (c == ' ' || c == '\t' || c == '\r');
 
 	// search for identifiers, numbers, plus or minus.
 	if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_' || c == '-' || c == '+' || c == '.') {
 		str = static_cast<char>(c);
 		while (1) {
-			c = f.get();
+			c = get_char();
 			if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_' || c == '-' || c == '+' || c == '.')
 				str += c;
 			else
 				break;
 		}
-		f.unget();
+		unget_char();
 		if (str == "+" || str == "-") {
 			/* Single operator is not an identifier */
 			// fprintf(stderr, "LEX: char >>%s<<\n", str.c_str());
@@ -119,7 +132,7 @@ int LibertyParser::lexer(std::string &str)
 	if (c == '"') {
 		str = "";
 		while (1) {
-			c = f.get();
+			c = get_char();
 			if (c == '\n')
 				line++;
 			if (c == '"')
@@ -132,37 +145,37 @@ int LibertyParser::lexer(std::string &str)
 
 	// if it wasn't a string, perhaps it's a comment or a forward slash?
 	if (c == '/') {
-		c = f.get();
+		c = get_char();
 		if (c == '*') {         // start of '/*' block comment
 			int last_c = 0;
 			while (c > 0 && (last_c != '*' || c != '/')) {
 				last_c = c;
-				c = f.get();
+				c = get_char();
 				if (c == '\n')
 					line++;
 			}
 			return lexer(str);
 		} else if (c == '/') {  // start of '//' line comment
 			while (c > 0 && c != '\n')
-				c = f.get();
+				c = get_char();
 			line++;
 			return lexer(str);
 		}
-		f.unget();
+		unget_char();
 		// fprintf(stderr, "LEX: char >>/<<\n");
 		return '/';             // a single '/' charater.
 	}
 
 	// check for a backslash
 	if (c == '\\') {
-		c = f.get();		
+		c = get_char();		
 		if (c == '\r')
-			c = f.get();
+			c = get_char();
 		if (c == '\n') {
 			line++;
 			return lexer(str);
 		}
-		f.unget();
+		unget_char();
 		return '\\';
 	}
 
@@ -182,6 +195,54 @@ int LibertyParser::lexer(std::string &str)
 	return c;
 }
 
+// Skip the rest of a group after its opening '{', including all nested
+// groups.
+void LibertyParser::skip_group()
+{
+	int depth = 1;
+	while (depth > 0)
+	{
+		int c = get_char();
+		switch (c)
+		{
+		case EOF:
+			error("Unexpected end of file in group.");
+			break;
+		case '\n':
+			line++;
+			break;
+		case '{':
+			depth++;
+			break;
+		case '}':
+			depth--;
+			break;
+		case '"':
+			for (c = get_char(); c != '"' && c != EOF; c = get_char())
+				if (c == '\n')
+					line++;
+			break;
+		case '/':
+			c = get_char();
+			if (c == '*') {
+				int last_c = 0;
+				while (c > 0 && (last_c != '*' || c != '/')) {
+					last_c = c;
+					c = get_char();
+					if (c == '\n')
+						line++;
+				}
+			} else if (c == '/') {
+				while (c > 0 && c != '\n')
+					c = get_char();
+				line++;
+			} else
+				unget_char();
+			break;
+		}
+	}
+}
+
 LibertyAst *LibertyParser::parse()
 {
 	std::string str;
@@ -337,11 +398,18 @@ LibertyAst *LibertyParser::parse()
 		}
 
 		if (tok == '{') {
+			if (skip_groups.count(ast->id)) {
+				skip_group();
+				break;
+			}
 			while (1) {
 				LibertyAst *child = parse();
 				if (child == NULL)
 					break;
-				ast->children.push_back(child);
+				if (skip_groups.count(child->id))
+					delete child;
+				else
+					ast->children.push_back(child);
 			}
 			break;
 		}
@@ -352,8 +420,53 @@ LibertyAst *LibertyParser::parse()
 	return ast;
 }
 
+const std::set<std::string> &LibertyParser::timing_groups()
+{
+	static const std::set<std::string> groups = {
+		"timing", "internal_power", "leakage_power", "receiver_capacitance",
+		"output_current_rise", "output_current_fall", "ccsn_first_stage",
+		"ccsn_last_stage", "input_ccb", "output_ccb", "dynamic_current",
+		"lu_table_template", "power_lut_template", "output_current_template",
+		"normalized_driver_waveform"
+	};
+	return groups;
+}
+
 #ifndef FILTERLIB
 
+LibertyAst *LibertyParser::load(const std::string &filename, const std::set<std::string> &skip_groups)
+{
+	struct cache_entry_t {
+		off_t size;
+		time_t mtime;
+		std::unique_ptr<LibertyAst> ast;
+	};
+	static std::map<std::pair<std::string, std::set<std::string>>, cache_entry_t> cache;
+
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0)
+		log_cmd_error("Can't open liberty file `%s': %s\n", filename.c_str(), strerror(errno));
+
+	cache_entry_t &entry = cache[std::make_pair(filename, skip_groups)];
+	if (entry.ast != nullptr && entry.size == st.st_size && entry.mtime == st.st_mtime) {
+		log("Using cached liberty file `%s'.\n", filename.c_str());
+		return entry.ast.get();
+	}
+
+	std::ifstream f;
+	f.open(filename.c_str());
+	if (f.fail())
+		log_cmd_error("Can't open liberty file `%s': %s\n", filename.c_str(), strerror(errno));
+	LibertyParser parser(f, skip_groups);
+	f.close();
+
+	entry.size = st.st_size;
+	entry.mtime = st.st_mtime;
+	entry.ast.reset(parser.ast);
+	parser.ast = nullptr;
+	return entry.ast.get();
+}
+
 void LibertyParser::error()
 {
 	log_error("Syntax error in liberty file on line %d.\n", line);
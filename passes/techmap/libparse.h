@@ -43,17 +43,50 @@ namespace Yosys
 	{
 		std::istream &f;
 		int line;
+
+		// Groups (and attributes) with these names are skipped without
+		// building an AST for them.
+		std::set<std::string> skip_groups;
+
+		// The input is read in blocks, get_char() and unget_char() are much
+		// cheaper than the corresponding virtual istream calls.
+		std::vector<char> buffer;
+		size_t buffer_pos, buffer_len;
+
 		LibertyAst *ast;
-		LibertyParser(std::istream &f) : f(f), line(1), ast(parse()) {}
+		LibertyParser(std::istream &f, const std::set<std::string> &skip_groups = std::set<std::string>()) :
+				f(f), line(1), skip_groups(skip_groups), buffer_pos(0), buffer_len(0), ast(parse()) {}
 		~LibertyParser() { if (ast) delete ast; }
-        
+
+		// The groups with timing and power data, which make up most of a
+		// typical library but are not needed for mapping or area estimates.
+		static const std::set<std::string> &timing_groups();
+
+		// Parse a liberty file, or return the AST from an earlier call for the
+		// same (unchanged) file and skip_groups. The AST is owned by the cache.
+		static LibertyAst *load(const std::string &filename, const std::set<std::string> &skip_groups = std::set<std::string>());
+
+		int get_char() {
+			if (buffer_pos == buffer_len && !fill_buffer())
+				return EOF;
+			return (unsigned char)buffer[buffer_pos++];
+		}
+		void unget_char() {
+			// fill_buffer() empties the buffer at the end of the input, so
+			// this is a no-op after get_char() returned EOF.
+			if (buffer_pos > 0)
+				buffer_pos--;
+		}
+		bool fill_buffer();
+
         /* lexer return values:
            'v': identifier, string, array range [...] -> str holds the token string
            'n': newline
            anything else is a single character.
         */
 		int lexer(std::string &str);
-		
+		void skip_group();
+
         LibertyAst *parse();
 		void error();
         void error(const std::string &str);
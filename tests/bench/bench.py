@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+
+# Performance benchmark suite.
+#
+# Generates a set of scalable designs, runs each of them through a script
+# exercising the main passes, and records the time and memory use of every
+# pass (taken from the profile written by "yosys -J") in a JSON file, along
+# with the output throughput of write_json. With --baseline, the results are compared against an earlier run, and the
+# script fails if any benchmark got slower by more than the threshold.
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+
+class Bench:
+    def __init__(self, name, src, script):
+        self.name = name
+        self.src = src
+        self.script = script
+
+
+def gen_mult(scale):
+    width = 32 * scale
+    src = """
+module top(input [{w}:0] a, b, output [{w2}:0] y);
+	assign y = a * b;
+endmodule
+""".format(w=width - 1, w2=2 * width - 1)
+    return Bench("mult", src, ["proc", "opt", "wreduce", "alumacc", "opt", "techmap", "opt", "abc", "opt_clean", "write_json"])
+
+
+def gen_muxtree(scale):
+    sel = 8 + scale
+    width = 32
+    cases = []
+    for i in range(1 << sel):
+        cases.append("\t\t{}: y = {}'h{:x} ^ a;".format(i, width, (i * 0x9e3779b1) & ((1 << width) - 1)))
+    src = """
+module top(input [{s}:0] s, input [{w}:0] a, output reg [{w}:0] y);
+	always @* begin
+		case (s)
+{cases}
+		default: y = a;
+		endcase
+	end
+endmodule
+""".format(s=sel - 1, w=width - 1, cases="\n".join(cases))
+    return Bench("muxtree", src, ["proc", "opt -full", "techmap", "opt", "abc", "opt_clean", "write_json"])
+
+
+def gen_memory(scale):
+    count = 16 * scale
+    mods = []
+    for i in range(count):
+        abits = 8 + i % 4
+        dbits = 8 << (i % 3)
+        mods.append("""
+module ram{i}(input clk, we, input [{a}:0] wa, ra, input [{d}:0] wd, output reg [{d}:0] rd);
+	reg [{d}:0] mem [0:{n}];
+	always @(posedge clk) begin
+		if (we)
+			mem[wa] <= wd;
+		rd <= mem[ra];
+	end
+endmodule
+""".format(i=i, a=abits - 1, d=dbits - 1, n=(1 << abits) - 1))
+    insts = []
+    for i in range(count):
+        abits = 8 + i % 4
+        dbits = 8 << (i % 3)
+        insts.append("\twire [{d}:0] rd{i};\n\tram{i} r{i}(clk, we, wa[{a}:0], ra[{a}:0], wd[{d}:0], rd{i});\n\tassign y[{i}] = ^rd{i};".format(i=i, a=abits - 1, d=dbits - 1))
+    src = "".join(mods) + """
+module top(input clk, we, input [11:0] wa, ra, input [31:0] wd, output [{c}:0] y);
+{insts}
+endmodule
+""".format(c=count - 1, insts="\n".join(insts))
+    return Bench("memory", src, ["hierarchy -top top", "proc", "flatten", "opt", "memory -nomap", "memory_libmap -lib ../memlib/memlib_block_sdp.txt", "memory_map", "opt", "write_json"])
+
+
+def gen_hierarchy(scale):
+    depth = 64 * scale
+    mods = []
+    mods.append("""
+module level0(input clk, input [15:0] a, output reg [15:0] y);
+	always @(posedge clk)
+		y <= a + 16'd1;
+endmodule
+""")
+    for i in range(1, depth):
+        mods.append("""
+module level{i}(input clk, input [15:0] a, output reg [15:0] y);
+	wire [15:0] l, r;
+	level{p} u0(clk, a ^ 16'd{i}, l);
+	level{p} u1(clk, a, r);
+	always @(posedge clk)
+		y <= l - r;
+endmodule
+""".format(i=i, p=i - 1) if i % 16 == 0 and i <= 64 else """
+module level{i}(input clk, input [15:0] a, output reg [15:0] y);
+	wire [15:0] l;
+	level{p} u0(clk, a ^ 16'd{i}, l);
+	always @(posedge clk)
+		y <= l + a;
+endmodule
+""".format(i=i, p=i - 1))
+    src = "".join(mods) + """
+module top(input clk, input [15:0] a, output [15:0] y);
+	level{p} u(clk, a, y);
+endmodule
+""".format(p=depth - 1)
+    return Bench("hierarchy", src, ["hierarchy -top top", "proc", "flatten", "opt", "techmap", "opt", "write_json"])
+
+
+def gen_fsm(scale):
+    states = 64 * scale
+    trans = []
+    for i in range(states):
+        trans.append("\t\t\t{}: if (in[{}]) state <= {}; else if (in[{}]) state <= {};".format(
+            i, i % 8, (i * 7 + 1) % states, (i + 3) % 8, (i * 13 + 5) % states))
+    src = """
+module top(input clk, rst, input [7:0] in, output reg [7:0] out);
+	reg [{b}:0] state;
+	always @(posedge clk) begin
+		if (rst)
+			state <= 0;
+		else
+			case (state)
+{trans}
+			endcase
+	end
+	always @*
+		out = state * 8'd37;
+endmodule
+""".format(b=max(states - 1, 1).bit_length() - 1, trans="\n".join(trans))
+    return Bench("fsm", src, ["proc", "opt", "sim -clock clk -reset rst -n 1000", "fsm", "opt", "techmap", "opt", "abc", "write_json"])
+
+
+def gen_soc(scale):
+    cores = 16 * scale
+    src = """
+module core(input clk, rst, input [31:0] din, input [3:0] op, output reg [31:0] acc);
+	reg [31:0] regs [0:3];
+	wire [31:0] r = regs[op[1:0]];
+	always @(posedge clk) begin
+		if (rst)
+			acc <= 0;
+		else case (op[3:2])
+			0: acc <= acc + r;
+			1: acc <= acc ^ din;
+			2: acc <= acc << r[4:0];
+			3: acc <= acc - din;
+		endcase
+		regs[op[1:0]] <= acc;
+	end
+endmodule
+
+module top(input clk, rst, input [31:0] din, input [{o}:0] ops, output [31:0] y);
+	wire [31:0] acc [0:{c}];
+{insts}
+	assign y = {xor};
+endmodule
+""".format(o=4 * cores - 1, c=cores - 1,
+           insts="\n".join("\tcore c{i}(clk, rst, {d}, ops[{hi}:{lo}], acc[{i}]);".format(
+               i=i, d="din" if i == 0 else "acc[{}]".format(i - 1), hi=4 * i + 3, lo=4 * i) for i in range(cores)),
+           xor=" ^ ".join("acc[{}]".format(i) for i in range(cores)))
+    return Bench("soc", src, ["hierarchy -top top", "proc", "flatten", "opt", "memory", "opt", "techmap", "opt", "abc", "opt_clean", "write_json"])
+
+
+GENERATORS = [gen_mult, gen_muxtree, gen_memory, gen_hierarchy, gen_fsm, gen_soc]
+
+
+def run_bench(bench, yosys, use_abc):
+    with open("b_{}.v".format(bench.name), "w") as f:
+        f.write(bench.src)
+    cmds = ["read_verilog b_{}.v".format(bench.name)]
+    for cmd in bench.script:
+        if cmd == "abc" and not use_abc:
+            continue
+        if cmd == "write_json":
+            cmd = "write_json b_{}.json".format(bench.name)
+        cmds.append(cmd)
+    # Passing the commands with -p (instead of a script file with -s) makes
+    # every one of them a top-level event in the profile.
+    trace = "b_{}.trace.json".format(bench.name)
+    start = time.time()
+    with open("b_{}.log".format(bench.name), "w") as log:
+        rc = subprocess.call([yosys, "-q", "-J", trace, "-p", "; ".join(cmds)], stdout=log, stderr=subprocess.STDOUT)
+    wall = time.time() - start
+    if rc != 0:
+        print("{}: yosys failed, see b_{}.log".format(bench.name, bench.name))
+        return None
+    with open(trace) as f:
+        events = json.load(f)["traceEvents"]
+    result = {"wall_s": round(wall, 3), "peak_rss_kb": 0, "passes": {}}
+    end = 0
+    for ev in events:
+        result["peak_rss_kb"] = max(result["peak_rss_kb"], ev["args"]["peak_rss_kb"])
+        if ev["cat"] != "pass" or ev["ts"] < end:
+            continue
+        # Only count the top-level commands of the script, nested passes are
+        # already included in their parent.
+        end = ev["ts"] + ev["dur"]
+        p = result["passes"].setdefault(ev["name"], {"calls": 0, "wall_s": 0.0, "cpu_s": 0.0, "rss_delta_kb": 0})
+        p["calls"] += 1
+        p["wall_s"] = round(p["wall_s"] + ev["dur"] * 1e-6, 6)
+        p["cpu_s"] = round(p["cpu_s"] + ev["args"]["cpu_us"] * 1e-6, 6)
+        p["rss_delta_kb"] += ev["args"]["rss_delta_kb"]
+    # Throughput of the JSON backend: size of the written file divided by
+    # the time spent in write_json.
+    wj = result["passes"].get("write_json")
+    if wj is not None:
+        size = os.path.getsize("b_{}.json".format(bench.name))
+        result["write_json_mb_s"] = round(size / (1 << 20) / max(wj["wall_s"], 1e-6), 3)
+    return result
+
+
+def compare(baseline, results, threshold):
+    failed = False
+    print("{:<12} {:>10} {:>10} {:>8}   {:>10} {:>10} {:>8}".format("benchmark", "base [s]", "now [s]", "ratio", "base [MB]", "now [MB]", "ratio"))
+    for name, res in sorted(results["benchmarks"].items()):
+        base = baseline["benchmarks"].get(name)
+        if base is None or res is None:
+            print("{:<12} (not in both runs)".format(name))
+            continue
+        t_ratio = res["wall_s"] / max(base["wall_s"], 1e-3)
+        m_ratio = res["peak_rss_kb"] / max(base["peak_rss_kb"], 1)
+        flag = ""
+        if t_ratio > 1 + threshold or m_ratio > 1 + threshold:
+            flag = "  REGRESSION"
+            failed = True
+        print("{:<12} {:>10.3f} {:>10.3f} {:>8.2f}   {:>10.1f} {:>10.1f} {:>8.2f}{}".format(name,
+                base["wall_s"], res["wall_s"], t_ratio, base["peak_rss_kb"] / 1024, res["peak_rss_kb"] / 1024, m_ratio, flag))
+        if flag:
+            for pname, p in sorted(res["passes"].items()):
+                bp = base["passes"].get(pname)
+                if bp is not None and p["wall_s"] > bp["wall_s"] * (1 + threshold) and p["wall_s"] - bp["wall_s"] > 0.05:
+                    print("    {:<24} {:>10.3f} {:>10.3f}".format(pname, bp["wall_s"], p["wall_s"]))
+        if "write_json_mb_s" in base and "write_json_mb_s" in res:
+            j_ratio = res["write_json_mb_s"] / max(base["write_json_mb_s"], 1e-3)
+            flag = ""
+            if j_ratio < 1 / (1 + threshold):
+                flag = "  REGRESSION"
+                failed = True
+            print("    {:<24} {:>8.1f} MB/s {:>8.1f} MB/s {:>8.2f}{}".format("write_json", base["write_json_mb_s"], res["write_json_mb_s"], j_ratio, flag))
+    return not failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the Yosys performance benchmarks.")
+    parser.add_argument("--yosys", default="../../yosys", help="yosys binary to benchmark")
+    parser.add_argument("--scale", type=int, default=1, help="size multiplier for the generated designs")
+    parser.add_argument("--output", default="bench.json", help="file to write the results to")
+    parser.add_argument("--baseline", help="results of an earlier run to compare against")
+    parser.add_argument("--threshold", type=float, default=0.1, help="relative slowdown that counts as a regression")
+    parser.add_argument("--no-abc", action="store_true", help="skip the abc pass")
+    parser.add_argument("benchmarks", nargs="*", help="only run the given benchmarks")
+    args = parser.parse_args()
+
+    yosys = os.path.abspath(args.yosys)
+    version = subprocess.check_output([yosys, "-V"]).decode().strip()
+    results = {"yosys": version, "scale": args.scale, "benchmarks": {}}
+    for gen in GENERATORS:
+        bench = gen(args.scale)
+        if args.benchmarks and bench.name not in args.benchmarks:
+            continue
+        res = run_bench(bench, yosys, not args.no_abc)
+        results["benchmarks"][bench.name] = res
+        if res is not None:
+            print("{:<12} {:>8.3f} s {:>8.1f} MB {:>8.1f} MB/s write_json".format(bench.name, res["wall_s"],
+                    res["peak_rss_kb"] / 1024, res.get("write_json_mb_s", 0)))
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+    ok = all(res is not None for res in results["benchmarks"].values())
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if baseline.get("scale") != args.scale:
+            print("Warning: baseline was run with scale {}, this run uses {}.".format(baseline.get("scale"), args.scale))
+        ok = compare(baseline, results, args.threshold) and ok
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
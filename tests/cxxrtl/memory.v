@@ -0,0 +1,9 @@
+// A memory whose width and depth are not multiples of the 32-bit chunk size
+module top(input clk, input we, input [3:0] waddr, input [39:0] wdata,
+           input [3:0] raddr, output [39:0] rdata);
+	reg [39:0] mem [0:12];
+	always @(posedge clk)
+		if (we)
+			mem[waddr] <= wdata;
+	assign rdata = mem[raddr];
+endmodule
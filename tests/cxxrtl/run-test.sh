@@ -0,0 +1,6 @@
+#!/bin/bash
+set -ex
+
+../../yosys -q -p "read_verilog memory.v; write_cxxrtl cxxrtl-memory.cc"
+${CXX:-g++} -std=c++11 -O1 -I../.. -o cxxrtl-test-memory test_memory.cc
+./cxxrtl-test-memory
@@ -0,0 +1,107 @@
+// Loads an image into a memory through the CXXRTL C API, writes to it from
+// the simulated design, and dumps it back.
+
+#define CXXRTL_INCLUDE_CAPI_IMPL
+#include "cxxrtl-memory.cc"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		exit(1); \
+	} \
+} while (0)
+
+static const size_t depth = 13, stride = 2;
+
+static void set(cxxrtl_handle handle, const char *name, uint64_t data)
+{
+	cxxrtl_object *object = cxxrtl_get(handle, name);
+	CHECK(object != nullptr);
+	uint32_t *chunks = object->next ? object->next : object->curr;
+	chunks[0] = data;
+	if (object->width > 32)
+		chunks[1] = data >> 32;
+}
+
+static uint64_t get(cxxrtl_handle handle, const char *name)
+{
+	cxxrtl_object *object = cxxrtl_get(handle, name);
+	CHECK(object != nullptr);
+	uint64_t data = object->curr[0];
+	if (object->width > 32)
+		data |= uint64_t(object->curr[1]) << 32;
+	return data;
+}
+
+static uint64_t element(size_t index)
+{
+	return (uint64_t(index * 0x1234567) ^ 0xa5a5a5a5a5ull) & 0xffffffffffull;
+}
+
+int main()
+{
+	// The calloc()-backed storage of a memory starts out as all zeros
+	cxxrtl::memory<40> standalone(depth);
+	for (size_t i = 0; i < depth; i++)
+		CHECK(standalone[i].get<uint64_t>() == 0);
+
+	cxxrtl_handle handle = cxxrtl_create(cxxrtl_design_create());
+	cxxrtl_object *mem = cxxrtl_get(handle, "mem");
+	CHECK(mem != nullptr && mem->type == CXXRTL_MEMORY);
+	CHECK(mem->width == 40 && mem->depth == depth);
+
+	std::vector<uint32_t> image(stride * depth, 0xffffffff);
+	cxxrtl_memory_dump(mem, 0, image.data(), depth);
+	for (auto chunk : image)
+		CHECK(chunk == 0);
+
+	for (size_t i = 0; i < depth; i++) {
+		image[stride * i] = element(i);
+		image[stride * i + 1] = element(i) >> 32;
+	}
+	cxxrtl_memory_load(mem, 0, image.data(), depth);
+
+	set(handle, "clk", 0);
+	set(handle, "we", 0);
+	for (size_t i = 0; i < depth; i++) {
+		set(handle, "raddr", i);
+		cxxrtl_step(handle);
+		CHECK(get(handle, "rdata") == element(i));
+	}
+
+	// Write the last element from the design
+	set(handle, "we", 1);
+	set(handle, "waddr", depth - 1);
+	set(handle, "wdata", 0x123456789aull);
+	cxxrtl_step(handle);
+	set(handle, "clk", 1);
+	cxxrtl_step(handle);
+
+	std::vector<uint32_t> dump(stride * depth);
+	cxxrtl_memory_dump(mem, 0, dump.data(), depth);
+	for (size_t i = 0; i < depth - 1; i++) {
+		CHECK(dump[stride * i] == image[stride * i]);
+		CHECK(dump[stride * i + 1] == image[stride * i + 1]);
+	}
+	CHECK(dump[stride * (depth - 1)] == 0x3456789a);
+	CHECK(dump[stride * (depth - 1) + 1] == 0x12);
+
+	// Partial loads and dumps of a range at the end of the memory
+	uint32_t tail[stride * 3] = {1, 0, 2, 0, 3, 0};
+	cxxrtl_memory_load(mem, depth - 3, tail, 3);
+	uint32_t tail_dump[stride * 3];
+	cxxrtl_memory_dump(mem, depth - 3, tail_dump, 3);
+	for (size_t i = 0; i < stride * 3; i++)
+		CHECK(tail_dump[i] == tail[i]);
+	set(handle, "we", 0);
+	set(handle, "raddr", depth - 2);
+	cxxrtl_step(handle);
+	CHECK(get(handle, "rdata") == 2);
+
+	cxxrtl_destroy(handle);
+	return 0;
+}
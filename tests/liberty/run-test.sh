@@ -6,5 +6,7 @@ for x in *.lib; do
     echo "read_verilog small.v" > test.ys
     echo "synth -top small" >> test.ys
     echo "dfflibmap -info -liberty ${x}" >> test.ys
+    echo "stat -liberty ${x}" >> test.ys
 	../../yosys -ql ${x%.lib}.log -s test.ys
+	grep -q "Using cached liberty file" ${x%.lib}.log
 done
@@ -11,5 +11,7 @@ do
 done
 shift "$((OPTIND-1))"
 
+../../yosys -q cache.ys
+
 python3 generate.py
 exec ${MAKE:-make} -f run-test.mk SEED="$seed"
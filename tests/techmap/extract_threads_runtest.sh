@@ -0,0 +1,6 @@
+#!/bin/bash
+set -e
+
+# The haystacks are searched in parallel. Force several threads, so that the
+# attribute and parameter checks run concurrently on the shared needle cells.
+YOSYS_MAX_THREADS=4 ../../yosys -q extract_threads.ys
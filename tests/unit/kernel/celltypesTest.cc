@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/celltypes.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelCellTypesTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		// yosys_celltypes and the ID:: constants are set up by yosys_setup()
+		yosys_setup();
+	}
+};
+
+static void expect_same_types(const CellTypeTable &table, const CellTypes &ct)
+{
+	EXPECT_EQ(table.num_types(), GetSize(ct.cell_types));
+	for (auto &it : ct.cell_types) {
+		EXPECT_TRUE(table.cell_known(it.first));
+		EXPECT_EQ(table.cell_evaluable(it.first), ct.cell_evaluable(it.first));
+		for (auto port : {ID::A, ID::B, ID::Y, ID::Q, ID::CLK, ID::RD_DATA, ID(x), ID(y)}) {
+			EXPECT_EQ(table.cell_input(it.first, port), ct.cell_input(it.first, port));
+			EXPECT_EQ(table.cell_output(it.first, port), ct.cell_output(it.first, port));
+		}
+		for (auto port : it.second.inputs)
+			EXPECT_TRUE(table.cell_input(it.first, port));
+		for (auto port : it.second.outputs)
+			EXPECT_TRUE(table.cell_output(it.first, port));
+	}
+}
+
+TEST_F(KernelCellTypesTest, table)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(sub));
+	RTLIL::Wire *x = module->addWire(ID(x));
+	RTLIL::Wire *y = module->addWire(ID(y));
+	x->port_input = true;
+	y->port_output = true;
+	module->fixup_ports();
+
+	// A module with many ports, to exercise the sorted port lookup
+	RTLIL::Module *wide = design.addModule(ID(wide));
+	for (int i = 0; i < 20; i++) {
+		RTLIL::Wire *wire = wide->addWire(stringf("\\p%d", i));
+		wire->port_input = i % 2 == 0;
+		wire->port_output = i % 3 == 0;
+	}
+	wide->fixup_ports();
+
+	const CellTypeTable &table = design.cell_types();
+	expect_same_types(table, CellTypes(&design));
+	EXPECT_FALSE(table.cell_known(ID(nonexistent)));
+	EXPECT_FALSE(table.cell_input(ID(nonexistent), ID::A));
+	EXPECT_EQ(table.type_name(table.type_id(ID(sub))), ID(sub));
+	for (int i = 0; i < 20; i++) {
+		EXPECT_EQ(table.cell_input(ID(wide), stringf("\\p%d", i)), i % 2 == 0);
+		EXPECT_EQ(table.cell_output(ID(wide), stringf("\\p%d", i)), i % 3 == 0);
+	}
+
+	// The same object is returned, and brought up to date with port changes
+	x->port_output = true;
+	EXPECT_EQ(&design.cell_types(), &table);
+	EXPECT_TRUE(table.cell_output(ID(sub), ID(x)));
+	expect_same_types(table, CellTypes(&design));
+
+	design.remove(module);
+	design.cell_types();
+	EXPECT_FALSE(table.cell_known(ID(sub)));
+	expect_same_types(table, CellTypes(&design));
+
+	// Internal cell types take precedence over modules of the same name
+	RTLIL::Module *add = design.addModule(ID($add));
+	add->addWire(ID(x))->port_input = true;
+	add->fixup_ports();
+	design.cell_types();
+	EXPECT_TRUE(table.cell_input(ID($add), ID::A));
+	EXPECT_FALSE(table.cell_input(ID($add), ID(x)));
+	EXPECT_TRUE(table.cell_evaluable(ID($add)));
+	expect_same_types(table, CellTypes(&design));
+}
+
+YOSYS_NAMESPACE_END
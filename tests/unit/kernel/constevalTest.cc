@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/consteval.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+static uint32_t next_random(uint32_t &seed)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+class KernelConstEvalTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		yosys_setup();
+	}
+
+	// Compares ConstEvalBatch against ConstEval for 64 random values of
+	// the inputs, one pattern at a time.
+	void check(RTLIL::Module *module, RTLIL::SigSpec inputs, RTLIL::SigSpec outputs, uint32_t &seed)
+	{
+		ConstEvalBatch batch(module);
+		RTLIL::SigSpec undef;
+		ASSERT_TRUE(batch.compile(inputs, outputs, undef)) << log_signal(undef);
+
+		std::vector<uint64_t> words;
+		for (int i = 0; i < GetSize(inputs); i++) {
+			uint64_t word = (uint64_t(next_random(seed)) << 32) | next_random(seed);
+			words.push_back(word);
+			batch.set(i, word);
+		}
+		ASSERT_TRUE(batch.eval());
+
+		ConstEval ce(module);
+		for (int pattern = 0; pattern < 64; pattern++) {
+			RTLIL::Const value(State::S0, GetSize(inputs));
+			for (int i = 0; i < GetSize(inputs); i++)
+				if ((words[i] >> pattern) & 1)
+					value.bits[i] = State::S1;
+
+			ce.push();
+			ce.set(inputs, value);
+			RTLIL::SigSpec expected = outputs;
+			ASSERT_TRUE(ce.eval(expected));
+			ce.pop();
+
+			for (int k = 0; k < GetSize(outputs); k++)
+				EXPECT_EQ(expected[k] == State::S1, ((batch.get(k) >> pattern) & 1) != 0)
+						<< "output bit " << k << " for pattern " << value.as_string()
+						<< " in " << log_id(module);
+		}
+	}
+};
+
+TEST_F(KernelConstEvalTest, batchArith)
+{
+	uint32_t seed = 1;
+	for (int iter = 0; iter < 200; iter++)
+	{
+		RTLIL::Design design;
+		RTLIL::Module *module = design.addModule(ID(top));
+		int width_a = 1 + next_random(seed) % 8;
+		int width_b = 1 + next_random(seed) % 8;
+		int width_y = 1 + next_random(seed) % 10;
+		bool is_signed = next_random(seed) & 1;
+		RTLIL::Wire *a = module->addWire(ID(a), width_a);
+		RTLIL::Wire *b = module->addWire(ID(b), width_b);
+
+		module->addAdd(ID(add), a, b, module->addWire(ID(y_add), width_y), is_signed);
+		module->addSub(ID(sub), a, b, module->addWire(ID(y_sub), width_y), is_signed);
+		module->addNeg(ID(neg), a, module->addWire(ID(y_neg), width_y), is_signed);
+		module->addPos(ID(pos), b, module->addWire(ID(y_pos), width_y), is_signed);
+		module->addNot(ID(not), a, module->addWire(ID(y_not), width_y), is_signed);
+		module->addAnd(ID(and), a, b, module->addWire(ID(y_and), width_y), is_signed);
+		module->addXnor(ID(xnor), a, b, module->addWire(ID(y_xnor), width_y), is_signed);
+		module->addEq(ID(eq), a, b, module->addWire(ID(y_eq), 2), is_signed);
+		module->addNe(ID(ne), a, b, module->addWire(ID(y_ne), 1), is_signed);
+
+		// A second level, so that the cone is levelized.
+		module->addSub(ID(sub2), module->wire(ID(y_add)), module->wire(ID(y_neg)),
+				module->addWire(ID(y_sub2), width_y), is_signed);
+
+		RTLIL::SigSpec outputs;
+		for (auto wire : module->wires())
+			if (wire->name.begins_with("\\y_"))
+				outputs.append(wire);
+		check(module, {b, a}, outputs, seed);
+	}
+}
+
+TEST_F(KernelConstEvalTest, batchLogic)
+{
+	uint32_t seed = 2;
+	for (int iter = 0; iter < 200; iter++)
+	{
+		RTLIL::Design design;
+		RTLIL::Module *module = design.addModule(ID(top));
+		int width_a = 1 + next_random(seed) % 8;
+		int width_b = 1 + next_random(seed) % 8;
+		int width_y = 1 + next_random(seed) % 3;
+		RTLIL::Wire *a = module->addWire(ID(a), width_a);
+		RTLIL::Wire *b = module->addWire(ID(b), width_b);
+		RTLIL::Wire *s = module->addWire(ID(s));
+
+		module->addReduceAnd(ID(reduce_and), a, module->addWire(ID(y_reduce_and), width_y));
+		module->addReduceOr(ID(reduce_or), a, module->addWire(ID(y_reduce_or), width_y));
+		module->addReduceXor(ID(reduce_xor), a, module->addWire(ID(y_reduce_xor), width_y));
+		module->addReduceXnor(ID(reduce_xnor), b, module->addWire(ID(y_reduce_xnor), width_y));
+		module->addReduceBool(ID(reduce_bool), b, module->addWire(ID(y_reduce_bool), width_y));
+		module->addLogicNot(ID(logic_not), a, module->addWire(ID(y_logic_not), width_y));
+		module->addLogicAnd(ID(logic_and), a, b, module->addWire(ID(y_logic_and), width_y));
+		module->addLogicOr(ID(logic_or), a, b, module->addWire(ID(y_logic_or), width_y));
+		RTLIL::SigSpec mux_b = RTLIL::SigSpec(b).extract(0, std::min(width_a, width_b));
+		mux_b.extend_u0(width_a);
+		module->addMux(ID(mux), a, mux_b, s, module->addWire(ID(y_mux), width_a));
+		module->addAndnotGate(ID(andnot), RTLIL::SigSpec(a)[0], RTLIL::SigSpec(b)[0], module->addWire(ID(y_andnot)));
+		module->addAoi3Gate(ID(aoi3), RTLIL::SigSpec(a)[0], RTLIL::SigSpec(b)[0], s, module->addWire(ID(y_aoi3)));
+
+		RTLIL::SigSpec outputs;
+		for (auto wire : module->wires())
+			if (wire->name.begins_with("\\y_"))
+				outputs.append(wire);
+		check(module, {s, b, a}, outputs, seed);
+	}
+}
+
+TEST_F(KernelConstEvalTest, batchGeneric)
+{
+	uint32_t seed = 3;
+	for (int iter = 0; iter < 100; iter++)
+	{
+		RTLIL::Design design;
+		RTLIL::Module *module = design.addModule(ID(top));
+		int width_a = 1 + next_random(seed) % 6;
+		int width_b = 1 + next_random(seed) % 4;
+		int width_y = 1 + next_random(seed) % 8;
+		bool is_signed = next_random(seed) & 1;
+		RTLIL::Wire *a = module->addWire(ID(a), width_a);
+		RTLIL::Wire *b = module->addWire(ID(b), width_b);
+
+		// These have no word-level evaluator and go through CellTypes::eval().
+		module->addMul(ID(mul), a, b, module->addWire(ID(y_mul), width_y), is_signed);
+		module->addShl(ID(shl), a, b, module->addWire(ID(y_shl), width_y), is_signed);
+		module->addSshr(ID(sshr), a, b, module->addWire(ID(y_sshr), width_y), is_signed);
+		module->addLt(ID(lt), a, b, module->addWire(ID(y_lt), 1), is_signed);
+
+		// A generic cell feeding a word-level one and the other way around.
+		RTLIL::Wire *sum = module->addWire(ID(sum), width_y);
+		module->addAdd(ID(add), a, b, sum, is_signed);
+		module->addGe(ID(ge), sum, module->wire(ID(y_mul)), module->addWire(ID(y_ge), 1), is_signed);
+		module->addEq(ID(eq), module->wire(ID(y_shl)), sum, module->addWire(ID(y_eq), 1));
+
+		RTLIL::SigSpec outputs;
+		for (auto wire : module->wires())
+			if (wire->name.begins_with("\\y_"))
+				outputs.append(wire);
+		check(module, {b, a}, outputs, seed);
+	}
+}
+
+TEST_F(KernelConstEvalTest, batchRejects)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a), 4);
+	RTLIL::Wire *y = module->addWire(ID(y), 4);
+	RTLIL::Wire *z = module->addWire(ID(z), 4);
+	module->addAnd(ID(and), a, RTLIL::Const(State::Sx, 4), y);
+	module->addAdd(ID(add), a, z, z);
+
+	ConstEvalBatch batch(module);
+	RTLIL::SigSpec undef;
+	EXPECT_FALSE(batch.compile(a, y, undef));
+	undef = RTLIL::SigSpec();
+	EXPECT_FALSE(batch.compile(a, z, undef));
+}
+
+YOSYS_NAMESPACE_END
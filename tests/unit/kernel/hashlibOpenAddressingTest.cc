@@ -0,0 +1,6 @@
+// The hashlib tests again, with the open addressing index that is only used
+// in ENABLE_HASHLIB_OA builds.
+#ifndef HASHLIB_OPEN_ADDRESSING
+#  define HASHLIB_OPEN_ADDRESSING
+#endif
+#include "hashlibTest.cc"
@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include "kernel/hashlib.h"
+
+// Only hashlib is included here, and all containers are instantiated with
+// the key type below, so that this test can also be built with a different
+// index layout than libyosys (see hashlibOpenAddressingTest.cc).
+
+#ifdef HASHLIB_OPEN_ADDRESSING
+#  define HASHLIB_TEST(name) TEST(KernelHashlibOpenAddressingTest, name)
+#else
+#  define HASHLIB_TEST(name) TEST(KernelHashlibTest, name)
+#endif
+
+using namespace hashlib;
+
+namespace {
+
+// Key with a weak hash, so that there are plenty of collisions to probe past
+struct Key
+{
+	int value;
+	Key(int value = 0) : value(value) { }
+	bool operator==(const Key &other) const { return value == other.value; }
+	bool operator<(const Key &other) const { return value < other.value; }
+	unsigned int hash() const { return value % 257; }
+};
+
+uint32_t next_random(uint32_t &seed)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+// Reference model of the entries vector of a dict: new entries are appended,
+// and an erased entry is replaced by the last one. Iteration runs backwards.
+struct Reference
+{
+	std::vector<std::pair<int, int>> entries;
+	std::map<int, int> index;
+
+	bool insert(int key, int value)
+	{
+		if (index.count(key))
+			return false;
+		index[key] = entries.size();
+		entries.push_back(std::make_pair(key, value));
+		return true;
+	}
+
+	bool erase(int key)
+	{
+		auto it = index.find(key);
+		if (it == index.end())
+			return false;
+		int i = it->second;
+		index.erase(it);
+		if (i != int(entries.size()) - 1) {
+			entries[i] = entries.back();
+			index[entries[i].first] = i;
+		}
+		entries.pop_back();
+		return true;
+	}
+};
+
+void expect_same(const dict<Key, int> &d, const Reference &ref)
+{
+	ASSERT_EQ(d.size(), ref.entries.size());
+	int i = ref.entries.size();
+	for (auto &it : d) {
+		i--;
+		EXPECT_EQ(it.first.value, ref.entries[i].first);
+		EXPECT_EQ(it.second, ref.entries[i].second);
+	}
+}
+
+void expect_same(const pool<Key> &p, const Reference &ref)
+{
+	ASSERT_EQ(p.size(), ref.entries.size());
+	int i = ref.entries.size();
+	for (auto &it : p)
+		EXPECT_EQ(it.value, ref.entries[--i].first);
+}
+
+}
+
+HASHLIB_TEST(dictRandom)
+{
+	uint32_t seed = 1;
+	dict<Key, int> d;
+	Reference ref;
+
+	for (int iter = 0; iter < 100000; iter++) {
+		int key = next_random(seed) % 4096;
+		switch (next_random(seed) % 8) {
+		case 0:
+		case 1:
+		case 2: {
+			int value = next_random(seed) % 1000;
+			bool inserted = ref.insert(key, value);
+			auto r = d.insert(std::make_pair(Key(key), value));
+			EXPECT_EQ(r.second, inserted);
+			EXPECT_EQ(r.first->first.value, key);
+			break;
+		}
+		case 3:
+			EXPECT_EQ(d.erase(Key(key)), ref.erase(key) ? 1 : 0);
+			break;
+		case 4: {
+			auto it = d.find(Key(key));
+			if (ref.index.count(key)) {
+				ASSERT_TRUE(it != d.end());
+				EXPECT_EQ(it->second, ref.entries[ref.index.at(key)].second);
+			} else {
+				EXPECT_TRUE(it == d.end());
+			}
+			break;
+		}
+		case 5:
+			// operator[] inserts a default value
+			if (ref.insert(key, 0)) {
+				EXPECT_EQ(d[Key(key)], 0);
+			}
+			d[Key(key)] = iter;
+			ref.entries[ref.index.at(key)].second = iter;
+			break;
+		case 6:
+			EXPECT_EQ(d.count(Key(key)), int(ref.index.count(key)));
+			break;
+		case 7:
+			// Erasing through an iterator continues with the next entry
+			if (!d.empty() && next_random(seed) % 16 == 0) {
+				auto it = d.begin();
+				int key = it->first.value;
+				it = d.erase(it);
+				ref.erase(key);
+				if (it != d.end()) {
+					EXPECT_EQ(it->first.value, ref.entries.back().first);
+				}
+			}
+			break;
+		}
+
+		if (iter % 997 == 0)
+			expect_same(d, ref);
+
+		// Shrink from time to time, so that the erase and rehash paths
+		// are exercised at all sizes
+		if (iter % 20000 == 19999) {
+			while (d.size() > 100) {
+				int key = d.begin()->first.value;
+				EXPECT_EQ(d.erase(Key(key)), 1);
+				ref.erase(key);
+			}
+			expect_same(d, ref);
+		}
+	}
+
+	expect_same(d, ref);
+
+	dict<Key, int> copy = d;
+	EXPECT_TRUE(copy == d);
+	copy.sort();
+	EXPECT_TRUE(copy == d);
+	Key last(-1);
+	for (auto &it : copy) {
+		EXPECT_TRUE(last < it.first);
+		last = it.first;
+	}
+	for (auto &it : ref.entries)
+		EXPECT_EQ(copy.at(Key(it.first)), it.second);
+
+	copy.clear();
+	EXPECT_TRUE(copy.empty());
+	EXPECT_EQ(copy.count(Key(0)), 0);
+	copy[Key(1)] = 2;
+	EXPECT_EQ(copy.at(Key(1)), 2);
+}
+
+HASHLIB_TEST(poolRandom)
+{
+	uint32_t seed = 2;
+	pool<Key> p;
+	Reference ref;
+
+	for (int iter = 0; iter < 100000; iter++) {
+		int key = next_random(seed) % 2048;
+		switch (next_random(seed) % 4) {
+		case 0:
+		case 1:
+			EXPECT_EQ(p.insert(Key(key)).second, ref.insert(key, 0));
+			break;
+		case 2:
+			EXPECT_EQ(p.erase(Key(key)), ref.erase(key) ? 1 : 0);
+			break;
+		case 3:
+			EXPECT_EQ(p.count(Key(key)), int(ref.index.count(key)));
+			break;
+		}
+		if (iter % 997 == 0)
+			expect_same(p, ref);
+	}
+	expect_same(p, ref);
+
+	pool<Key> other;
+	other.swap(p);
+	EXPECT_TRUE(p.empty());
+	expect_same(other, ref);
+}
+
+HASHLIB_TEST(idictRandom)
+{
+	uint32_t seed = 3;
+	idict<Key> id;
+	std::map<int, int> ref;
+
+	for (int iter = 0; iter < 50000; iter++) {
+		int key = next_random(seed) % 8192;
+		if (next_random(seed) % 2) {
+			int index = id(Key(key));
+			auto r = ref.insert(std::make_pair(key, int(ref.size())));
+			EXPECT_EQ(index, r.first->second);
+		} else {
+			EXPECT_EQ(id.count(Key(key)), int(ref.count(key)));
+		}
+	}
+
+	ASSERT_EQ(id.size(), ref.size());
+	for (auto &it : ref) {
+		EXPECT_EQ(id.at(Key(it.first)), it.second);
+		EXPECT_EQ(id[it.second].value, it.first);
+	}
+}
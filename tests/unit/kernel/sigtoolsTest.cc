@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// The SigMap implementation before the flat union-find, on top of mfp<>
+struct ReferenceSigMap
+{
+	mfp<SigBit> database;
+
+	void add(const RTLIL::SigSpec &from, const RTLIL::SigSpec &to)
+	{
+		for (int i = 0; i < GetSize(from); i++) {
+			int bfi = database.lookup(from[i]);
+			int bti = database.lookup(to[i]);
+			const RTLIL::SigBit &bf = database[bfi];
+			const RTLIL::SigBit &bt = database[bti];
+			if (bf.wire || bt.wire) {
+				database.imerge(bfi, bti);
+				if (bf.wire == nullptr)
+					database.ipromote(bfi);
+				if (bt.wire == nullptr)
+					database.ipromote(bti);
+			}
+		}
+	}
+
+	void add(const RTLIL::SigBit &bit)
+	{
+		const auto &b = database.find(bit);
+		if (b.wire != nullptr)
+			database.promote(bit);
+	}
+
+	RTLIL::SigBit operator()(const RTLIL::SigBit &bit) const
+	{
+		return database.find(bit);
+	}
+};
+
+static uint32_t next_random(uint32_t &seed)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+class KernelSigtoolsTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		yosys_setup();
+	}
+};
+
+TEST_F(KernelSigtoolsTest, sigmapBasic)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a), 4);
+	RTLIL::Wire *b = module->addWire(ID(b), 4);
+	RTLIL::Wire *c = module->addWire(ID(c), 2);
+	module->connect(a, b);
+	module->connect(RTLIL::SigSpec(c), RTLIL::Const(2, 2));
+
+	SigMap sigmap(module);
+	EXPECT_EQ(sigmap(a), RTLIL::SigSpec(b));
+	EXPECT_EQ(sigmap(b), RTLIL::SigSpec(b));
+	EXPECT_EQ(sigmap(c), RTLIL::SigSpec(RTLIL::Const(2, 2)));
+	EXPECT_EQ(sigmap(RTLIL::SigBit(State::S1)), RTLIL::SigBit(State::S1));
+
+	// Bits that were never added map to themselves
+	RTLIL::Wire *d = module->addWire(ID(d), 3);
+	EXPECT_EQ(sigmap(d), RTLIL::SigSpec(d));
+
+	// The last added bit becomes the representative
+	sigmap.add(RTLIL::SigBit(a, 1));
+	EXPECT_EQ(sigmap(RTLIL::SigBit(b, 1)), RTLIL::SigBit(a, 1));
+	EXPECT_EQ(sigmap(RTLIL::SigBit(b, 0)), RTLIL::SigBit(b, 0));
+
+	// Constants stay the representative
+	sigmap.add(RTLIL::SigBit(c, 0));
+	EXPECT_EQ(sigmap(RTLIL::SigBit(c, 0)), RTLIL::SigBit(State::S0));
+
+	// allbits() contains the wire bits in the database
+	pool<RTLIL::SigBit> allbits;
+	for (auto bit : sigmap.allbits())
+		allbits.insert(bit);
+	EXPECT_EQ(GetSize(allbits), 10);
+	EXPECT_EQ(allbits.count(RTLIL::SigBit(d, 0)), 0);
+
+	SigMap other;
+	other.swap(sigmap);
+	EXPECT_EQ(sigmap(a), RTLIL::SigSpec(a));
+	EXPECT_EQ(other(RTLIL::SigBit(a, 0)), RTLIL::SigBit(b, 0));
+	other.clear();
+	EXPECT_EQ(other(a), RTLIL::SigSpec(a));
+	EXPECT_EQ(GetSize(other.allbits()), 0);
+}
+
+TEST_F(KernelSigtoolsTest, sigmapPathCompression)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	std::vector<RTLIL::Wire*> wires;
+	for (int i = 0; i < 1000; i++)
+		wires.push_back(module->addWire(stringf("\\w%d", i)));
+
+	// A chain where each add hangs the old root below the new one
+	SigMap sigmap;
+	for (int i = 1; i < 1000; i++)
+		sigmap.add(wires[i - 1], wires[i]);
+
+	EXPECT_EQ(sigmap(wires[0]), RTLIL::SigSpec(wires[999]));
+	for (auto wire : wires) {
+		int n = sigmap.node(RTLIL::SigBit(wire), false);
+		ASSERT_GE(n, 0);
+		int p = sigmap.parents[n];
+		EXPECT_TRUE(p == -1 || sigmap.parents[p] == -1);
+	}
+}
+
+TEST_F(KernelSigtoolsTest, sigmapWireCache)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a), 8);
+	RTLIL::Wire *b = module->addWire(ID(b), 8);
+
+	SigMap sigmap;
+	sigmap.add(RTLIL::SigSpec(a), RTLIL::SigSpec(b));
+
+	// Alternate between the wires, so that the cached wire keeps changing
+	for (int i = 0; i < 8; i++) {
+		EXPECT_EQ(sigmap(RTLIL::SigBit(a, i)), RTLIL::SigBit(b, i));
+		EXPECT_EQ(sigmap(RTLIL::SigBit(b, i)), RTLIL::SigBit(b, i));
+	}
+
+	// A wire that grows after its nodes have been allocated
+	a->width = 12;
+	EXPECT_EQ(sigmap(RTLIL::SigBit(a, 10)), RTLIL::SigBit(a, 10));
+	sigmap.add(RTLIL::SigSpec(a).extract(8, 4), RTLIL::Const(5, 4));
+	EXPECT_EQ(sigmap(RTLIL::SigSpec(a).extract(8, 4)), RTLIL::SigSpec(RTLIL::Const(5, 4)));
+	EXPECT_EQ(sigmap(RTLIL::SigBit(a, 3)), RTLIL::SigBit(b, 3));
+}
+
+TEST_F(KernelSigtoolsTest, sigmapRandom)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	std::vector<RTLIL::Wire*> wires;
+	for (int i = 0; i < 40; i++)
+		wires.push_back(module->addWire(stringf("\\w%d", i), 1 + i % 5));
+
+	uint32_t seed = 1;
+	auto random_bit = [&]() {
+		if (next_random(seed) % 8 == 0)
+			return RTLIL::SigBit(RTLIL::State(next_random(seed) % 4));
+		RTLIL::Wire *wire = wires[next_random(seed) % GetSize(wires)];
+		return RTLIL::SigBit(wire, next_random(seed) % wire->width);
+	};
+
+	for (int round = 0; round < 20; round++) {
+		SigMap sigmap;
+		ReferenceSigMap reference;
+		for (int i = 0; i < 60; i++) {
+			if (next_random(seed) % 4 == 0) {
+				RTLIL::SigBit bit = random_bit();
+				sigmap.add(bit);
+				reference.add(bit);
+				continue;
+			}
+			RTLIL::SigSpec from, to;
+			int width = 1 + next_random(seed) % 3;
+			for (int k = 0; k < width; k++) {
+				from.append(random_bit());
+				to.append(random_bit());
+			}
+			sigmap.add(from, to);
+			reference.add(from, to);
+		}
+
+		for (auto wire : wires)
+			for (int k = 0; k < wire->width; k++)
+				EXPECT_EQ(sigmap(RTLIL::SigBit(wire, k)), reference(RTLIL::SigBit(wire, k)));
+	}
+}
+
+YOSYS_NAMESPACE_END
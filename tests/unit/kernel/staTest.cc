@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/sta.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Adds a (* blackbox *) module with inputs a, b and output y, with a delay
+// of a_delay from a to y and b_delay from b to y.
+static void add_gate_type(RTLIL::Design *design, RTLIL::IdString name, int a_delay, int b_delay)
+{
+	RTLIL::Module *module = design->addModule(name);
+	module->set_bool_attribute(ID::blackbox);
+	RTLIL::Wire *a = module->addWire(ID::A);
+	RTLIL::Wire *b = module->addWire(ID::B);
+	RTLIL::Wire *y = module->addWire(ID::Y);
+	a->port_input = true;
+	b->port_input = true;
+	y->port_output = true;
+	module->fixup_ports();
+
+	for (auto &it : {std::make_pair(a, a_delay), std::make_pair(b, b_delay)}) {
+		RTLIL::Cell *cell = module->addCell(NEW_ID, ID($specify2));
+		for (auto param : {ID::T_RISE_MIN, ID::T_RISE_TYP, ID::T_RISE_MAX, ID::T_FALL_MIN, ID::T_FALL_TYP, ID::T_FALL_MAX})
+			cell->setParam(param, it.second);
+		cell->setParam(ID::FULL, false);
+		cell->setParam(ID::SRC_WIDTH, 1);
+		cell->setParam(ID::DST_WIDTH, 1);
+		cell->setParam(ID::SRC_DST_PEN, false);
+		cell->setParam(ID::SRC_DST_POL, false);
+		cell->setPort(ID::EN, State::S1);
+		cell->setPort(ID::SRC, it.first);
+		cell->setPort(ID::DST, y);
+	}
+}
+
+static uint32_t next_random(uint32_t &seed)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+class KernelStaTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		// The ID:: constants used for the cell ports are only valid after setup
+		yosys_setup();
+	}
+};
+
+TEST_F(KernelStaTest, chain)
+{
+	RTLIL::Design design;
+	add_gate_type(&design, ID(gate), 3, 5);
+
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *i = module->addWire(ID(i));
+	RTLIL::Wire *w = module->addWire(ID(w));
+	RTLIL::Wire *o = module->addWire(ID(o));
+	i->port_input = true;
+	o->port_output = true;
+	module->fixup_ports();
+
+	RTLIL::Cell *g1 = module->addCell(ID(g1), ID(gate));
+	g1->setPort(ID::A, i);
+	g1->setPort(ID::B, i);
+	g1->setPort(ID::Y, w);
+	RTLIL::Cell *g2 = module->addCell(ID(g2), ID(gate));
+	g2->setPort(ID::A, w);
+	g2->setPort(ID::B, i);
+	g2->setPort(ID::Y, o);
+
+	StaEngine sta(module);
+	EXPECT_EQ(sta.arrival(i), 0);
+	EXPECT_EQ(sta.arrival(w), 5);
+	EXPECT_EQ(sta.arrival(o), 8);
+
+	int arrival;
+	EXPECT_EQ(sta.critical_bit(&arrival), RTLIL::SigBit(o));
+	EXPECT_EQ(arrival, 8);
+
+	auto path = sta.critical_path(o);
+	ASSERT_EQ(GetSize(path), 3);
+	EXPECT_EQ(path[0].driver, g2);
+	EXPECT_EQ(path[0].src_port, ID::A);
+	EXPECT_EQ(path[1].driver, g1);
+	EXPECT_EQ(path[1].src_port, ID::B);
+	EXPECT_EQ(path[2].driver, nullptr);
+	EXPECT_EQ(path[2].bit, RTLIL::SigBit(i));
+
+	// Edits are picked up by the monitor
+	g2->setPort(ID::A, i);
+	g2->setPort(ID::B, w);
+	EXPECT_EQ(sta.arrival(o), 10);
+	module->remove(g1);
+	EXPECT_EQ(sta.arrival(w), -1);
+	EXPECT_EQ(sta.arrival(o), 3);
+	EXPECT_FALSE(sta.driven(w));
+
+	// Renaming is not reported to monitors, and must not lose the arcs of
+	// a cell that is waiting for the next update
+	g2->setPort(ID::B, i);
+	module->rename(g2, ID(g2_renamed));
+	EXPECT_EQ(sta.arrival(o), 5);
+	EXPECT_TRUE(sta.driven(o));
+
+	// A combinational loop is reported, but doesn't hang the analysis
+	g2->setPort(ID::A, o);
+	EXPECT_TRUE(sta.has_loops());
+	EXPECT_EQ(sta.arrival(o), -1);
+}
+
+TEST_F(KernelStaTest, incremental)
+{
+	RTLIL::Design design;
+	add_gate_type(&design, ID(gate1), 1, 2);
+	add_gate_type(&design, ID(gate2), 4, 1);
+
+	const int num_inputs = 4, num_cells = 60;
+	RTLIL::Module *module = design.addModule(ID(top));
+	std::vector<RTLIL::Wire*> wires;
+	for (int i = 0; i < num_inputs + num_cells; i++) {
+		RTLIL::Wire *wire = module->addWire(stringf("\\w%d", i));
+		wire->port_input = i < num_inputs;
+		wire->port_output = i >= num_inputs + num_cells - 4;
+		wires.push_back(wire);
+	}
+	module->fixup_ports();
+
+	// Cell k drives wire num_inputs+k from lower numbered wires, so that
+	// the netlist stays acyclic under the edits below.
+	uint32_t seed = 1;
+	std::vector<RTLIL::Cell*> cells;
+	for (int k = 0; k < num_cells; k++) {
+		int out = num_inputs + k;
+		RTLIL::Cell *cell = module->addCell(stringf("\\c%d", k), next_random(seed) % 2 ? ID(gate1) : ID(gate2));
+		cell->setPort(ID::A, wires[next_random(seed) % out]);
+		cell->setPort(ID::B, wires[next_random(seed) % out]);
+		cell->setPort(ID::Y, wires[out]);
+		cells.push_back(cell);
+	}
+
+	StaEngine sta(module);
+	sta.update();
+
+	for (int iter = 0; iter < 200; iter++) {
+		int k = next_random(seed) % num_cells;
+		int out = num_inputs + k;
+		if (cells[k] == nullptr) {
+			cells[k] = module->addCell(stringf("\\c%d", k), ID(gate1));
+			cells[k]->setPort(ID::A, wires[next_random(seed) % out]);
+			cells[k]->setPort(ID::B, wires[next_random(seed) % out]);
+			cells[k]->setPort(ID::Y, wires[out]);
+		} else if (next_random(seed) % 8 == 0) {
+			module->remove(cells[k]);
+			cells[k] = nullptr;
+		} else {
+			cells[k]->setPort(next_random(seed) % 2 ? ID::A : ID::B, wires[next_random(seed) % out]);
+		}
+
+		if (iter % 5 != 0)
+			continue;
+
+		StaEngine reference(module);
+		for (auto wire : wires)
+			EXPECT_EQ(sta.arrival(wire), reference.arrival(wire));
+		int arrival, reference_arrival;
+		sta.critical_bit(&arrival);
+		reference.critical_bit(&reference_arrival);
+		EXPECT_EQ(arrival, reference_arrival);
+	}
+}
+
+YOSYS_NAMESPACE_END
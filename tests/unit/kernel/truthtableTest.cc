@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/truthtable.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+static TruthTable random_table(int num_vars, uint32_t &seed)
+{
+	TruthTable result(num_vars);
+	for (int i = 0; i < result.num_bits(); i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		result.set(i, seed & 1);
+	}
+	return result;
+}
+
+TEST(KernelTruthTableTest, constAndVars)
+{
+	for (int num_vars = 0; num_vars <= 8; num_vars++) {
+		EXPECT_TRUE(TruthTable(num_vars, false).is_const0());
+		EXPECT_TRUE(TruthTable(num_vars, true).is_const1());
+		EXPECT_EQ(TruthTable(num_vars, true).count_ones(), 1 << num_vars);
+		for (int var = 0; var < num_vars; var++) {
+			TruthTable t = TruthTable::var(num_vars, var);
+			for (int i = 0; i < t.num_bits(); i++)
+				EXPECT_EQ(t.get(i), ((i >> var) & 1) != 0);
+			EXPECT_EQ(t.support(), std::vector<int>{var});
+		}
+	}
+}
+
+TEST(KernelTruthTableTest, constRoundTrip)
+{
+	uint32_t seed = 1;
+	for (int num_vars = 0; num_vars <= 8; num_vars++) {
+		TruthTable t = random_table(num_vars, seed);
+		RTLIL::Const c = t.to_const();
+		EXPECT_EQ(GetSize(c), 1 << num_vars);
+		EXPECT_EQ(TruthTable::from_const(c, num_vars), t);
+		EXPECT_EQ(c.as_string(), t.as_string());
+	}
+}
+
+TEST(KernelTruthTableTest, cofactorFlipSwap)
+{
+	uint32_t seed = 2;
+	for (int num_vars = 1; num_vars <= 8; num_vars++) {
+		TruthTable t = random_table(num_vars, seed);
+		for (int var = 0; var < num_vars; var++) {
+			TruthTable c0 = t.cofactor0(var), c1 = t.cofactor1(var);
+			TruthTable flipped = t;
+			flipped.flip(var);
+			for (int i = 0; i < t.num_bits(); i++) {
+				EXPECT_EQ(c0.get(i), t.get(i & ~(1 << var)));
+				EXPECT_EQ(c1.get(i), t.get(i | (1 << var)));
+				EXPECT_EQ(flipped.get(i), t.get(i ^ (1 << var)));
+			}
+			EXPECT_FALSE(c0.depends_on(var));
+			EXPECT_EQ(t.depends_on(var), c0 != c1);
+
+			for (int var2 = 0; var2 < num_vars; var2++) {
+				TruthTable swapped = t;
+				swapped.swap(var, var2);
+				for (int i = 0; i < t.num_bits(); i++) {
+					int b1 = (i >> var) & 1, b2 = (i >> var2) & 1;
+					int j = (i & ~(1 << var) & ~(1 << var2)) | (b1 << var2) | (b2 << var);
+					EXPECT_EQ(swapped.get(i), t.get(j));
+				}
+			}
+		}
+	}
+}
+
+TEST(KernelTruthTableTest, fromLut)
+{
+	// A 3-input LUT computing a ^ (b & c), driven by x0 & x1, x2, ~x0.
+	RTLIL::Const table(State::S0, 8);
+	for (int i = 0; i < 8; i++)
+		table.bits[i] = ((i & 1) ^ ((i >> 1) & (i >> 2) & 1)) ? State::S1 : State::S0;
+
+	std::vector<TruthTable> inputs = {
+		TruthTable::var(3, 0) & TruthTable::var(3, 1),
+		TruthTable::var(3, 2),
+		~TruthTable::var(3, 0)
+	};
+	TruthTable t = TruthTable::from_lut(table, inputs, 3);
+	for (int i = 0; i < 8; i++) {
+		bool x0 = i & 1, x1 = (i >> 1) & 1, x2 = (i >> 2) & 1;
+		EXPECT_EQ(t.get(i), (x0 && x1) ^ (x2 && !x0));
+	}
+
+	EXPECT_TRUE(TruthTable::from_lut(table, {TruthTable(2, false), TruthTable(2, true), TruthTable(2, true)}, 2).is_const1());
+}
+
+TEST(KernelTruthTableTest, npnCanonical)
+{
+	uint32_t seed = 3;
+	for (int num_vars : {1, 2, 3, 4, 5, 6, 8}) {
+		for (int k = 0; k < 4; k++) {
+			TruthTable t = random_table(num_vars, seed);
+			NpnTransform transform;
+			TruthTable canonical = t.npn_canonical(&transform);
+			EXPECT_EQ(transform.apply(t), canonical);
+
+			// Any NPN transformation of t must have the same canonical
+			// form, at least where the search is exact.
+			TruthTable u = ~t;
+			u.flip(0);
+			u.swap(0, num_vars - 1);
+			if (num_vars <= 6) {
+				EXPECT_EQ(u.npn_canonical(), canonical);
+			}
+		}
+	}
+}
+
+YOSYS_NAMESPACE_END
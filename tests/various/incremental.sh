@@ -0,0 +1,81 @@
+#!/bin/bash
+set -ex
+
+rm -rf incremental_cache
+cat > incremental_1.v <<VEOF
+module incr_sub(input [7:0] a, b, output [7:0] y);
+	assign y = a + b;
+endmodule
+module incr_top(input [7:0] a, b, c, output [7:0] y);
+	wire [7:0] t;
+	incr_sub s(a, b, t);
+	assign y = t ^ c;
+endmodule
+VEOF
+sed 's/t ^ c/t \& c/' incremental_1.v > incremental_2.v
+
+run() {
+	../../yosys -p "read_verilog $1; hierarchy -top incr_top; incremental -dir incremental_cache \"proc; opt; techmap; opt\"; write_rtlil $2" > $2.log
+}
+
+run incremental_1.v incremental_a.il
+grep -q "Found 0 of 2 modules in the cache" incremental_a.il.log
+run incremental_1.v incremental_b.il
+grep -q "Found 2 of 2 modules in the cache" incremental_b.il.log
+diff <(grep -v autoidx incremental_a.il) <(grep -v autoidx incremental_b.il)
+run incremental_2.v incremental_c.il
+grep -q "Found 1 of 2 modules in the cache" incremental_c.il.log
+grep -q '$_AND_' incremental_c.il
+
+# Two $paramod modules with identical bodies must not share a cache entry
+sub_module() {
+	cat <<EOT
+module $1
+  wire width 2 input 1 \a
+  wire width 2 output 2 \y
+  wire width 2 \$t
+  cell \$not \$n
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 2
+    parameter \Y_WIDTH 2
+    connect \A \a
+    connect \Y \$t
+  end
+  connect \y \$t
+end
+EOT
+}
+{
+	sub_module '$paramod\incr_sub\P=1'
+	sub_module '$paramod\incr_sub\P=2'
+	cat <<EOT
+module \incr_top
+  wire width 2 input 1 \a
+  wire width 2 output 2 \y1
+  wire width 2 output 3 \y2
+  cell \$paramod\incr_sub\P=1 \s1
+    connect \a \a
+    connect \y \y1
+  end
+  cell \$paramod\incr_sub\P=2 \s2
+    connect \a \a
+    connect \y \y2
+  end
+end
+EOT
+} > incremental_3.il
+
+run_il() {
+	../../yosys -p "read_rtlil incremental_3.il; incremental -dir incremental_cache \"opt; simplemap\"; hierarchy -check; write_rtlil $1" > $1.log
+}
+
+rm -rf incremental_cache
+run_il incremental_d.il
+grep -q "Found 0 of 3 modules in the cache" incremental_d.il.log
+run_il incremental_e.il
+grep -q "Found 3 of 3 modules in the cache" incremental_e.il.log
+diff <(grep -v autoidx incremental_d.il) <(grep -v autoidx incremental_e.il)
+grep -qF 'module $paramod\incr_sub\P=1' incremental_e.il
+grep -qF 'module $paramod\incr_sub\P=2' incremental_e.il
+
+rm -rf incremental_cache incremental_[12].v incremental_3.il incremental_[abcde].il*
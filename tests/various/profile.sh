@@ -0,0 +1,61 @@
+#!/bin/bash
+set -ex
+../../yosys -q -J profile.json -p 'read_verilog profile.v; hierarchy -top profile_top; proc; opt; stat'
+python3 -c '
+import json
+trace = json.load(open("profile.json"))
+events = trace["traceEvents"]
+names = [ev["name"] for ev in events]
+for name in ["read_verilog", "hierarchy", "proc", "opt", "opt_expr", "opt_clean", "stat", "profile_top", "profile_sub"]:
+	assert name in names, name
+for ev in events:
+	assert ev["ph"] == "X" and ev["dur"] >= 0
+	if ev["cat"] == "pass" and ev["name"] == "opt":
+		assert ev["args"]["cells_after"] <= ev["args"]["cells_before"]
+'
+rm -f profile.json
+
+# Passes run on a separate design (here by "incremental") count the objects
+# of that design, not of the global design. The work design of incremental
+# only contains "small", the whitebox module "big" stays in the global design.
+cat > profile_incr.il <<EOT
+attribute \whitebox 1
+module \big
+  wire input 1 \a
+  wire output 2 \y
+  wire \t1
+  wire \t2
+  cell \$_NOT_ \n1
+    connect \A \a
+    connect \Y \t1
+  end
+  cell \$_NOT_ \n2
+    connect \A \t1
+    connect \Y \t2
+  end
+  cell \$_NOT_ \n3
+    connect \A \t2
+    connect \Y \y
+  end
+end
+module \small
+  wire input 1 \a
+  wire output 2 \y
+  cell \$_NOT_ \n1
+    connect \A \a
+    connect \Y \y
+  end
+end
+EOT
+rm -rf profile_cache
+../../yosys -q -J profile.json -p 'read_rtlil profile_incr.il; incremental -dir profile_cache opt_clean'
+python3 -c '
+import json
+events = json.load(open("profile.json"))["traceEvents"]
+opt_clean = [ev for ev in events if ev["cat"] == "pass" and ev["name"] == "opt_clean"]
+assert len(opt_clean) == 1
+assert opt_clean[0]["args"]["cells_before"] == 1, opt_clean[0]["args"]
+incremental = [ev for ev in events if ev["cat"] == "pass" and ev["name"] == "incremental"]
+assert incremental[0]["args"]["cells_before"] == 4, incremental[0]["args"]
+'
+rm -rf profile.json profile_incr.il profile_cache
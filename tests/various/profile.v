@@ -0,0 +1,10 @@
+module profile_sub(input [3:0] a, b, output [3:0] y);
+	assign y = (a & b) | (a & 4'b0000);
+endmodule
+
+module profile_top(input clk, input [3:0] a, b, output reg [3:0] q);
+	wire [3:0] y;
+	profile_sub sub(.a(a), .b(b), .y(y));
+	always @(posedge clk)
+		q <= y;
+endmodule